@@ -0,0 +1,73 @@
+
+
+Texture2D       txSprite    : register( t0 );
+SamplerState    samLinear   : register( s0 );
+
+//--------------------------------------------------------------------------------------
+// Constant Buffer Variables
+//--------------------------------------------------------------------------------------
+cbuffer ConstantBuffer0 : register( b0 )
+{
+    matrix View;
+    matrix Projection;
+}
+
+//--------------------------------------------------------------------------------------
+// Per-vertex data is a single normalized quad (0.0f->1.0f) shared by all sprites.
+// Everything else is per-instance, see SpriteInstance in SpriteBatch.h.
+//
+struct VS_INPUT
+{
+    float2 Pos      : POSITION;
+    float2 UV       : TEXCOORD0;
+    float2 WorldPos : WORLDPOS;
+    float2 Size     : SIZE;
+    float4 UVRect   : UVRECT;       // in pixels: xy = top-left, zw = bottom-right
+    float4 Tint     : COLOR;
+};
+
+//--------------------------------------------------------------------------------------
+struct VS_OUTPUT
+{
+    float4 Pos      : SV_POSITION;
+    float4 Color    : COLOR;
+    float2 UV       : TEXCOORD0;
+};
+
+//--------------------------------------------------------------------------------------
+// Vertex Shader
+//--------------------------------------------------------------------------------------
+// Positioning matches Sprite.fx: the quad's origin is displaced by half a tile from the
+// sprite's world position.
+//
+VS_OUTPUT VS( VS_INPUT input )
+{
+    VS_OUTPUT outp;
+
+    float2 disp_xy = input.WorldPos - 0.5f;
+
+    outp.Pos     = float4(input.Pos * input.Size, 1.0f, 1.0f);
+    outp.Pos.xy += disp_xy;
+    outp.Pos.y  *= -1.0f;       // +Y is UP!
+    outp.Pos     = mul( outp.Pos, View );
+    outp.Pos     = mul( outp.Pos, Projection );
+    outp.Color   = input.Tint;
+
+    float2 texSize;
+    float  iggy;
+    txSprite.GetDimensions(0, texSize.x, texSize.y, iggy);
+
+    // UV rect is pixels -- scale according to texture size
+    outp.UV      = lerp(input.UVRect.xy, input.UVRect.zw, input.UV) / texSize;
+
+    return outp;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Pixel Shader
+//--------------------------------------------------------------------------------------
+float4 PS( VS_OUTPUT input ) : SV_Target
+{
+    return txSprite.Sample( samLinear, input.UV ) * input.Color;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "x-types.h"
+#include "x-thread.h"
+
+// --------------------------------------------------------------------------------------
+//  xWorkerPool
+// --------------------------------------------------------------------------------------
+// Fixed pool of worker threads for fork/join style data parallelism.  ParallelFor() splits an
+// index range into chunks which are pulled from a shared atomic counter by the workers and by
+// the calling thread, which participates rather than sleeping.  ParallelFor() does not return
+// until every chunk has completed and every worker has released the job, so consecutive calls
+// act as a full barrier between phases.
+//
+// Only one thread may issue ParallelFor() at a time (typically the SceneProducer), and nesting
+// is not supported -- calling ParallelFor() from within a chunk runs the inner range inline.
+//
+// Chunks should be reasonably coarse: each ParallelFor() has to wake and then join workers, so very
+// small ranges (count <= grainSize) are run inline on the caller without involving the pool at all.
+//
+
+typedef void xParallelForFn(void* userdata, int begin, int end);
+
+// --------------------------------------------------------------------------------------
+//  xSpinLock
+// --------------------------------------------------------------------------------------
+// For protecting very short critical sections (a push_back into a queue, etc) which may be
+// contended by pool workers.  Zero-initialized state is valid, so it can be embedded into
+// global structs without any Create() step.
+//
+class xSpinLock
+{
+protected:
+    volatile s32    m_lock = 0;
+
+public:
+    __ai void Lock() {
+        while (AtomicCompareExchange(m_lock, 1, 0) != 0) {
+            i_pause();
+        }
+    }
+
+    __ai void Unlock() {
+        AtomicExchange(m_lock, 0);
+    }
+};
+
+class xScopedSpinLock
+{
+protected:
+    xSpinLock&      m_lock;
+
+public:
+    __ai xScopedSpinLock(xSpinLock& lock) : m_lock(lock) {
+        m_lock.Lock();
+    }
+
+    __ai ~xScopedSpinLock() throw() {
+        m_lock.Unlock();
+    }
+};
+
+class xWorkerPool
+{
+    NONCOPYABLE_OBJECT( xWorkerPool );
+
+public:
+    struct JobInfo
+    {
+        xParallelForFn*     func;
+        void*               userdata;
+        int                 count;
+        int                 grainSize;
+        volatile s32        nextIndex;
+    };
+
+protected:
+    thread_t*           m_threads       = nullptr;
+    int                 m_numWorkers    = 0;
+    bool                m_initialized   = false;    // also set for zero-worker pools, which own no threads
+    volatile s32        m_exiting       = 0;
+    JobInfo             m_job;
+    xSemaphore          m_sem_wake;
+    xSemaphore          m_sem_done;
+
+public:
+    xWorkerPool() { }
+
+    void        Init            (int numWorkers = -1);
+    void        Shutdown        ();
+    void        ParallelFor     (int count, int grainSize, xParallelForFn* func, void* userdata);
+
+    __ai int    GetWorkerCount  () const { return m_numWorkers; }
+
+    template< typename T >
+    void ParallelFor(int count, int grainSize, T&& func) {
+        ParallelFor(count, grainSize, [](void* userdata, int begin, int end) {
+            (*(std::remove_reference_t<T>*)userdata)(begin, end);
+        }, (void*)&func);
+    }
+
+protected:
+    static void*    WorkerThreadProc    (void* param);
+    static void     RunJobChunks        (JobInfo& job);
+};
+
+extern xWorkerPool      g_WorkerPool;
+
+extern bool             xWorkerPool_InParallelRegion    ();
+extern int              xWorkerPool_GetThreadIndex      ();
@@ -0,0 +1,143 @@
+#include "PCH-framework.h"
+#include "x-workers.h"
+
+#include <thread>
+#include <algorithm>
+
+static const int        MaxWorkerThreads = 16;
+
+// names are passed by pointer to the thread creation API and must remain valid for the
+// lifetime of the thread.
+static const char* s_worker_names[MaxWorkerThreads] = {
+    "Worker00", "Worker01", "Worker02", "Worker03", "Worker04", "Worker05", "Worker06", "Worker07",
+    "Worker08", "Worker09", "Worker10", "Worker11", "Worker12", "Worker13", "Worker14", "Worker15",
+};
+
+xWorkerPool             g_WorkerPool;
+
+static volatile s32     s_worker_index_counter  = 0;
+static __threadlocal int s_thread_index         = 0;        // 0 = non-worker thread
+static __threadlocal int s_parallel_depth       = 0;
+
+bool xWorkerPool_InParallelRegion()
+{
+    return s_parallel_depth > 0;
+}
+
+// Returns 0 for the thread which issued the ParallelFor (or any non-worker thread),
+// and 1..GetWorkerCount() for pool workers.
+int xWorkerPool_GetThreadIndex()
+{
+    return s_thread_index;
+}
+
+void xWorkerPool::RunJobChunks(JobInfo& job)
+{
+    s_parallel_depth += 1;
+    for(;;) {
+        s32 begin = AtomicExchangeAdd(job.nextIndex, job.grainSize);
+        if (begin >= job.count) break;
+        int end = std::min(begin + job.grainSize, job.count);
+        job.func(job.userdata, begin, end);
+    }
+    s_parallel_depth -= 1;
+}
+
+void* xWorkerPool::WorkerThreadProc(void* param)
+{
+    auto& pool = *(xWorkerPool*)param;
+    s_thread_index = AtomicInc(s_worker_index_counter);
+
+    for(;;) {
+        pool.m_sem_wake.Wait();
+        if (pool.m_exiting) break;
+        RunJobChunks(pool.m_job);
+        pool.m_sem_done.Post();
+    }
+    return nullptr;
+}
+
+// numWorkers < 0 picks a count based on hardware concurrency, leaving one core for the
+// calling thread (which participates in all jobs).  Zero is valid and runs all jobs inline.
+void xWorkerPool::Init(int numWorkers)
+{
+    if (m_initialized) return;
+    m_initialized = true;
+
+    if (numWorkers < 0) {
+        numWorkers = std::max(0, int(std::thread::hardware_concurrency()) - 1);
+    }
+    m_numWorkers = std::min(numWorkers, MaxWorkerThreads);
+    m_exiting    = 0;
+
+    m_sem_wake.Create();
+    m_sem_done.Create();
+
+    if (!m_numWorkers) return;
+
+    m_threads = (thread_t*)xMalloc(sizeof(thread_t) * m_numWorkers);
+    for (int i=0; i<m_numWorkers; ++i) {
+        thread_create(m_threads[i], WorkerThreadProc, s_worker_names[i], _128kb, this);
+    }
+    log_host("WorkerPool: started %d worker threads.", m_numWorkers);
+}
+
+void xWorkerPool::Shutdown()
+{
+    if (!m_initialized) return;
+
+    if (m_threads) {
+        AtomicExchange(m_exiting, 1);
+        for (int i=0; i<m_numWorkers; ++i) {
+            m_sem_wake.Post();
+        }
+        for (int i=0; i<m_numWorkers; ++i) {
+            thread_join(m_threads[i]);
+        }
+        xFree(m_threads);
+    }
+
+    m_sem_wake.Delete();
+    m_sem_done.Delete();
+
+    m_threads       = nullptr;
+    m_numWorkers    = 0;
+    m_initialized   = false;
+}
+
+void xWorkerPool::ParallelFor(int count, int grainSize, xParallelForFn* func, void* userdata)
+{
+    if (count <= 0) return;
+    if (grainSize < 1) grainSize = 1;
+
+    int numChunks = (count + grainSize - 1) / grainSize;
+
+    if (!m_numWorkers || numChunks == 1 || s_parallel_depth) {
+        // still counts as a parallel region, so that thread-safety assertions fire consistently
+        // regardless of how the work happened to be scheduled.
+        s_parallel_depth += 1;
+        func(userdata, 0, count);
+        s_parallel_depth -= 1;
+        return;
+    }
+
+    m_job.func      = func;
+    m_job.userdata  = userdata;
+    m_job.count     = count;
+    m_job.grainSize = grainSize;
+    m_job.nextIndex = 0;
+
+    // the caller takes a share of the chunks, so only wake as many workers as can be kept busy.
+    // Every woken worker posts m_sem_done exactly once, which guarantees none of them are still
+    // referencing m_job when we return.
+    int numWake = std::min(m_numWorkers, numChunks - 1);
+    for (int i=0; i<numWake; ++i) {
+        m_sem_wake.Post();
+    }
+
+    RunJobChunks(m_job);
+
+    for (int i=0; i<numWake; ++i) {
+        m_sem_done.Wait();
+    }
+}
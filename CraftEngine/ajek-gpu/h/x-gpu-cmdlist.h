@@ -0,0 +1,127 @@
+#pragma once
+
+#include "x-types.h"
+#include "x-gpu-ifc.h"
+
+#include <vector>
+
+// --------------------------------------------------------------------------------------
+//  GPU_CommandList
+// --------------------------------------------------------------------------------------
+// Deferred recording of pipeline binds and draws.  Each method mirrors its dx11_* counterpart in
+// x-gpu-ifc.h, but only appends a command to the list -- recording never touches the device or the
+// driver context, so any thread (typically a worker inside g_WorkerPool.ParallelFor) may record into
+// a list it owns.  Execute() or GPU_ExecuteCommandLists() later replays the commands on the render
+// thread, in recorded order.
+//
+// Lifetime:
+//   Resources (shaders, layouts, buffers, textures) are recorded by reference and must remain valid
+//   until the list is executed.  Data passed to UpdateConstantBuffer(), BindConstants(),
+//   SetTransientVertexBuffer() and UploadDynamicBufferData() is copied into the list at record time,
+//   so sources may be transient.
+//
+// Constants:
+//   BindConstants() is preferred over UpdateConstantBuffer() + BindConstantBuffer() for per-draw
+//   constants.  At execution it reserves a slice of the backend's per-frame constant ring, copies
+//   the recorded constants into it and binds the slice -- no constant buffer object is needed, and
+//   the backend doesn't have to update a buffer which may still be in use by the GPU.
+//
+// Transient Vertices:
+//   SetTransientVertexBuffer() is the vertex data equivalent: at execution the recorded data is copied
+//   into the backend's per-frame upload heap and bound by offset.  Prefer it over a GPU_DynVsBuffer for
+//   data rebuilt every frame, since there's no buffer to size up front or to grow.
+//
+// Ordering:
+//   Lists have no ordering relative to each other other than the order they're handed to
+//   GPU_ExecuteCommandLists().  For deterministic output, assign one list per unit of work (one per
+//   tilemap layer, etc) rather than one per worker thread, and execute them in a fixed order.
+//
+// Thread Safety:
+//   A single list must only be recorded by one thread at a time.  Execution is render thread only.
+//
+
+enum GPU_CommandOp : u8
+{
+    GPU_Cmd_SetInputLayout,
+    GPU_Cmd_SetRasterState,
+    GPU_Cmd_SetPrimType,
+    GPU_Cmd_BindShaderVS,
+    GPU_Cmd_BindShaderFS,
+    GPU_Cmd_BindConstantBuffer,
+    GPU_Cmd_BindConstants,
+    GPU_Cmd_BindShaderResource,
+    GPU_Cmd_SetVertexBufferDyn,
+    GPU_Cmd_SetVertexBuffer,
+    GPU_Cmd_SetTransientVertexBuffer,
+    GPU_Cmd_SetIndexBuffer,
+    GPU_Cmd_UpdateConstantBuffer,
+    GPU_Cmd_UploadDynamicBufferData,
+    GPU_Cmd_Draw,
+    GPU_Cmd_DrawIndexed,
+    GPU_Cmd_DrawInstanced,
+    GPU_Cmd_DrawIndexedInstanced,
+};
+
+struct GPU_Command
+{
+    GPU_CommandOp   op;
+    const void*     res;            // resource the command operates on, if any
+    s32             args[5];        // op-specific; inline data is referenced by offset and size
+};
+
+class GPU_CommandList
+{
+    NONCOPYABLE_OBJECT(GPU_CommandList);
+
+protected:
+    std::vector<GPU_Command>    m_cmds;
+    std::vector<u8>             m_data;
+
+public:
+    GPU_CommandList() {}
+
+    void    Reset                   ();
+    bool    IsEmpty                 () const    { return m_cmds.empty(); }
+    int     GetCommandCount         () const    { return (int)m_cmds.size(); }
+    int     GetDataSize             () const    { return (int)m_data.size(); }
+
+    void    SetInputLayout          (const GPU_InputDesc& layout);
+    void    SetRasterState          (GpuRasterFillMode fill, GpuRasterCullMode cull, GpuRasterScissorMode scissor);
+    void    SetPrimType             (GpuPrimitiveType primType);
+
+    void    BindShaderVS            (const GPU_ShaderVS& vs);
+    void    BindShaderFS            (const GPU_ShaderFS& fs);
+    void    BindConstantBuffer      (const GPU_ConstantBuffer& buffer, int startSlot);
+    void    BindConstants           (const void* data, int sizeInBytes, int startSlot);
+    void    BindShaderResource      (const GPU_ShaderResource& res, int startSlot=0);
+    void    SetVertexBuffer         (const GPU_DynVsBuffer&  vbuffer, int shaderSlot, int _stride, int _offset);
+    void    SetVertexBuffer         (const GPU_VertexBuffer& vbuffer, int shaderSlot, int _stride, int _offset);
+    void    SetTransientVertexBuffer(const void* srcData, int sizeInBytes, int shaderSlot, int _stride);
+    void    SetIndexBuffer          (const GPU_IndexBuffer& indexBuffer, int bitsPerIndex, int offset);
+
+    void    UpdateConstantBuffer    (const GPU_ConstantBuffer& buffer, const void* data, int sizeInBytes);
+    void    UploadDynamicBufferData (const GPU_DynVsBuffer& buffer, const void* srcData, int sizeInBytes);
+
+    void    Draw                    (int indexCount, int startVertLoc);
+    void    DrawIndexed             (int indexCount, int startIndexLoc, int baseVertLoc);
+    void    DrawInstanced           (int vertsPerInstance, int instanceCount, int startVertLoc, int startInstanceLoc);
+    void    DrawIndexedInstanced    (int indexesPerInstance, int instanceCount, int startIndex, int baseVertex, int startInstance);
+
+    void    Execute                 () const;
+
+    template< typename T >
+    void UpdateConstantBuffer(const GPU_ConstantBuffer& buffer, const T& data) {
+        UpdateConstantBuffer(buffer, &data, sizeof(T));
+    }
+
+    template< typename T >
+    void BindConstants(const T& data, int startSlot) {
+        BindConstants(&data, sizeof(T), startSlot);
+    }
+
+protected:
+    GPU_Command&    Append          (GPU_CommandOp op, const void* res);
+    s32             AppendData      (const void* src, int sizeInBytes);
+};
+
+extern void     GPU_ExecuteCommandLists     (const GPU_CommandList* lists, int count);
@@ -116,6 +116,18 @@ struct GPU_ConstantBuffer {
     sptr        m_driverData    = 0;        // can be either memory pointer or handle index into table (driver-dependent)
 };
 
+// Per-frame constants reserved from the backend's constant ring.  Constants are written directly
+// through 'data', which is write-only and remains valid until the slice is bound or the frame is
+// submitted.  Slices are discarded at the end of the frame; there is no release.
+struct GPU_ConstantSlice {
+    void*       data            = nullptr;
+    sptr        m_driverData    = 0;        // ring chunk the slice lives in (driver-dependent)
+    int         offset          = 0;        // in bytes, from the start of the chunk
+    int         size            = 0;        // in bytes, rounded up to a multiple of 16
+
+    bool IsValid() const { return data != nullptr; }
+};
+
 struct GPU_ShaderVS {
     sptr        m_driverBinary  = 0;        // fast-reference to shader binary
     sptr        m_driverBlob    = 0;        // slow-reference to secondary blob/debug information
@@ -126,16 +138,38 @@ struct GPU_ShaderFS {
     sptr        m_driverBlob    = 0;        // slow-reference to secondary blob/debug information
 };
 
+// Names a shader source file and the entry points which are about to be loaded from it, for
+// dx11_PrefetchShaders().  Either entry point may be nullptr.
+struct GPU_ShaderPrefetch {
+    const char* srcfile;
+    const char* entryVS;
+    const char* entryFS;
+};
+
 // Dynamic vertex buffers are multi-instanced, with one bound to each backbuffer in the swap chain.
 // This allows the GameplaySceneLogic() system to update vertex buffers without blocking against draw operations
 // being performed on the previous scene.
+//
+// Buffers created with an update interval N > 1 are sparse: they must be uploaded at least once every N frames,
+// and frames in between draw the most recent upload.  Sparse buffers rotate through fewer instances, see
+// GPU_GetDynBufferInstanceCount().  Uploading sooner than every N frames (ie, when contents change) is allowed.
+//
+// Handles come from a free-list pool with no fixed ceiling.  Re-creating a buffer through an existing handle
+// only reallocates when the new size exceeds what the handle already holds, so buffers may be grown in place.
+// Data which is rebuilt from scratch every frame should use dx11_SetTransientVertexBuffer() instead.
 struct GPU_DynVsBuffer {
     int     m_buffer_idx;
     explicit GPU_DynVsBuffer(int m_buffer_idx = -1);
 
     bool IsValid() const { return m_buffer_idx >= 0; }
+    void Dispose();
 };
 
+// Transient vertex data is copied into the backend's per-frame upload heap and bound by offset, in a single
+// dx11_SetTransientVertexBuffer() call.  Heaps belong to a back buffer and are recycled once the GPU has
+// finished with its frame, so nothing is created up front and there's no release.  Bindings are only valid
+// for the current frame.
+
 struct GPU_ShaderResource {
     sptr        m_driverData_view;
 
@@ -246,10 +280,32 @@ template< typename T, int numItems > InputLayoutSlot& GPU_InputDesc::_AddGeneric
 }
 
 
+// Per-frame pipeline counters, collected by the backend as commands reach the driver.  Binds which
+// match the backend's shadow copy of the pipeline state are dropped rather than forwarded to the
+// driver, and counted as skipped.  Draws of any kind count as one instance unless instanced.
+struct GPU_PipelineStats
+{
+    int     frame;                      // g_gpu_host_framecount of the frame the stats belong to
+    int     draws;
+    int     instances;
+    int     bindsIssued;
+    int     bindsSkipped;
+    int     constantBufferBytes;        // bytes uploaded via dx11_UpdateConstantBuffer and constant slices
+    int     dynamicBufferBytes;         // bytes uploaded via dx11_UploadDynamicBufferData
+    int     transientBufferBytes;       // bytes uploaded via dx11_SetTransientVertexBuffer
+};
+
 inline GPU_DynVsBuffer::GPU_DynVsBuffer(int idx) {
     m_buffer_idx = idx;
 }
 
+// Instances a dynamic buffer uploaded every Nth frame needs, so that an upload never overwrites an instance which
+// older frames still in flight may be reading.  An instance is read for N frames after its upload, and the GPU
+// trails the CPU by up to (backBufferCount-1) frames.  Equals backBufferCount for buffers updated every frame.
+inline int GPU_GetDynBufferInstanceCount(int backBufferCount, int updateInterval) {
+    return 1 + ((backBufferCount - 1) + (updateInterval - 1)) / updateInterval;
+}
+
 inline GPU_RenderTarget::GPU_RenderTarget(const void* driverData) {
     m_driverData = (s64)driverData;
 }
@@ -260,7 +316,7 @@ extern void                 dx11_CleanupDevice              ();
 extern void                 dx11_NewFrame                   ();
 extern void                 dx11_BeginFrameDrawing          ();
 extern void                 dx11_SubmitFrameAndSwap         ();
-extern void                 dx11_CreateDynamicVertexBuffer  (GPU_DynVsBuffer& dest, int bufferSizeInBytes, const char* diag_name=nullptr);
+extern void                 dx11_CreateDynamicVertexBuffer  (GPU_DynVsBuffer& dest, int bufferSizeInBytes, const char* diag_name=nullptr, int updateInterval=1);
 extern void                 dx11_CreateStaticMesh           (GPU_VertexBuffer&  dest, void* vertexData, int itemSizeInBytes, int vertexCount);
 extern void                 dx11_CreateIndexBuffer          (GPU_IndexBuffer&   dest, void* indexBuffer, int bufferSize);
 extern void                 dx11_CreateConstantBuffer       (GPU_ConstantBuffer& dest, int bufferSize);
@@ -269,20 +325,24 @@ extern void                 dx11_CreateTexture2D            (GPU_TextureResource
 extern void                 dx11_CreateTexture2D            (GPU_TextureResource2D& dest, const void* src_bitmap_data, int width, int height, GPU_ResourceFmt format);
 extern void                 dx11_UploadDynamicBufferData    (const GPU_DynVsBuffer& bufferIdx, const void* srcData, int sizeInBytes);
 extern void                 dx11_UpdateConstantBuffer       (const GPU_ConstantBuffer& buffer, const void* data);
+extern GPU_ConstantSlice    dx11_ReserveConstants           (int sizeInBytes);
 
 extern bool                 dx11_TryLoadShaderVS            (GPU_ShaderVS& dest, const xString& srcfile, const char* entryPointFn);
 extern bool                 dx11_TryLoadShaderFS            (GPU_ShaderFS& dest, const xString& srcfile, const char* entryPointFn);
 extern void                 dx11_LoadShaderVS               (GPU_ShaderVS& dest, const xString& srcfile, const char* entryPointFn);
 extern void                 dx11_LoadShaderFS               (GPU_ShaderFS& dest, const xString& srcfile, const char* entryPointFn);
+extern void                 dx11_PrefetchShaders            (const GPU_ShaderPrefetch* shaders, int count);
 extern void                 dx11_SetInputLayout             (const GPU_InputDesc& layout);
 extern void                 dx11_SetRasterState             (GpuRasterFillMode fill, GpuRasterCullMode cull, GpuRasterScissorMode scissor);
 
 extern void                 dx11_BindConstantBuffer         (const GPU_ConstantBuffer& buffer, int startSlot);
+extern void                 dx11_BindConstantSlice          (const GPU_ConstantSlice& slice, int startSlot);
 extern void                 dx11_BindShaderResource         (const GPU_ShaderResource& res, int startSlot=0);
 extern void                 dx11_BindShaderVS               (const GPU_ShaderVS& vs);
 extern void                 dx11_BindShaderFS               (const GPU_ShaderFS& fs);
 extern void                 dx11_SetVertexBuffer            (const GPU_DynVsBuffer&  vbuffer, int shaderSlot, int _stride, int _offset);
 extern void                 dx11_SetVertexBuffer            (const GPU_VertexBuffer& vbuffer, int shaderSlot, int _stride, int _offset);
+extern void                 dx11_SetTransientVertexBuffer   (const void* srcData, int sizeInBytes, int shaderSlot, int _stride);
 extern void                 dx11_SetIndexBuffer             (const GPU_IndexBuffer& indexBuffer, int bitsPerIndex, int offset);
 extern void                 dx11_SetPrimType                (GpuPrimitiveType primType);
 
@@ -293,6 +353,7 @@ extern void                 dx11_DrawIndexedInstanced       (int indexesPerInsta
 extern void                 dx11_Draw                       (int indexCount, int startVertLoc);
 
 extern void                 dx11_InputLayoutCache_DisposeAll();
+extern GPU_PipelineStats    dx11_GetPipelineStats           ();
 
 extern bool                 g_gpu_ForceWireframe;
 extern GPU_RenderTarget     g_gpu_BackBuffer;
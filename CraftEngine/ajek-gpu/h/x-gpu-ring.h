@@ -0,0 +1,55 @@
+#pragma once
+
+#include "x-types.h"
+#include "x-assertion.h"
+
+// --------------------------------------------------------------------------------------
+//  GPU_RingAllocator
+// --------------------------------------------------------------------------------------
+// Backend-neutral bookkeeping for per-frame linear allocations out of a list of fixed-size chunks.
+// Backends own the chunk storage (device buffers or host memory) and keep one allocator per back
+// buffer.  Once the fence for a back buffer has passed, Reset() makes all of its chunks available
+// again; nothing is ever freed individually.
+//
+// Allocations never straddle chunks.  When an allocation doesn't fit in what's left of the current
+// chunk, allocation moves on to the next chunk -- the backend is expected to create chunks on demand
+// when Alloc() returns an index equal to its current chunk count.
+//
+class GPU_RingAllocator
+{
+protected:
+    int     m_chunkSize     = 0;
+    int     m_alignment     = 1;
+    int     m_chunk         = 0;        // chunk currently being allocated from
+    int     m_offset        = 0;        // next free byte within m_chunk
+
+public:
+    void Init(int chunkSize, int alignment) {
+        bug_on(alignment <= 0 || (alignment & (alignment-1)), "Alignment must be a power of two.");
+        bug_on(chunkSize < alignment);
+        m_chunkSize = chunkSize;
+        m_alignment = alignment;
+        Reset();
+    }
+
+    void Reset() {
+        m_chunk     = 0;
+        m_offset    = 0;
+    }
+
+    // Returns the chunk to allocate from, and the aligned byte offset of the allocation within it.
+    int Alloc(int sizeInBytes, int& offset) {
+        bug_on(sizeInBytes <= 0 || sizeInBytes > m_chunkSize, "Invalid ring allocation size=%d", sizeInBytes);
+
+        if (m_offset + sizeInBytes > m_chunkSize) {
+            m_chunk    += 1;
+            m_offset    = 0;
+        }
+        offset      = m_offset;
+        m_offset    = (m_offset + sizeInBytes + (m_alignment-1)) & ~(m_alignment-1);
+        return m_chunk;
+    }
+
+    int GetChunkSize    () const    { return m_chunkSize; }
+    int GetChunksUsed   () const    { return m_offset ? (m_chunk + 1) : m_chunk; }
+};
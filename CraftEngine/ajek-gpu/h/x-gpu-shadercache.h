@@ -0,0 +1,60 @@
+#pragma once
+
+#include "x-types.h"
+#include "x-string.h"
+
+#include <vector>
+
+// --------------------------------------------------------------------------------------
+//  GPU_ShaderCompiler (interface)
+// --------------------------------------------------------------------------------------
+// Compiler invocation as seen by the shader cache.  Backends which compile shaders register an
+// implementation at device init; tests may register a stub afterward to stand in for the real
+// compiler.
+//
+// Compile() is called concurrently from pool workers during GPU_ShaderCache_Prefetch(), so it must
+// be thread-safe and must not throw -- failures are reported by returning false and filling errors.
+//
+// GetConfigName() is mixed into cache keys, and should identify anything other than the source
+// which changes the output (compiler version, debug/optimize flags, macros).
+//
+class GPU_ShaderCompiler
+{
+public:
+    virtual             ~GPU_ShaderCompiler () {}
+    virtual const char* GetConfigName       () const=0;
+    virtual bool        Compile             (const xString& srcfile, const char* entryPointFn, const char* profile, std::vector<u8>& bytecode, xString& errors)=0;
+};
+
+// --------------------------------------------------------------------------------------
+//  Shader Bytecode Cache
+// --------------------------------------------------------------------------------------
+// Compiled bytecode is stored under the temp dir (xGetTempDir()/shadercache), keyed by a hash of
+// the source file, every file it pulls in through #include (resolved relative to the including
+// file, as the compiler's standard include handler does), the entry point, the profile and the
+// compiler config name.  Editing any of those yields a new key, so stale entries are never used;
+// they're simply left behind and can be deleted along with the rest of the temp dir at any time.
+//
+// Fetch() is the per-shader path used by the backend's shader loaders: it returns bytecode from a
+// prior Prefetch(), else from disk, else compiles on the calling thread and stores the result.
+//
+// Prefetch() is an optional hint issued before a batch of loads (scene init): every miss in the
+// list is compiled in parallel on g_WorkerPool and held in memory until fetched.  Compile errors
+// during prefetch are not reported -- the failing shader is simply compiled again by Fetch(), which
+// reports errors through the usual channels.
+//
+// Thread Safety:
+//   Fetch() and Prefetch() are for the thread which loads shaders (scene producer) only.
+//
+
+struct GPU_ShaderCacheRequest
+{
+    xString         srcfile;
+    const char*     entryPointFn;
+    const char*     profile;
+};
+
+extern void     GPU_ShaderCache_SetCompiler     (GPU_ShaderCompiler* compiler);
+extern bool     GPU_ShaderCache_Fetch           (std::vector<u8>& dest, const xString& srcfile, const char* entryPointFn, const char* profile, xString& errors);
+extern void     GPU_ShaderCache_Prefetch        (const GPU_ShaderCacheRequest* requests, int count);
+extern void     GPU_ShaderCache_Purge           ();
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "x-types.h"
+#include "x-string.h"
+#include "x-BitmapData.h"
+
+// --------------------------------------------------------------------------------------
+//  Soft GPU Backend extras
+// --------------------------------------------------------------------------------------
+// Only available when the soft backend (ajek-gpu/src/soft) is linked in place of the msw backend.
+// The back buffer is R8G8B8A8, sized to g_client_size_pix as of dx11_InitDevice().
+//
+
+// When set, every submitted frame is written to <tempdir>/screen%d.png, the same as the DX11
+// backend does when it has no swap chain.  Off by default, since PNG encoding would otherwise
+// dominate frame-time measurements.
+extern bool             g_gpu_soft_CaptureFrames;
+
+// Finishes rasterizing anything pending and returns the back buffer.  The pointer stays valid until
+// the next draw or dx11_CleanupDevice().
+extern xBitmapDataRO    soft_GetBackBuffer          ();
+extern void             soft_SaveBackBufferToPng    (const xString& filename);
+
+// --------------------------------------------------------------------------------------
+//  Golden-image check
+// --------------------------------------------------------------------------------------
+// When g_gpu_soft_GoldenImage is set, frame g_gpu_soft_GoldenFrame is written through x_png_enc to
+// <tempdir>/golden-actual.png, decoded again, and compared against the golden PNG.  Channels may
+// differ by up to g_gpu_soft_GoldenTolerance.  If the golden PNG doesn't exist yet, the frame is
+// recorded there instead and the result is SoftGolden_Recorded -- review and commit it.
+//
+// Rendering is only reproducible when the scene is stepped at a fixed rate: pair this with the
+// fixed-frame-time-ms CLI option (see config-golden-soft.cli.txt).
+//
+enum SoftGoldenResult
+{
+    SoftGolden_Pending,         // not configured, or the frame hasn't been reached
+    SoftGolden_Match,
+    SoftGolden_Mismatch,
+    SoftGolden_Recorded,        // no golden image existed; the frame was saved as the new golden
+};
+
+extern xString          g_gpu_soft_GoldenImage;
+extern int              g_gpu_soft_GoldenFrame;
+extern int              g_gpu_soft_GoldenTolerance;
+
+extern SoftGoldenResult soft_GetGoldenResult        ();
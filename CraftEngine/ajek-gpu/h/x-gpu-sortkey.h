@@ -0,0 +1,52 @@
+#pragma once
+
+#include "x-types.h"
+#include "x-gpu-ifc.h"
+
+#include <vector>
+
+// --------------------------------------------------------------------------------------
+//  GPU_SortKey
+// --------------------------------------------------------------------------------------
+// Packs everything which decides the submission order of a draw into a single u64, so that a batch
+// of draws can be ordered with one radix sort and then walked linearly.  Bit layout, from the most
+// significant bit down:
+//
+//   opaque       [layer:4] [0] [shader:12] [layout:8] [texture:12] [depth:24] [unused:3]
+//   translucent  [layer:4] [1] [~depth:24] [shader:12] [layout:8] [texture:12] [unused:3]
+//
+// Depth follows the draw list's z-order convention: higher is farther.  Layers are drawn strictly in
+// order, and within a layer all opaque draws precede translucent ones.  Opaque draws are grouped by
+// pipeline state -- most expensive switch first -- and depth only breaks ties.  Translucent draws
+// keep strict back-to-front order (higher depth is drawn first, the same order as ForEachAlpha), so
+// their depth field is inverted; they are grouped by state only among draws sharing a depth.
+//
+// There is no depth buffer in the scene pipeline, so "opaque" here means "order-independent within
+// its layer": draws which may overlap other draws in the same layer must be submitted as translucent.
+//
+// State ids are folded hashes of the resource addresses (and the input layout hash), not registered
+// handles.  A collision only costs a state switch that could have been avoided -- consumers must
+// still compare actual state when forming runs of draws.
+//
+
+struct GPU_SortKeyDesc
+{
+    int                         layer;          // 0..15
+    bool                        translucent;
+    float                       depth;          // z-order, higher is farther; translucent draws are drawn highest first
+    const GPU_ShaderVS*         shaderVS;
+    const GPU_ShaderFS*         shaderFS;
+    const GPU_InputDesc*        layout;
+    const GPU_ShaderResource*   texture;
+};
+
+struct GPU_SortItem
+{
+    u64         key;
+    u32         index;          // caller-defined, typically an index into the draw array
+};
+
+static const int GPU_SortKey_MaxLayers = 16;
+
+extern u64      GPU_MakeSortKey     (const GPU_SortKeyDesc& desc);
+extern void     GPU_SortByKey       (std::vector<GPU_SortItem>& items, std::vector<GPU_SortItem>& scratch);
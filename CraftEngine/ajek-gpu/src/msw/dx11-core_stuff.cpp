@@ -5,9 +5,12 @@
 #include "x-stl.h"
 #include "x-string.h"
 #include "x-thread.h"
+#include "x-workers.h"
 
 #include "v-float.h"
 #include "x-gpu-ifc.h"
+#include "x-gpu-ring.h"
+#include "x-gpu-shadercache.h"
 #include "x-pad.h"          // for KPad_SetKeyboardFocus
 #include "x-ThrowContext.h"
 
@@ -116,8 +119,7 @@ struct DynBufferItem
 {
     ID3D11Buffer*           m_dx11_buffer;
     DynBufferType           m_type;
-    u8                      m_updated_this_frame;
-    char                    m_name[30];
+    char                    m_name[31];
 };
 
 // compiler may pad the struct as 4, 8, or 16 depending on architecture.
@@ -130,8 +132,41 @@ namespace _DynBufferSizeCheck {
 }
 
 
-//int                           g_DynVertBufferCount = 0;
-DynBufferItem               g_DynVertBuffers[BackBufferCount][256];
+// Upload schedule for a dynamic buffer handle, shared by all of its instances.  Buffers updated every frame use the
+// instance matching g_curBufferIdx.  Sparse buffers only allocate their first m_instances instances,
+// and move on to the next of them with each frame's first upload (see Sparse Update Scenario, below).
+struct DynBufferSchedule
+{
+    int                     m_interval;             // in frames, 1 for buffers updated every frame
+    int                     m_instances;
+    int                     m_current;              // sparse only: instance holding the most recent upload
+    int                     m_upload_frame;         // g_gpu_host_framecount of the most recent upload
+};
+
+// Dynamic buffer handles index into a pool which grows on demand.  Disposed handles are chained through
+// m_next_free and handed out again before the pool grows.  Buffers are only created while nothing is
+// rendering, so entries may move when the pool grows.
+struct DynBufferSlot
+{
+    DynBufferItem           m_instances[BackBufferCount];
+    DynBufferSchedule       m_sched;
+    int                     m_capacity;             // in bytes, of each instance
+    int                     m_next_free;            // free list link, -1 if last or in use
+};
+
+static std::vector<DynBufferSlot>   s_DynBufferPool;
+static int                          s_DynBufferFreeList = -1;
+
+static __ai int dx11_GetDynBufferInstance(int bufferIdx)
+{
+    const auto& sched = s_DynBufferPool[bufferIdx].m_sched;
+    return (sched.m_interval > 1) ? sched.m_current : g_curBufferIdx;
+}
+
+// s_current_vertex_buffers holds either managed ID3D11Buffer pointers or dynamic buffer handles.  Handles
+// are tagged in the low bit, which is never set in a pointer.
+static __ai sptr    dx11_DynHandleTag   (int bufferIdx) { return ((sptr)bufferIdx << 1) | 1; }
+static __ai bool    dx11_IsDynHandleTag (sptr bound)    { return (bound & 1) != 0; }
 
 ID3D11SamplerState*         m_pTextureSampler = nullptr;
 
@@ -280,16 +315,24 @@ bool dx11_IsManagedObject(const sptr& objptr)
 }
 
 //--------------------------------------------------------------------------------------
-// Helper for compiling shaders with D3DCompile
+// Shader compiler for the shader cache, using D3DCompile.
 // With VS 11, we could load up prebuilt .cso files instead...
 //
 // Memory Leak Warning:  On Intel Integrated GPU driver (i630) a memory leak occurs when
-// compiling shaders.  Unknown at this time if the leak is DX11 or Intel driver.
+// compiling shaders.  Unknown at this time if the leak is DX11 or Intel driver.  Cache hits never
+// invoke the compiler, which also keeps the leak out of the Heap Graph on warm starts and reloads.
 //--------------------------------------------------------------------------------------
-HRESULT TryCompileShaderFromFile(const WCHAR* szFileName, LPCSTR szEntryPoint, LPCSTR szShaderModel, ID3DBlob** ppBlobOut)
+class dx11_ShaderCompiler : public GPU_ShaderCompiler
 {
-    HRESULT hr = S_OK;
+public:
+    const char* GetConfigName() const override;
+    bool        Compile(const xString& srcfile, const char* entryPointFn, const char* profile, std::vector<u8>& bytecode, xString& errors) override;
+};
+
+static dx11_ShaderCompiler  s_dx11_ShaderCompiler;
 
+static DWORD dx11_GetShaderCompileFlags()
+{
     DWORD dwShaderFlags = D3DCOMPILE_ENABLE_STRICTNESS;
 #ifdef _DEBUG
     // Set the D3DCOMPILE_DEBUG flag to embed debug information in the shaders.
@@ -301,15 +344,29 @@ HRESULT TryCompileShaderFromFile(const WCHAR* szFileName, LPCSTR szEntryPoint, L
     // Disable optimizations to further improve shader debugging
     dwShaderFlags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
+    return dwShaderFlags;
+}
 
-    ID3DBlob* pErrorBlob = nullptr;
-    Defer( { dx11_Release(pErrorBlob); } );
+const char* dx11_ShaderCompiler::GetConfigName() const
+{
+    // Anything which changes compiler output must be reflected here, or stale bytecode will be
+    // served from the cache.  Flags cover debug/release; the compiler DLL is versioned by name.
+    static char s_name[64];
+    if (!s_name[0]) {
+        snprintf(s_name, sizeof(s_name), "%s;flags=%08x", D3DCOMPILER_DLL_A, (u32)dx11_GetShaderCompileFlags());
+    }
+    return s_name;
+}
 
+// Called from pool workers during shader prefetch -- D3DCompileFromFile is thread-safe, and errors
+// are returned rather than thrown.
+bool dx11_ShaderCompiler::Compile(const xString& srcfile, const char* entryPointFn, const char* profile, std::vector<u8>& bytecode, xString& errors)
+{
     // Note on compiler macros:
     //   Macros should match exactly what's being used to precompile shaders via the makefile.
     //   One possible way to do this is to have the project file write the active shader macro
     //   configuration into some larger macro that we process here and then pass to the runtime
-    //   compiler.
+    //   compiler.  Any such macros must also be folded into GetConfigName().
 
 #if defined(DX11_SHADER_COMPILER_MACROS)
     // DX11_SHADER_COMPILER_MACROS -
@@ -318,41 +375,58 @@ HRESULT TryCompileShaderFromFile(const WCHAR* szFileName, LPCSTR szEntryPoint, L
 
 #endif
 
-    // Memory Leak Warning:  On Intel Integrated GPU driver (i630) a memory leak occurs when
-    // compiling shaders.  Unknown at this time if the leak is DX11 affecting all GPUs, or Intel
-    // driver affecting only my GPU.  --jstine
+    ID3DBlob* pBlobOut   = nullptr;
+    ID3DBlob* pErrorBlob = nullptr;
+    Defer( { dx11_Release(pBlobOut); dx11_Release(pErrorBlob); } );
 
-    hr = D3DCompileFromFile(szFileName, nullptr, nullptr, szEntryPoint, szShaderModel,
-        dwShaderFlags, 0, ppBlobOut, &pErrorBlob);
+    // The standard include handler resolves includes relative to the including file, which is
+    // what the shader cache assumes when hashing them.
+    HRESULT hr = D3DCompileFromFile(toUTF16(srcfile).wc_str(), nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+        entryPointFn, profile, dx11_GetShaderCompileFlags(), 0, &pBlobOut, &pErrorBlob);
 
     if (FAILED(hr)) {
         if (pErrorBlob) {
-            throw_abort("%s", ptr_cast<const char*>(pErrorBlob->GetBufferPointer()));
+            errors = ptr_cast<const char*>(pErrorBlob->GetBufferPointer());
         }
         elif (hr == D3D11_ERROR_FILE_NOT_FOUND || hr == HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND)) {
-            throw_abort("Shader file not found: %S", szFileName);
+            errors.Format("Shader file not found: %s", srcfile.c_str());
         }
         else {
-            x_abort("D3DCompileFromFile(%S) failed with no errorBlob, hr=0x%08x", szFileName, hr);
+            errors.Format("D3DCompileFromFile(%s) failed with no errorBlob, hr=0x%08x", srcfile.c_str(), hr);
         }
+        return false;
     }
 
-    return hr;
+    auto* src = (const u8*)pBlobOut->GetBufferPointer();
+    bytecode.assign(src, src + pBlobOut->GetBufferSize());
+    return true;
 }
 
-ID3DBlob* CompileShaderFromFile(const WCHAR* szFileName, LPCSTR szEntryPoint, LPCSTR szShaderModel)
+// Fetches bytecode through the shader cache, compiling on a miss.  Compile errors are thrown.
+static ID3DBlob* dx11_FetchShaderBlob(const xString& srcfile, const char* entryPointFn, const char* profile)
 {
-    // TODO: Add a cache system to avoid recompiling shaders unless the shader file has actually been modified.
-    // Rationale: the leak in D3DCompileFromFile() interferes with using the Heap Graph as a leak checker.
+    std::vector<u8> bytecode;
+    xString         errors;
 
-    HRESULT hr = S_OK;
-    ID3DBlob* ppBlobOut;
+    if (!GPU_ShaderCache_Fetch(bytecode, srcfile, entryPointFn, profile, errors)) {
+        throw_abort("%s", errors.c_str());
+    }
 
-    hr = TryCompileShaderFromFile(szFileName, szEntryPoint, szShaderModel, &ppBlobOut);
-    throw_abort_on(FAILED(hr));
-    return ppBlobOut;
+    ID3DBlob* blob = nullptr;
+    HRESULT hr = D3DCreateBlob(bytecode.size(), &blob);
+    x_abort_on(FAILED(hr));
+    xMemCopy(blob->GetBufferPointer(), bytecode.data(), bytecode.size());
+    return blob;
 }
 
+// Per-frame rings, defined further down alongside the pipeline state they feed.
+static void dx11_FrameFence_Init        ();
+static void dx11_FrameFence_Dispose     ();
+static void dx11_ConstantRing_Init      ();
+static void dx11_ConstantRing_Dispose   ();
+static void dx11_TransientHeap_Init     ();
+static void dx11_TransientHeap_Dispose  ();
+
 void dx11_CleanupDevice()
 {
     if (!g_pd3dDevice) return;
@@ -362,6 +436,10 @@ void dx11_CleanupDevice()
     }
 
     dx11_InputLayoutCache_DisposeAll();
+    GPU_ShaderCache_Purge();
+    dx11_ConstantRing_Dispose();
+    dx11_TransientHeap_Dispose();
+    dx11_FrameFence_Dispose();
 
     for(auto& stateA : g_RasterState) {
         for(auto& stateB : stateA) {
@@ -413,69 +491,12 @@ void dx11_CleanupDevice()
 __ai const  InputLayoutSlot&    GPU_InputDesc::GetSlot  (int idx)   const   { bug_on(idx >= m_numSlots); return m_slots[idx]; }
 __ai        InputLayoutSlot&    GPU_InputDesc::GetSlot  (int idx)           { bug_on(idx >= m_numSlots); return m_slots[idx]; }
 
-void GPU_InputDesc::_AddHash(const InputLayoutSlot& src)
-{
-    bug_on (!src.m_numElements, "Unexpected zero-sized src data.");
-
-    u32 hashval = i_crc32(0, src.m_InstanceDataStepRate);
-    for (int i=0; i<src.m_numElements; ++i) {
-        hashval = i_crc32(hashval, src.m_Items[i].Format        );
-        hashval = i_crc32(hashval, src.m_Items[i].ByteOffset    );
-        static_assert(bulkof(src.m_Items[i].SemanticName) == 16, "");
-        hashval = i_crc32(hashval, (u64&)src.m_Items[i].SemanticName[0]);
-        hashval = i_crc32(hashval, (u64&)src.m_Items[i].SemanticName[8]);
-    }
-
-    // neat trick, serves 2 purposes.
-    //  1. ensures full 64 bit hash is never zero if something meaningful has been assigned
-    //     to this InputLayoutDesc.
-    //  2. Allows InstanceDataStepRate to be modified later on, and also allows incrementally
-    //     adding additional elements to this slot.
-
-    m_hashval = hashval | (u64(src.m_InstanceDataStepRate+1) << 32);
-}
-
-InputLayoutSlot& InputLayoutSlot::SetInstanceStepRate(int step)
-{
-    m_InstanceDataStepRate = step;
-    return *this;
-}
-
-InputLayoutSlot& InputLayoutSlot::Append(const InputLayoutItem& item)
-{
-    Append(item.SemanticName, item.Format);
-    return *this;
-}
-
-InputLayoutSlot& InputLayoutSlot::Append(const InputLayoutItemEx& item)
-{
-    Append(item.SemanticName, item.Format, item.offset);
-    return *this;
-}
-
-InputLayoutSlot& InputLayoutSlot::Append(const char* semanticName, GPU_ResourceFmt format, int offset)
-{
-    x_abort_on(m_numElements >= MaxElementsPerSlot, "Too many data elements added to InputLayoutSlot.");
-
-    // Check for redundant semantic name ...
-    for (int i=0; i<m_numElements; ++i) {
-        if (strcmp(semanticName, m_Items[i].SemanticName) == 0) {
-            throw_abort("Duplicate semantic name: %s", semanticName);
-        }
-    }
-
-    auto& newItem = m_Items[m_numElements];
-    xStrCopyT(newItem.SemanticName, semanticName);
-    newItem.ByteOffset  = offset;
-    newItem.Format      = format;
-
-    m_numElements += 1;
-    return *this;
-}
-
 void dx11_InitDevice()
 {
-    xMemZero(g_DynVertBuffers);
+    s_DynBufferPool.clear();
+    s_DynBufferFreeList = -1;
+
+    GPU_ShaderCache_SetCompiler(&s_dx11_ShaderCompiler);
 
     HRESULT hr = S_OK;
 
@@ -704,6 +725,10 @@ void dx11_InitDevice()
 
     //dx11_CreateDepthStencil();
 
+    dx11_FrameFence_Init();
+    dx11_ConstantRing_Init();
+    dx11_TransientHeap_Init();
+
     ImGui_ImplDX11_Init(g_pd3dDevice, g_pImmediateContext);
     ImGui_ImplDX11_CreateDeviceObjects();
 }
@@ -744,6 +769,369 @@ static const GPU_ShaderFS*      s_CurrentShaderFS   = nullptr;
 static       sptr               s_current_vertex_buffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
 static       int                s_current_vertex_buffer_high_water = 0;
 
+// --------------------------------------------------------------------------------------
+//  Shadow Pipeline State
+// --------------------------------------------------------------------------------------
+// Mirrors what has actually been forwarded to the immediate context, so that binds matching what's
+// already bound can be dropped before reaching the driver.  Invalidated at the start of each frame,
+// since other renderers (ImGui) use the context directly in between.  Invalidated state is all-ones
+// rather than zero, since binding nullptr is legitimate.
+//
+// Shader resources are only shadowed for the low slots; binds beyond are always forwarded.
+//
+static const int ShadowShaderResourceSlots = 16;
+
+// Constant slices share ring chunks, so a constant binding is only the same if its offset matches too.
+// Whole-buffer binds use offset 0.
+struct dx11_ShadowConstants
+{
+    sptr            buffer;
+    int             offset;
+
+    bool operator==(const dx11_ShadowConstants& right) const {
+        return (buffer == right.buffer) && (offset == right.offset);
+    }
+};
+
+struct dx11_ShadowState
+{
+    sptr            vertexBuffers       [D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    uint            vertexStrides       [D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    uint            vertexOffsets       [D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    dx11_ShadowConstants constantBuffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    sptr            shaderResources     [ShadowShaderResourceSlots];
+    sptr            indexBuffer;
+    int             indexFormat;
+    uint            indexOffset;
+    sptr            inputLayout;
+    sptr            shaderVS;
+    sptr            shaderFS;
+    sptr            rasterState;
+    int             primType;
+
+    void Invalidate() {
+        memset(this, 0xff, sizeof(*this));
+    }
+};
+
+static dx11_ShadowState         s_shadow;
+static GPU_PipelineStats        s_stats_frame       = {};       // accumulating, render thread only
+static GPU_PipelineStats        s_stats_last        = {};       // most recently completed frame
+static xSpinLock                s_stats_lock;
+
+// Updates a shadowed value, returning true if the bind must be forwarded to the driver.
+template< typename T >
+static __ai bool shadow_Update(T& shadow, const T& value)
+{
+    if (shadow == value) {
+        s_stats_frame.bindsSkipped += 1;
+        return false;
+    }
+    shadow = value;
+    s_stats_frame.bindsIssued += 1;
+    return true;
+}
+
+static __ai void stats_AddDraw(int instanceCount)
+{
+    s_stats_frame.draws     += 1;
+    s_stats_frame.instances += instanceCount;
+}
+
+// Stats for the most recently presented frame.  Safe to call from any thread.
+GPU_PipelineStats dx11_GetPipelineStats()
+{
+    xScopedSpinLock lock(s_stats_lock);
+    return s_stats_last;
+}
+
+
+// --------------------------------------------------------------------------------------
+//  Frame Fences
+// --------------------------------------------------------------------------------------
+// An event query is issued when a frame is submitted, and waited on before the per-frame allocations
+// of that back buffer (constant ring, transient heap) are reused.  The rings are therefore our own
+// multi-buffering, and don't depend on the driver renaming buffers on MAP_DISCARD (see
+// dx11_UpdateConstantBuffer for why that matters).
+//
+
+struct dx11_FrameFence
+{
+    ID3D11Query*                query           = nullptr;
+    bool                        pending         = false;
+};
+
+static dx11_FrameFence          s_frameFence        [BackBufferCount];
+
+static void dx11_FrameFence_Init()
+{
+    for (auto& fence : s_frameFence) {
+        D3D11_QUERY_DESC qd = {};
+        qd.Query = D3D11_QUERY_EVENT;
+        auto hr = g_pd3dDevice->CreateQuery(&qd, &fence.query);
+        x_abort_on(FAILED(hr));
+        dx11_ManageObject(fence.query);
+    }
+}
+
+static void dx11_FrameFence_Dispose()
+{
+    for (auto& fence : s_frameFence) {
+        dx11_Release(fence.query);
+        fence.pending = false;
+    }
+}
+
+// Waits for the GPU to be done with the frame this back buffer was used for BackBufferCount frames
+// ago.  Normally the fence passed long ago and this doesn't wait at all.
+static void dx11_FrameFence_Wait()
+{
+    auto& fence = s_frameFence[g_curBufferIdx];
+    if (!fence.pending) return;
+    while (g_pImmediateContext->GetData(fence.query, nullptr, 0, 0) == S_FALSE) {
+        xThreadYield();
+    }
+    fence.pending = false;
+}
+
+static void dx11_FrameFence_Signal()
+{
+    auto& fence = s_frameFence[g_curBufferIdx];
+    if (!fence.query) return;
+    g_pImmediateContext->End(fence.query);
+    fence.pending = true;
+}
+
+
+// --------------------------------------------------------------------------------------
+//  Constant Ring
+// --------------------------------------------------------------------------------------
+// Backs dx11_ReserveConstants().  Each back buffer owns a set of DYNAMIC constant buffer chunks, sized
+// to the largest range a single bind can address.  Slices are sub-allocated linearly through a
+// GPU_RingAllocator, written in place through the mapped pointer, and bound by offset via
+// *SetConstantBuffers1.  Chunks are reused once the back buffer's frame fence has passed.
+//
+// Offset binding and NO_OVERWRITE maps of constant buffers are D3D11.1 features.  Without them, slices
+// live in host memory and each bind copies its slice into a DEFAULT constant buffer through
+// UpdateSubresource -- the same cost as dx11_UpdateConstantBuffer, without callers having to care.
+//
+
+static const int ConstantRingChunkSize  = D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT * 16;
+static const int ConstantRingAlignment  = 256;      // *SetConstantBuffers1 ranges are multiples of 16 constants
+
+struct dx11_ConstantRing
+{
+    GPU_RingAllocator           alloc;
+    std::vector<ID3D11Buffer*>  chunks;
+    std::vector<u8*>            hostChunks;                 // fallback mode only
+};
+
+using ConstantFallbackCache_t = std::unordered_map<u32, ID3D11Buffer*>;
+
+static dx11_ConstantRing        s_cbRing            [BackBufferCount];
+static bool                     s_cbRing_offsetting = false;
+static ID3D11Buffer*            s_cbRing_mapped     = nullptr;      // chunk currently mapped, if any
+static u8*                      s_cbRing_mappedPtr  = nullptr;
+static ConstantFallbackCache_t  s_cbRing_fallback;                  // keyed by slot and size
+
+static void dx11_ConstantRing_Init()
+{
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+    s_cbRing_offsetting = g_pImmediateContext1 &&
+        SUCCEEDED(g_pd3dDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+        options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+
+    for (auto& ring : s_cbRing) {
+        ring.alloc.Init(ConstantRingChunkSize, ConstantRingAlignment);
+    }
+
+    log_host("[dx11] Constant ring mode: %s", s_cbRing_offsetting ? "offset binds" : "UpdateSubresource fallback");
+}
+
+static void dx11_ConstantRing_Unmap()
+{
+    if (!s_cbRing_mapped) return;
+    g_pImmediateContext->Unmap(s_cbRing_mapped, 0);
+    s_cbRing_mapped     = nullptr;
+    s_cbRing_mappedPtr  = nullptr;
+}
+
+static void dx11_ConstantRing_Dispose()
+{
+    dx11_ConstantRing_Unmap();
+    for (auto& ring : s_cbRing) {
+        for (auto& chunk : ring.chunks) {
+            dx11_Release(chunk);
+        }
+        for (auto* chunk : ring.hostChunks) {
+            xFree(chunk);
+        }
+        ring.chunks.clear();
+        ring.hostChunks.clear();
+    }
+
+    for (auto& item : s_cbRing_fallback) {
+        dx11_Release(item.second);
+    }
+    s_cbRing_fallback.clear();
+}
+
+// expects the back buffer's frame fence to have been waited on.
+static void dx11_ConstantRing_NewFrame()
+{
+    s_cbRing[g_curBufferIdx].alloc.Reset();
+}
+
+static void dx11_ConstantRing_EndFrame()
+{
+    dx11_ConstantRing_Unmap();
+}
+
+GPU_ConstantSlice dx11_ReserveConstants(int sizeInBytes)
+{
+    auto&   ring        = s_cbRing[g_curBufferIdx];
+    int     size        = (sizeInBytes + 15) & ~15;
+    int     offset      = 0;
+    int     chunkIdx    = ring.alloc.Alloc(size, offset);
+
+    GPU_ConstantSlice slice;
+    slice.offset    = offset;
+    slice.size      = size;
+
+    if (!s_cbRing_offsetting) {
+        while (chunkIdx >= (int)ring.hostChunks.size()) {
+            ring.hostChunks.push_back((u8*)xMalloc(ConstantRingChunkSize));
+        }
+        slice.data = ring.hostChunks[chunkIdx] + offset;
+        return slice;
+    }
+
+    while (chunkIdx >= (int)ring.chunks.size()) {
+        D3D11_BUFFER_DESC bd = {};
+        bd.Usage            = D3D11_USAGE_DYNAMIC;
+        bd.ByteWidth        = ConstantRingChunkSize;
+        bd.BindFlags        = D3D11_BIND_CONSTANT_BUFFER;
+        bd.CPUAccessFlags   = D3D11_CPU_ACCESS_WRITE;
+
+        ID3D11Buffer* chunk = nullptr;
+        auto hr = g_pd3dDevice->CreateBuffer(&bd, nullptr, &chunk);
+        x_abort_on(FAILED(hr));
+        dx11_ManageObject(chunk);
+        ring.chunks.push_back(chunk);
+        log_perf("[dx11] Constant ring for backbuffer %d grown to %d chunks", g_curBufferIdx, ring.chunks.size());
+    }
+
+    auto* chunk = ring.chunks[chunkIdx];
+    if (s_cbRing_mapped != chunk) {
+        dx11_ConstantRing_Unmap();
+
+        // The chunk's first use this frame is mapped DISCARD so that the driver needn't preserve its
+        // old contents.  It can't stall either way: this back buffer's fence has already passed.
+        D3D11_MAPPED_SUBRESOURCE mapped = {};
+        auto maptype = offset ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD;
+        auto hr = g_pImmediateContext->Map(chunk, 0, maptype, 0, &mapped);
+        x_abort_on(FAILED(hr));
+        s_cbRing_mapped     = chunk;
+        s_cbRing_mappedPtr  = (u8*)mapped.pData;
+    }
+
+    slice.data          = s_cbRing_mappedPtr + offset;
+    slice.m_driverData  = (sptr)chunk;
+    return slice;
+}
+
+void dx11_BindConstantSlice(const GPU_ConstantSlice& slice, int startSlot)
+{
+    bug_on(!slice.IsValid(), "Binding an unreserved constant slice.");
+    s_stats_frame.constantBufferBytes += slice.size;
+
+    if (!s_cbRing_offsetting) {
+        auto& drvbuf = s_cbRing_fallback[(startSlot << 16) | (slice.size / 16)];
+        if (!drvbuf) {
+            D3D11_BUFFER_DESC bd = {};
+            bd.Usage            = D3D11_USAGE_DEFAULT;
+            bd.ByteWidth        = slice.size;
+            bd.BindFlags        = D3D11_BIND_CONSTANT_BUFFER;
+            bd.CPUAccessFlags   = 0;
+            auto hr = g_pd3dDevice->CreateBuffer(&bd, nullptr, &drvbuf);
+            x_abort_on(FAILED(hr));
+            dx11_ManageObject(drvbuf);
+        }
+        g_pImmediateContext->UpdateSubresource(drvbuf, 0, nullptr, slice.data, 0, 0);
+        if (!shadow_Update(s_shadow.constantBuffers[startSlot], dx11_ShadowConstants{ (sptr)drvbuf, 0 })) return;
+        g_pImmediateContext->VSSetConstantBuffers(startSlot, 1, &drvbuf);
+        g_pImmediateContext->PSSetConstantBuffers(startSlot, 1, &drvbuf);
+        return;
+    }
+
+    // chunks can't be mapped while a draw reads from them.
+    dx11_ConstantRing_Unmap();
+
+    // Some runtimes drop *SetConstantBuffers1 calls which only move the range of a buffer that's
+    // already bound.  Unbinding first forces the new range through.
+    bool    sameBuffer  = (s_shadow.constantBuffers[startSlot].buffer == slice.m_driverData);
+    if (!shadow_Update(s_shadow.constantBuffers[startSlot], dx11_ShadowConstants{ slice.m_driverData, slice.offset })) return;
+
+    auto*   drvbuf      = (ID3D11Buffer*)slice.m_driverData;
+    UINT    firstConst  = slice.offset / 16;
+    UINT    numConsts   = ((slice.size + (ConstantRingAlignment-1)) & ~(ConstantRingAlignment-1)) / 16;
+
+    if (sameBuffer) {
+        ID3D11Buffer* nullbuf = nullptr;
+        g_pImmediateContext->VSSetConstantBuffers(startSlot, 1, &nullbuf);
+        g_pImmediateContext->PSSetConstantBuffers(startSlot, 1, &nullbuf);
+    }
+    g_pImmediateContext1->VSSetConstantBuffers1(startSlot, 1, &drvbuf, &firstConst, &numConsts);
+    g_pImmediateContext1->PSSetConstantBuffers1(startSlot, 1, &drvbuf, &firstConst, &numConsts);
+}
+
+
+// --------------------------------------------------------------------------------------
+//  Transient Vertex Heap
+// --------------------------------------------------------------------------------------
+// Backs dx11_SetTransientVertexBuffer().  Laid out like the constant ring: each back buffer owns a set
+// of DYNAMIC vertex buffer chunks which uploads are sub-allocated from linearly, and which are reused
+// once the back buffer's frame fence has passed.  Offset binds and NO_OVERWRITE maps of vertex buffers
+// are core D3D11, so there's no fallback mode.
+//
+// Each upload maps its chunk only for the copy.  A chunk's first map of the frame is DISCARD and the
+// rest NO_OVERWRITE, so the driver neither stalls nor renames -- unlike one DISCARD per GPU_DynVsBuffer.
+//
+
+static const int TransientHeapChunkSize     = _4mb;
+static const int TransientHeapAlignment     = 16;
+
+struct dx11_TransientHeap
+{
+    GPU_RingAllocator           alloc;
+    std::vector<ID3D11Buffer*>  chunks;
+};
+
+static dx11_TransientHeap       s_vbHeap            [BackBufferCount];
+
+static void dx11_TransientHeap_Init()
+{
+    for (auto& heap : s_vbHeap) {
+        heap.alloc.Init(TransientHeapChunkSize, TransientHeapAlignment);
+    }
+}
+
+static void dx11_TransientHeap_Dispose()
+{
+    for (auto& heap : s_vbHeap) {
+        for (auto& chunk : heap.chunks) {
+            dx11_Release(chunk);
+        }
+        heap.chunks.clear();
+    }
+}
+
+// expects the back buffer's frame fence to have been waited on.
+static void dx11_TransientHeap_NewFrame()
+{
+    s_vbHeap[g_curBufferIdx].alloc.Reset();
+}
+
 
 static InputLayoutCache_t       s_dx11_InputLayoutCache;
 //static InputDescCache_t           s_dx11_InputDescCache;
@@ -850,6 +1238,10 @@ void dx11_NewFrame()
 
     s_CurrentShaderVS = {};
     s_CurrentShaderFS = {};
+    s_shadow.Invalidate();
+    dx11_FrameFence_Wait();
+    dx11_ConstantRing_NewFrame();
+    dx11_TransientHeap_NewFrame();
 
     // Clear dynamic vertex shader runtime checks.
 
@@ -857,12 +1249,6 @@ void dx11_NewFrame()
         s_current_vertex_buffers[i] = 0;
     }
     s_current_vertex_buffer_high_water = 0;
-
-    for(int i=0; i<bulkof(g_DynVertBuffers[0]); ++i) {
-        if (g_DynVertBuffers[g_curBufferIdx][i].m_type == DynBuffer_Vertex) {
-            g_DynVertBuffers[g_curBufferIdx][i].m_updated_this_frame = 0;
-        }
-    }
 }
 
 // to be called after logic step and before issuing any draw commands through the pipeline.
@@ -881,6 +1267,7 @@ void dx11_BeginFrameDrawing()
 
 void dx11_PreDrawPrep()
 {
+    dx11_ConstantRing_Unmap();
     if (!s_NeedsPreDrawPrep) return;
     throw_abort_on(!s_CurrentShaderVS, "No VS shader is bound to the draw pipeline.");
     throw_abort_on(!s_CurrentShaderFS, "No FS shader is bound to the draw pipeline.");
@@ -895,13 +1282,17 @@ void dx11_PreDrawPrep()
         // assume any empty ones are intentional for now...
         if (!s_current_vertex_buffers[i]) continue;
 
-        if (s_current_vertex_buffers[i] < 256) {
+        if (dx11_IsDynHandleTag(s_current_vertex_buffers[i])) {
             // dynamic buffer handle
-            auto dynidx = s_current_vertex_buffers[i] - 1;
-            auto& buffer = g_DynVertBuffers[g_curBufferIdx][dynidx];
-            if (!buffer.m_updated_this_frame) {
-                warn_host("GPU_DynVsBuffer was not updated this frame. id=%d%s%s", dynidx,
-                    buffer.m_name[0] ? buffer.m_name : "(unnamed)"
+            // sparse buffers are only missed once their interval has elapsed without an upload.
+            auto dynidx = (int)(s_current_vertex_buffers[i] >> 1);
+            const auto& sched = s_DynBufferPool[dynidx].m_sched;
+            if (g_gpu_host_framecount - sched.m_upload_frame >= sched.m_interval) {
+                const auto& buffer = s_DynBufferPool[dynidx].m_instances[0];
+                warn_host("GPU_DynVsBuffer was not updated %s. id=%d%s%s",
+                    (sched.m_interval > 1) ? "within its update interval" : "this frame", dynidx,
+                    buffer.m_name[0] ? " name="      : "",
+                    buffer.m_name[0] ? buffer.m_name : ""
                 );
             }
         }
@@ -917,9 +1308,12 @@ void dx11_PreDrawPrep()
     }
     s_current_vertex_buffer_high_water = 0;
 
-    g_pImmediateContext->IASetInputLayout(do_prep_inputLayout());
-    g_pImmediateContext->VSSetShader(shaderVS, nullptr, 0);
-    g_pImmediateContext->PSSetShader(shaderFS, nullptr, 0);
+    // prep is requested whenever any of the layout, shaders, or vertex buffers change, so usually
+    // only some of these actually differ from what's bound.
+    auto*   inputLayout = do_prep_inputLayout();
+    if (shadow_Update(s_shadow.inputLayout, (sptr)inputLayout)) g_pImmediateContext->IASetInputLayout(inputLayout);
+    if (shadow_Update(s_shadow.shaderVS,    (sptr)shaderVS   )) g_pImmediateContext->VSSetShader(shaderVS, nullptr, 0);
+    if (shadow_Update(s_shadow.shaderFS,    (sptr)shaderFS   )) g_pImmediateContext->PSSetShader(shaderFS, nullptr, 0);
     s_NeedsPreDrawPrep = 0;
 }
 
@@ -936,7 +1330,7 @@ bool dx11_TryLoadShaderVS(GPU_ShaderVS& dest, const xString& srcfile, const char
     xMallocNew(info);
 
     bug_on( !entryPointFn || !entryPointFn[0] );
-    info->blob = CompileShaderFromFile(toUTF16(srcfile).wc_str(), entryPointFn, "vs_4_0");
+    info->blob = dx11_FetchShaderBlob(srcfile, entryPointFn, "vs_4_0");
     if (!info->blob) return false;
 
     ID3DBlob* insig = nullptr;
@@ -980,7 +1374,7 @@ bool dx11_TryLoadShaderFS(GPU_ShaderFS& dest, const xString& srcfile, const char
     xMallocNew(info);
 
     bug_on( !entryPointFn || !entryPointFn[0] );
-    info->blob = CompileShaderFromFile(toUTF16(srcfile).wc_str(), entryPointFn, "ps_4_0");
+    info->blob = dx11_FetchShaderBlob(srcfile, entryPointFn, "ps_4_0");
     if (!info->blob) return false;
 
     hr = g_pd3dDevice->CreatePixelShader(info->blob->GetBufferPointer(), info->blob->GetBufferSize(), nullptr, &shader);
@@ -1003,6 +1397,18 @@ void dx11_LoadShaderFS(GPU_ShaderFS& dest, const xString& srcfile, const char* e
     bug_on_qa(!result, "Errors during shader compiler and no error handler is registered.");
 }
 
+void dx11_PrefetchShaders(const GPU_ShaderPrefetch* shaders, int count)
+{
+    std::vector<GPU_ShaderCacheRequest> requests;
+    requests.reserve(count * 2);
+    for (int i=0; i<count; ++i) {
+        const auto& item = shaders[i];
+        if (item.entryVS) requests.push_back({ item.srcfile, item.entryVS, "vs_4_0" });
+        if (item.entryFS) requests.push_back({ item.srcfile, item.entryFS, "ps_4_0" });
+    }
+    GPU_ShaderCache_Prefetch(requests.data(), (int)requests.size());
+}
+
 void dx11_BindShaderVS(const GPU_ShaderVS& vs)
 {
     bug_on_qa(!vs.m_driverBinary, "Uninitialized VS shader resource.");
@@ -1021,6 +1427,25 @@ void dx11_BindShaderFS(const GPU_ShaderFS& fs)
     }
 }
 
+static void dx11_SetVertexBufferFiltered(int shaderSlot, sptr buffer, uint stride, uint offset)
+{
+    bool changed =
+        (s_shadow.vertexBuffers[shaderSlot] != buffer) ||
+        (s_shadow.vertexStrides[shaderSlot] != stride) ||
+        (s_shadow.vertexOffsets[shaderSlot] != offset);
+
+    if (!changed) {
+        s_stats_frame.bindsSkipped += 1;
+        return;
+    }
+
+    s_shadow.vertexBuffers[shaderSlot] = buffer;
+    s_shadow.vertexStrides[shaderSlot] = stride;
+    s_shadow.vertexOffsets[shaderSlot] = offset;
+    s_stats_frame.bindsIssued += 1;
+    g_pImmediateContext->IASetVertexBuffers(shaderSlot, 1, (ID3D11Buffer**)&buffer, &stride, &offset);
+}
+
 void dx11_SetVertexBuffer(const GPU_DynVsBuffer& src, int shaderSlot, int _stride, int _offset)
 {
     uint stride = _stride;
@@ -1029,14 +1454,14 @@ void dx11_SetVertexBuffer(const GPU_DynVsBuffer& src, int shaderSlot, int _strid
     bug_on(!src.IsValid());
     if (!src.IsValid()) return;
 
-    auto& buffer = g_DynVertBuffers[g_curBufferIdx][src.m_buffer_idx];
+    auto& buffer = s_DynBufferPool[src.m_buffer_idx].m_instances[dx11_GetDynBufferInstance(src.m_buffer_idx)];
     bug_on_qa(buffer.m_type != DynBuffer_Vertex, "DynamicVertexBuffer expected '%s' but got '%s'",
         enumToString(DynBuffer_Vertex),
         enumToString(buffer.m_type)
     );
-    g_pImmediateContext->IASetVertexBuffers(shaderSlot, 1, &buffer.m_dx11_buffer, &stride, &offset);
-    if (s_current_vertex_buffers[shaderSlot] != src.m_buffer_idx+1) {
-        s_current_vertex_buffers[shaderSlot]  = src.m_buffer_idx+1;
+    dx11_SetVertexBufferFiltered(shaderSlot, (sptr)buffer.m_dx11_buffer, stride, offset);
+    if (s_current_vertex_buffers[shaderSlot] != dx11_DynHandleTag(src.m_buffer_idx)) {
+        s_current_vertex_buffers[shaderSlot]  = dx11_DynHandleTag(src.m_buffer_idx);
         s_NeedsPreDrawPrep = 1;
 }
     if (s_current_vertex_buffer_high_water < shaderSlot) {
@@ -1053,11 +1478,58 @@ void dx11_SetVertexBuffer( const GPU_VertexBuffer& vbuffer, int shaderSlot, int
     bug_on(!vbuffer.m_driverData);
     bug_on(!dx11_IsManagedObject(vbuffer.m_driverData));
 
-    g_pImmediateContext->IASetVertexBuffers(shaderSlot, 1, (ID3D11Buffer**)&vbuffer.m_driverData, &stride, &offset);
+    dx11_SetVertexBufferFiltered(shaderSlot, vbuffer.m_driverData, stride, offset);
     if (s_current_vertex_buffers[shaderSlot] != vbuffer.m_driverData) {
         s_current_vertex_buffers[shaderSlot]  = vbuffer.m_driverData;
         s_NeedsPreDrawPrep = 1;
 }
+
+void dx11_SetTransientVertexBuffer(const void* srcData, int sizeInBytes, int shaderSlot, int _stride)
+{
+    bug_on(!srcData);
+    x_abort_on(sizeInBytes > TransientHeapChunkSize, "Transient vertex upload is too large [size=%d max=%d]",
+        sizeInBytes, TransientHeapChunkSize
+    );
+
+    auto&   heap        = s_vbHeap[g_curBufferIdx];
+    int     offset      = 0;
+    int     chunkIdx    = heap.alloc.Alloc(sizeInBytes, offset);
+
+    while (chunkIdx >= (int)heap.chunks.size()) {
+        D3D11_BUFFER_DESC bd = {};
+        bd.Usage            = D3D11_USAGE_DYNAMIC;
+        bd.ByteWidth        = TransientHeapChunkSize;
+        bd.BindFlags        = D3D11_BIND_VERTEX_BUFFER;
+        bd.CPUAccessFlags   = D3D11_CPU_ACCESS_WRITE;
+
+        ID3D11Buffer* chunk = nullptr;
+        auto hr = g_pd3dDevice->CreateBuffer(&bd, nullptr, &chunk);
+        x_abort_on(FAILED(hr));
+        dx11_ManageObject(chunk);
+        heap.chunks.push_back(chunk);
+        log_perf("[dx11] Transient vertex heap for backbuffer %d grown to %d chunks", g_curBufferIdx, heap.chunks.size());
+    }
+
+    auto* chunk = heap.chunks[chunkIdx];
+
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    auto maptype = offset ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD;
+    auto hr = g_pImmediateContext->Map(chunk, 0, maptype, 0, &mapped);
+    x_abort_on(FAILED(hr));
+    xMemCopy((u8*)mapped.pData + offset, srcData, sizeInBytes);
+    g_pImmediateContext->Unmap(chunk, 0);
+    s_stats_frame.transientBufferBytes += sizeInBytes;
+
+    dx11_SetVertexBufferFiltered(shaderSlot, (sptr)chunk, _stride, offset);
+    if (s_current_vertex_buffers[shaderSlot] != (sptr)chunk) {
+        s_current_vertex_buffers[shaderSlot]  = (sptr)chunk;
+        s_NeedsPreDrawPrep = 1;
+    }
+    if (s_current_vertex_buffer_high_water < shaderSlot) {
+        s_current_vertex_buffer_high_water = shaderSlot;
+        s_NeedsPreDrawPrep = 1;
+    }
+}
     if (s_current_vertex_buffer_high_water < shaderSlot) {
         s_current_vertex_buffer_high_water = shaderSlot;
         s_NeedsPreDrawPrep = 1;
@@ -1073,30 +1545,48 @@ void dx11_SetIndexBuffer(const GPU_IndexBuffer& indexBuffer, int bitsPerIndex, i
         case 32:    format = DXGI_FORMAT_R32_UINT;      break;
         default:    unreachable("Invalid parameter 'bitsPerindex=%d'", bitsPerIndex);
     }
+    bool changed =
+        (s_shadow.indexBuffer != indexBuffer.m_driverData) ||
+        (s_shadow.indexFormat != format) ||
+        (s_shadow.indexOffset != (uint)offset);
+
+    if (!changed) {
+        s_stats_frame.bindsSkipped += 1;
+        return;
+    }
+
+    s_shadow.indexBuffer = indexBuffer.m_driverData;
+    s_shadow.indexFormat = format;
+    s_shadow.indexOffset = offset;
+    s_stats_frame.bindsIssued += 1;
     g_pImmediateContext->IASetIndexBuffer( (ID3D11Buffer*)indexBuffer.m_driverData, format, offset);
 }
 
 void dx11_Draw(int indexCount, int startVertLoc)
 {
     dx11_PreDrawPrep();
+    stats_AddDraw(1);
     g_pImmediateContext->Draw(indexCount, startVertLoc);
 }
 
 void dx11_DrawIndexed(int indexCount, int startIndexLoc, int baseVertLoc)
 {
     dx11_PreDrawPrep();
+    stats_AddDraw(1);
     g_pImmediateContext->DrawIndexed(indexCount, startIndexLoc, baseVertLoc);
 }
 
 void dx11_DrawInstanced(int vertsPerInstance, int instanceCount, int startVertLoc, int startInstanceLoc)
 {
     dx11_PreDrawPrep();
+    stats_AddDraw(instanceCount);
     g_pImmediateContext->DrawInstanced(vertsPerInstance, instanceCount, startVertLoc, startInstanceLoc);
 }
 
 void dx11_DrawIndexedInstanced(int indexesPerInstance, int instanceCount, int startIndex, int baseVertex, int startInstance)
 {
     dx11_PreDrawPrep();
+    stats_AddDraw(instanceCount);
     g_pImmediateContext->DrawIndexedInstanced(indexesPerInstance, instanceCount, startIndex, baseVertex, startInstance);
 }
 
@@ -1109,7 +1599,7 @@ void dx11_DrawIndexedInstanced(int indexesPerInstance, int instanceCount, int st
     threads for this purpose.  The parallel activity occurs automatically as the GPU renders
     previous buffer in the background while the CPU prepares the next frame.
 
-  Sparse Update Scenario:   (TODO: not yet implemented)
+  Sparse Update Scenario:   (updateInterval parameter of dx11_CreateDynamicVertexBuffer)
     In this scenario, dynamic vertex buffers are updated every Nth frame, where 'N' is any integer.
     Each buffer in between uses the most recent vertex data.
         Frame     DynBufferIdx
@@ -1126,8 +1616,9 @@ void dx11_DrawIndexedInstanced(int indexesPerInstance, int instanceCount, int st
     Using this strategy, a dynamic vertex mesh can meter itself and reduce performance overhead,
     without having to give up specific perf gains earned by the buffering system.
 
-    When Sparse Buffering is enabled, the engine will create at least two vertex buffers and
-    at most (NumBackbuffers/N) vertex buffers.  In a typical scenario the number of backbuffers
+    When Sparse Buffering is enabled, the engine creates 1+ceil((NumBackbuffers-1)/N) vertex buffers:
+    each upload's buffer is read by the N frames which follow, and the GPU may still be working on
+    up to (NumBackbuffers-1) frames when the CPU writes the next one.  In a typical scenario the number of backbuffers
     is three or four, so the sparse buffer will be a simple double-buffer for all practical
     purposes.  A possible exception might be an ultra-high framerate renderer (180hz or such),
     where it might be reasonable to set six backbuffers since the latency penalty for such
@@ -1140,8 +1631,22 @@ void dx11_DrawIndexedInstanced(int indexesPerInstance, int instanceCount, int st
           3            1
           4            2          <-- vertex data uploaded
           5            2
-          6            0          <-- vertex data uploaded
-          7            0
+          6            3          <-- vertex data uploaded
+          7            3
+          8            0          <-- vertex data uploaded
+
+    Each frame's first upload moves the buffer on to its next instance, so the schedule follows the
+    uploads rather than the frame count.  Uploading sooner than every N frames (eg. whenever contents
+    change) is permitted, but then the next instance may still be in use by the GPU; correctness is
+    kept by MAP_WRITE_DISCARD, at the cost of relying on the driver to rename the buffer.  Missing an
+    upload for N frames is reported at draw time.
+
+  Transient Scenario:   (dx11_SetTransientVertexBuffer)
+    Data which is rebuilt from scratch every frame and sized by whatever the frame contains (sprite
+    instances, debug geometry) doesn't need a buffer of its own.  It's sub-allocated from the back
+    buffer's transient heap instead, and bound by offset.  There's nothing to size up front, no
+    handle to hold, and uploads within a frame share a handful of heap chunks rather than each
+    incurring a DISCARD rename.
 */
 
 
@@ -1160,60 +1665,115 @@ void dx11_UploadDynamicBufferData(const GPU_DynVsBuffer& src, const void* srcDat
 
     D3D11_MAPPED_SUBRESOURCE mappedResource = {};
 
-    auto&   simple      = g_DynVertBuffers[g_curBufferIdx][src.m_buffer_idx];
+    auto&   slot        = s_DynBufferPool[src.m_buffer_idx];
+    auto&   sched       = slot.m_sched;
+    bug_on(sizeInBytes > slot.m_capacity, "Dynamic buffer upload overflows the buffer [size=%d capacity=%d]",
+        sizeInBytes, slot.m_capacity
+    );
 
-    if (simple.m_updated_this_frame) {
+    if (sched.m_upload_frame == g_gpu_host_framecount) {
+        const auto& named = slot.m_instances[0];
         log_perf("[dx11] Dynamic buffer data was already updated this frame [size=%d%s%s]", sizeInBytes,
-           simple.m_name[0] ? " name="      : "",
-           simple.m_name[0] ? simple.m_name : ""
+           named.m_name[0] ? " name="      : "",
+           named.m_name[0] ? named.m_name : ""
         );
     }
+    else if (sched.m_interval > 1) {
+        sched.m_current = (sched.m_current + 1) % sched.m_instances;
+    }
+    sched.m_upload_frame = g_gpu_host_framecount;
 
-    simple.m_updated_this_frame = 1;
+    auto&   simple      = slot.m_instances[dx11_GetDynBufferInstance(src.m_buffer_idx)];
 
     bug_on_qa(simple.m_type == DynBuffer_Free);
     g_pImmediateContext->Map(simple.m_dx11_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
     xMemCopy(mappedResource.pData, srcData, sizeInBytes);
     g_pImmediateContext->Unmap(simple.m_dx11_buffer, 0);
+    s_stats_frame.dynamicBufferBytes += sizeInBytes;
 }
 
-void dx11_CreateDynamicVertexBuffer(GPU_DynVsBuffer& dest, int bufferSizeInBytes, const char* diag_name)
+void dx11_CreateDynamicVertexBuffer(GPU_DynVsBuffer& dest, int bufferSizeInBytes, const char* diag_name, int updateInterval)
 {
-    // TODO : Improve search algo efficiency...
+    bug_on(updateInterval < 1, "Invalid dynamic buffer update interval=%d", updateInterval);
+    bug_on(bufferSizeInBytes <= 0);
+
     int bufferIdx = dest.m_buffer_idx;
 
-    if (dest.m_buffer_idx < 0) {
-        for(int i=0; i<bulkof(g_DynVertBuffers[0]); ++i) {
-            if (g_DynVertBuffers[0][i].m_type == DynBuffer_Free) {
-                bufferIdx = i;
-                break;
-            }
+    if (bufferIdx < 0) {
+        if (s_DynBufferFreeList >= 0) {
+            bufferIdx           = s_DynBufferFreeList;
+            s_DynBufferFreeList = s_DynBufferPool[bufferIdx].m_next_free;
+        }
+        else {
+            bufferIdx = (int)s_DynBufferPool.size();
+            s_DynBufferPool.emplace_back();
         }
+        xMemZero(s_DynBufferPool[bufferIdx]);
+        s_DynBufferPool[bufferIdx].m_next_free = -1;
     }
 
-    x_abort_on(bufferIdx < 0, "Ran out of Dynamic buffer handles");
+    auto& slot      = s_DynBufferPool[bufferIdx];
+    auto& sched     = slot.m_sched;
+    int   instances = GPU_GetDynBufferInstanceCount(BackBufferCount, updateInterval);
 
-    for (int i=0; i<BackBufferCount; ++i) {
-        D3D11_BUFFER_DESC bd = {};
-        bd.Usage            = D3D11_USAGE_DYNAMIC;
-        bd.ByteWidth        = bufferSizeInBytes;
-        bd.BindFlags        = D3D11_BIND_VERTEX_BUFFER;
-        bd.CPUAccessFlags   = D3D11_CPU_ACCESS_WRITE;
+    // existing buffers are kept when they're already big enough, so that re-creating a handle with
+    // a smaller or equal size doesn't release buffers which queued frames may still reference.
+    bool  realloc   = (bufferSizeInBytes > slot.m_capacity) || (instances != sched.m_instances);
 
-        auto& buffer = g_DynVertBuffers[i][bufferIdx];
-        dx11_Release(buffer.m_dx11_buffer);
-        auto hr = g_pd3dDevice->CreateBuffer(&bd, nullptr, &buffer.m_dx11_buffer);
-        bug_on (FAILED(hr));
-        buffer.m_type = DynBuffer_Vertex;
-        if (diag_name) {
-            strncpy_s(buffer.m_name, diag_name, _TRUNCATE);
+    sched.m_interval        = updateInterval;
+    sched.m_instances       = instances;
+    sched.m_current         = instances - 1;            // first upload rotates to instance 0
+    sched.m_upload_frame    = g_gpu_host_framecount - updateInterval;
+
+    if (realloc) {
+        for (int i=instances; i<BackBufferCount; ++i) {
+            auto& buffer = slot.m_instances[i];
+            dx11_Release(buffer.m_dx11_buffer);
+            buffer.m_type = DynBuffer_Free;
+        }
+
+        for (int i=0; i<instances; ++i) {
+            D3D11_BUFFER_DESC bd = {};
+            bd.Usage            = D3D11_USAGE_DYNAMIC;
+            bd.ByteWidth        = bufferSizeInBytes;
+            bd.BindFlags        = D3D11_BIND_VERTEX_BUFFER;
+            bd.CPUAccessFlags   = D3D11_CPU_ACCESS_WRITE;
+
+            auto& buffer = slot.m_instances[i];
+            dx11_Release(buffer.m_dx11_buffer);
+            auto hr = g_pd3dDevice->CreateBuffer(&bd, nullptr, &buffer.m_dx11_buffer);
+            bug_on (FAILED(hr));
+            buffer.m_type = DynBuffer_Vertex;
+            dx11_ManageObject(buffer.m_dx11_buffer);
+        }
+        slot.m_capacity = bufferSizeInBytes;
+    }
+
+    if (diag_name) {
+        for (int i=0; i<instances; ++i) {
+            strncpy_s(slot.m_instances[i].m_name, diag_name, _TRUNCATE);
         }
-        dx11_ManageObject(buffer.m_dx11_buffer);
     }
 
     dest.m_buffer_idx = bufferIdx;
 }
 
+// Releases the buffer's instances and returns its handle to the pool.  As with creation, frames which
+// may still reference the buffer must have finished rendering.
+void GPU_DynVsBuffer::Dispose()
+{
+    if (!IsValid()) return;
+
+    auto& slot = s_DynBufferPool[m_buffer_idx];
+    for (auto& buffer : slot.m_instances) {
+        dx11_Release(buffer.m_dx11_buffer);
+    }
+    xMemZero(slot);
+    slot.m_next_free    = s_DynBufferFreeList;
+    s_DynBufferFreeList = m_buffer_idx;
+    m_buffer_idx        = -1;
+}
+
 void GPU_VertexBuffer::Dispose()
 {
     dx11_Release(ptr_cast<ID3D11Buffer*&>(m_driverData));
@@ -1279,6 +1839,10 @@ void dx11_UpdateConstantBuffer(const GPU_ConstantBuffer& buffer, const void* dat
     bug_on(!drvbuf, "Uninitialized ConstantBuffer resource");
     g_pImmediateContext->UpdateSubresource(drvbuf, 0, nullptr, data, 0, 0 );
 
+    D3D11_BUFFER_DESC desc;
+    drvbuf->GetDesc(&desc);
+    s_stats_frame.constantBufferBytes += desc.ByteWidth;
+
     // Implementation warning:  Yes, nvidia suggests using map(DISCARD)/unmap() instead of UpdateSubresource.
     // This is not to be implemented blindly.
     //  1. using map/memcpy/unmap within this function alone may not help.  The point is to avoid the memcpy()
@@ -1297,6 +1861,10 @@ void dx11_UpdateConstantBuffer(const GPU_ConstantBuffer& buffer, const void* dat
     // moving a single byte of data, and is terribly slow for small-data constant updates.  Ours uses movsd,
     // and could be optimized further by providing a template version of this function that knows constant size
     // of the input data.
+    //
+    // Both points are addressed by dx11_ReserveConstants(): constants are written straight into a mapped slice
+    // of a per-backbuffer ring, fenced by us rather than relying on driver renaming.  Prefer it for anything
+    // updated per-draw.  This function remains for buffers which are updated rarely and bound for a long time.
 }
 
 pragma_todo("Relocate SaveTextureToPng into a different module.");
@@ -1358,6 +1926,9 @@ void dx11_SubmitFrameAndSwap()
     // the ImGui focus state would be out of sync for a single frame.  Probably OK.
     KPad_SetKeyboardFocus(!ImGui::GetIO().WantCaptureKeyboard);
 
+    dx11_ConstantRing_EndFrame();
+    dx11_FrameFence_Signal();
+
     if (g_pSwapChain) {
         g_pSwapChain->Present(0, 0);
     }
@@ -1366,6 +1937,14 @@ void dx11_SubmitFrameAndSwap()
         dx11_SaveTextureToPng(g_gpu_BackBuffer, xGetTempDir() + xFmtStr("/screen%d.png", g_gpu_host_framecount));
     }
     g_curBufferIdx = (g_curBufferIdx+1) % BackBufferCount;
+
+    s_stats_frame.frame = g_gpu_host_framecount;
+    {
+        xScopedSpinLock lock(s_stats_lock);
+        s_stats_last = s_stats_frame;
+    }
+    s_stats_frame = {};
+
     ++g_gpu_host_framecount;
 }
 
@@ -1383,7 +1962,9 @@ void dx11_SetPrimType(GpuPrimitiveType primType)
         default: unreachable("");
     }
 
-    g_pImmediateContext->IASetPrimitiveTopology(dxPrimTopology);
+    if (shadow_Update(s_shadow.primType, (int)dxPrimTopology)) {
+        g_pImmediateContext->IASetPrimitiveTopology(dxPrimTopology);
+    }
 }
 
 void dx11_SetRasterState(GpuRasterFillMode fill, GpuRasterCullMode cull, GpuRasterScissorMode scissor)
@@ -1391,13 +1972,20 @@ void dx11_SetRasterState(GpuRasterFillMode fill, GpuRasterCullMode cull, GpuRast
     if (g_gpu_ForceWireframe) {
         fill = GPU_Fill_Wireframe;
     }
-    g_pImmediateContext->RSSetState(g_RasterState[fill][cull][scissor]);
-    g_pImmediateContext->PSSetSamplers( 0, 1, &m_pTextureSampler );
+    // the sampler only ever changes along with the raster state, so it shares its filter.
+    auto*   rasterState = g_RasterState[fill][cull][scissor];
+    if (shadow_Update(s_shadow.rasterState, (sptr)rasterState)) {
+        g_pImmediateContext->RSSetState(rasterState);
+        g_pImmediateContext->PSSetSamplers( 0, 1, &m_pTextureSampler );
+    }
 }
 
 void dx11_BindShaderResource(const GPU_ShaderResource& res, int startSlot)
 {
     auto&   resourceView    = ptr_cast<ID3D11ShaderResourceView* const&>(res.m_driverData_view);
+    if (startSlot < ShadowShaderResourceSlots) {
+        if (!shadow_Update(s_shadow.shaderResources[startSlot], res.m_driverData_view)) return;
+    }
     g_pImmediateContext->VSSetShaderResources( startSlot, 1, &resourceView );
     g_pImmediateContext->PSSetShaderResources( startSlot, 1, &resourceView );
 }
@@ -1405,6 +1993,7 @@ void dx11_BindShaderResource(const GPU_ShaderResource& res, int startSlot)
 void dx11_BindConstantBuffer(const GPU_ConstantBuffer& buffer, int startSlot)
 {
     auto&   drvbuf          = ptr_cast<ID3D11Buffer* const &>(buffer.m_driverData);
+    if (!shadow_Update(s_shadow.constantBuffers[startSlot], dx11_ShadowConstants{ buffer.m_driverData, 0 })) return;
     g_pImmediateContext->VSSetConstantBuffers(startSlot, 1, &drvbuf);
     g_pImmediateContext->PSSetConstantBuffers(startSlot, 1, &drvbuf);
 }
@@ -465,7 +465,7 @@ bool    ImGui_ImplDX11_Init(ID3D11Device* device, ID3D11DeviceContext* device_co
     g_pd3dDeviceContext = device_context;
 
     ImGuiIO& io = ImGui::GetIO();
-    io.RenderDrawListsFn = ImGui_ImplDX11_RenderDrawLists;  // Alternatively you can set this to NULL and call ImGui::GetDrawData() after ImGui::Render() to get the same ImDrawData pointer.
+    io.RenderDrawListsFn = NULL;    // draw data is submitted by the scene via ImGui_ImplDX11_RenderDrawLists(), which may be on the render thread.
     return true;
 }
 
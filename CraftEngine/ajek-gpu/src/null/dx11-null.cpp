@@ -0,0 +1,773 @@
+#include "x-types.h"
+#include "x-stl.h"
+#include "x-string.h"
+#include "x-stdlib.h"
+#include "x-stdalloc.h"
+#include "x-stdfile.h"
+#include "x-thread.h"
+#include "x-workers.h"
+#include "x-assertion.h"
+#include "x-ThrowContext.h"
+
+#include "v-float.h"
+#include "x-gpu-ifc.h"
+#include "x-gpu-ring.h"
+
+#include "imgui_impl_dx11.h"
+
+#include <unordered_set>
+#include <vector>
+
+// --------------------------------------------------------------------------------------
+//  Null GPU Backend
+// --------------------------------------------------------------------------------------
+// Implements the whole x-gpu-ifc.h interface without a device, so that scene init, logic, and render
+// submission can run headless (Linux CI, etc).  Link this in place of the msw backend.
+//
+//  * Buffers, textures, and shaders are host-memory stand-ins.  Buffer and texture contents are kept
+//    and uploads really copy, so the CPU cost of uploads is in line with the DX11 path.
+//  * Handles and pipeline state are validated the way the DX11 path validates them at draw time:
+//    binding released objects, drawing without shaders or a layout, and dynamic buffers which weren't
+//    updated this frame are all reported.
+//  * Per-frame GPU_PipelineStats are collected with the same redundant-bind filtering as the DX11
+//    backend, so counts from CI runs can be compared against a real device.
+//
+// Nothing is rasterized.  dx11_SubmitFrameAndSwap() only ends the frame.
+//
+
+static const int BackBufferCount = 3;
+
+int2                    g_client_size_pix       = {0, 0};
+float                   g_client_aspect_ratio   = 1.0f;
+GPU_RenderTarget        g_gpu_BackBuffer;
+int                     g_gpu_host_framecount   = 0;
+
+static int              s_curBufferIdx          = 0;
+static bool             s_device_ready          = false;
+
+enum NullObjectType : u8 {
+    NullObj_VertexBuffer,
+    NullObj_IndexBuffer,
+    NullObj_ConstantBuffer,
+    NullObj_DynVertexBuffer,
+    NullObj_Texture,
+    NullObj_ShaderVS,
+    NullObj_ShaderFS,
+};
+
+// Stand-in for any device object.  Handles (m_driverData and friends) point directly at these.
+struct NullObject
+{
+    NullObjectType      type;
+    int                 size;
+    u8*                 data;
+};
+
+using NullObjectSet = std::unordered_set<const void*, FunctHashAlignedPtr>;
+static NullObjectSet    s_null_objects;
+
+struct NullDynBufferItem
+{
+    NullObject*         m_object;
+    char                m_name[30];
+};
+
+// Same schedule as the DX11 backend: buffers updated every frame use the instance matching s_curBufferIdx,
+// sparse buffers rotate through their first m_instances rows with each frame's first upload.
+struct NullDynBufferSchedule
+{
+    int                 m_interval;
+    int                 m_instances;
+    int                 m_current;
+    int                 m_upload_frame;
+};
+
+// Same handle pool as the DX11 backend: disposed handles are chained through m_next_free and reused
+// before the pool grows.
+struct NullDynBufferSlot
+{
+    NullDynBufferItem       m_instances[BackBufferCount];
+    NullDynBufferSchedule   m_sched;
+    int                     m_capacity;
+    int                     m_next_free;
+};
+
+static std::vector<NullDynBufferSlot>   s_DynBufferPool;
+static int                              s_DynBufferFreeList = -1;
+
+static __ai int null_GetDynBufferInstance(int bufferIdx)
+{
+    const auto& sched = s_DynBufferPool[bufferIdx].m_sched;
+    return (sched.m_interval > 1) ? sched.m_current : s_curBufferIdx;
+}
+
+static NullObject* null_CreateObject(NullObjectType type, int size, const void* src)
+{
+    bug_on(size < 0);
+
+    auto* obj   = (NullObject*)xMalloc(sizeof(NullObject));
+    obj->type   = type;
+    obj->size   = size;
+    obj->data   = size ? (u8*)xMalloc(size) : nullptr;
+    if (src && size) {
+        xMemCopy(obj->data, src, size);
+    }
+
+    s_null_objects.insert(obj);
+    return obj;
+}
+
+template< typename T >
+static void null_Release(T& handle)
+{
+    if (!handle) return;
+
+    auto* obj = (NullObject*)handle;
+    auto  it  = s_null_objects.find(obj);
+    if (it == s_null_objects.end()) {
+        bug("Unmanaged null GPU object @ %s", cPtrStr(obj, ""));
+    }
+    else {
+        s_null_objects.erase(it);
+        xFree(obj->data);
+        xFree(obj);
+    }
+    handle = 0;
+}
+
+// Returns the object behind a handle, reporting handles which have been released or which refer to
+// an object of the wrong type.
+static const NullObject* null_Resolve(sptr handle, NullObjectType type, const char* what)
+{
+    bug_on_qa(!handle, "Uninitialized %s resource.", what);
+    if (!handle) return nullptr;
+
+    auto* obj = (const NullObject*)handle;
+    if (s_null_objects.find(obj) == s_null_objects.end()) {
+        bug_qa("%s resource has been deinitialized since being created.", what);
+        return nullptr;
+    }
+    bug_on_qa(obj->type != type, "%s resource handle refers to an object of another type (type=%d).", what, obj->type);
+    return obj;
+}
+
+// --------------------------------------------------------------------------------------
+//  Pipeline state and stats
+// --------------------------------------------------------------------------------------
+// Matches the filtering done by the DX11 backend's shadow state: a bind is counted as skipped when it
+// matches what was last bound, and issued otherwise.  Everything is invalidated at dx11_NewFrame().
+
+static const int NullVertexSlots            = 16;
+static const int NullConstantBufferSlots    = 14;
+static const int NullShaderResourceSlots    = 16;
+
+// constant slices share ring chunks, so bindings differ by offset as well.
+struct NullConstantBinding
+{
+    sptr            object;
+    int             offset;
+
+    bool operator==(const NullConstantBinding& right) const {
+        return (object == right.object) && (offset == right.offset);
+    }
+};
+
+struct NullPipelineState
+{
+    sptr            vertexBuffers       [NullVertexSlots];
+    u64             vertexStrideOffset  [NullVertexSlots];
+    NullConstantBinding constantBuffers [NullConstantBufferSlots];
+    sptr            shaderResources     [NullShaderResourceSlots];
+    sptr            indexBuffer;
+    u64             indexFormatOffset;
+    u64             inputLayoutHash;
+    sptr            shaderVS;
+    sptr            shaderFS;
+    u32             rasterState;
+    int             primType;
+
+    void Invalidate() {
+        memset(this, 0xff, sizeof(*this));
+    }
+};
+
+static NullPipelineState        s_bound;
+static const GPU_InputDesc*     s_CurrentInputDesc  = nullptr;
+static const GPU_ShaderVS*      s_CurrentShaderVS   = nullptr;
+static const GPU_ShaderFS*      s_CurrentShaderFS   = nullptr;
+static int                      s_dyn_bound         [NullVertexSlots];      // dyn buffer idx+1, for update checks
+
+static GPU_PipelineStats        s_stats_frame       = {};
+static GPU_PipelineStats        s_stats_last        = {};
+static xSpinLock                s_stats_lock;
+
+template< typename T >
+static __ai bool null_UpdateBound(T& bound, const T& value)
+{
+    if (bound == value) {
+        s_stats_frame.bindsSkipped += 1;
+        return false;
+    }
+    bound = value;
+    s_stats_frame.bindsIssued += 1;
+    return true;
+}
+
+GPU_PipelineStats dx11_GetPipelineStats()
+{
+    xScopedSpinLock lock(s_stats_lock);
+    return s_stats_last;
+}
+
+static void null_PreDrawPrep(int instanceCount)
+{
+    throw_abort_on(!s_CurrentInputDesc, "No input layout has been bound to the pipeline.");
+    throw_abort_on(!s_CurrentShaderVS,  "No VS shader is bound to the draw pipeline.");
+    throw_abort_on(!s_CurrentShaderFS,  "No FS shader is bound to the draw pipeline.");
+
+    null_Resolve(s_CurrentShaderVS->m_driverBinary, NullObj_ShaderVS, "VS shader");
+    null_Resolve(s_CurrentShaderFS->m_driverBinary, NullObj_ShaderFS, "FS shader");
+
+    for (int i=0; i<NullVertexSlots; ++i) {
+        if (!s_dyn_bound[i]) continue;
+        auto  dynidx = s_dyn_bound[i] - 1;
+        const auto& sched = s_DynBufferPool[dynidx].m_sched;
+        if (g_gpu_host_framecount - sched.m_upload_frame >= sched.m_interval) {
+            const auto& buffer = s_DynBufferPool[dynidx].m_instances[0];
+            warn_host("GPU_DynVsBuffer was not updated %s. id=%d%s%s",
+                (sched.m_interval > 1) ? "within its update interval" : "this frame", dynidx,
+                buffer.m_name[0] ? " name=" : "",
+                buffer.m_name[0] ? buffer.m_name : ""
+            );
+        }
+    }
+
+    null_UpdateBound(s_bound.inputLayoutHash,   s_CurrentInputDesc->GetHash());
+    null_UpdateBound(s_bound.shaderVS,          s_CurrentShaderVS->m_driverBinary);
+    null_UpdateBound(s_bound.shaderFS,          s_CurrentShaderFS->m_driverBinary);
+
+    s_stats_frame.draws     += 1;
+    s_stats_frame.instances += instanceCount;
+}
+
+// --------------------------------------------------------------------------------------
+//  Constant ring
+// --------------------------------------------------------------------------------------
+// Same scheme as the DX11 backend: chunks per back buffer, sub-allocated through GPU_RingAllocator and
+// reset when the back buffer comes around again.  Chunks are ordinary constant buffer objects, so
+// slice binds are validated and filtered like any other constant buffer bind.
+
+static const int NullConstantRingChunkSize  = 65536;
+static const int NullConstantRingAlignment  = 256;
+
+struct NullConstantRing
+{
+    GPU_RingAllocator           alloc;
+    std::vector<NullObject*>    chunks;
+};
+
+static NullConstantRing         s_cbRing            [BackBufferCount];
+
+// --------------------------------------------------------------------------------------
+//  Transient vertex heap
+// --------------------------------------------------------------------------------------
+// Same scheme again, for dx11_SetTransientVertexBuffer().  Chunks are vertex buffer objects, and are
+// sized as on DX11 so that uploads too large for the device are caught here as well.
+
+static const int NullTransientHeapChunkSize = _4mb;
+static const int NullTransientHeapAlignment = 16;
+
+struct NullTransientHeap
+{
+    GPU_RingAllocator           alloc;
+    std::vector<NullObject*>    chunks;
+};
+
+static NullTransientHeap        s_vbHeap            [BackBufferCount];
+
+// --------------------------------------------------------------------------------------
+//  Device and frame
+// --------------------------------------------------------------------------------------
+
+void dx11_InitDevice()
+{
+    s_DynBufferPool.clear();
+    s_DynBufferFreeList = -1;
+
+    // There is no window to size the client area from.  Hosts may still assign g_client_size_pix
+    // beforehand to emulate a specific resolution.
+    if (g_client_size_pix.cmp_any() <= 0) {
+        g_client_size_pix = { 1280, 720 };
+    }
+    g_client_aspect_ratio = float(g_client_size_pix.x) / float(g_client_size_pix.y);
+
+    g_gpu_BackBuffer = GPU_RenderTarget(null_CreateObject(NullObj_Texture, 0, nullptr));
+    for (auto& ring : s_cbRing) {
+        ring.alloc.Init(NullConstantRingChunkSize, NullConstantRingAlignment);
+    }
+    for (auto& heap : s_vbHeap) {
+        heap.alloc.Init(NullTransientHeapChunkSize, NullTransientHeapAlignment);
+    }
+    s_bound.Invalidate();
+    s_device_ready = true;
+
+    ImGui_ImplDX11_Init(nullptr, nullptr);
+    ImGui_ImplDX11_CreateDeviceObjects();
+}
+
+void dx11_CleanupDevice()
+{
+    if (!s_device_ready) return;
+
+    ImGui_ImplDX11_Shutdown();
+
+    for (const auto* obj : s_null_objects) {
+        xFree(((NullObject*)obj)->data);
+        xFree((void*)obj);
+    }
+    s_null_objects.clear();
+    s_DynBufferPool.clear();
+    s_DynBufferFreeList = -1;
+
+    // chunks are freed along with the other objects, above
+    for (auto& ring : s_cbRing) {
+        ring.chunks.clear();
+    }
+    for (auto& heap : s_vbHeap) {
+        heap.chunks.clear();
+    }
+
+    g_gpu_BackBuffer = GPU_RenderTarget();
+    s_device_ready   = false;
+}
+
+void dx11_NewFrame()
+{
+    s_CurrentShaderVS = {};
+    s_CurrentShaderFS = {};
+    s_bound.Invalidate();
+    xMemZero(s_dyn_bound);
+    s_cbRing[s_curBufferIdx].alloc.Reset();
+    s_vbHeap[s_curBufferIdx].alloc.Reset();
+}
+
+void dx11_BeginFrameDrawing()
+{
+}
+
+void dx11_SubmitFrameAndSwap()
+{
+    s_curBufferIdx = (s_curBufferIdx+1) % BackBufferCount;
+
+    s_stats_frame.frame = g_gpu_host_framecount;
+    {
+        xScopedSpinLock lock(s_stats_lock);
+        s_stats_last = s_stats_frame;
+    }
+    s_stats_frame = {};
+
+    ++g_gpu_host_framecount;
+}
+
+void dx11_ClearRenderTarget(const GPU_RenderTarget& target, const float4& color)
+{
+    null_Resolve(target.m_driverData, NullObj_Texture, "RenderTarget");
+}
+
+void dx11_InputLayoutCache_DisposeAll()
+{
+    // layouts aren't resolved against shaders, so there's nothing cached.
+}
+
+// --------------------------------------------------------------------------------------
+//  Resource creation
+// --------------------------------------------------------------------------------------
+
+void dx11_CreateDynamicVertexBuffer(GPU_DynVsBuffer& dest, int bufferSizeInBytes, const char* diag_name, int updateInterval)
+{
+    bug_on(updateInterval < 1, "Invalid dynamic buffer update interval=%d", updateInterval);
+    bug_on(bufferSizeInBytes <= 0);
+
+    int bufferIdx = dest.m_buffer_idx;
+
+    if (bufferIdx < 0) {
+        if (s_DynBufferFreeList >= 0) {
+            bufferIdx           = s_DynBufferFreeList;
+            s_DynBufferFreeList = s_DynBufferPool[bufferIdx].m_next_free;
+        }
+        else {
+            bufferIdx = (int)s_DynBufferPool.size();
+            s_DynBufferPool.emplace_back();
+        }
+        xMemZero(s_DynBufferPool[bufferIdx]);
+        s_DynBufferPool[bufferIdx].m_next_free = -1;
+    }
+
+    auto& slot      = s_DynBufferPool[bufferIdx];
+    auto& sched     = slot.m_sched;
+    int   instances = GPU_GetDynBufferInstanceCount(BackBufferCount, updateInterval);
+
+    // existing buffers are kept when they're already big enough, as on DX11.
+    bool  realloc   = (bufferSizeInBytes > slot.m_capacity) || (instances != sched.m_instances);
+
+    sched.m_interval        = updateInterval;
+    sched.m_instances       = instances;
+    sched.m_current         = instances - 1;            // first upload rotates to instance 0
+    sched.m_upload_frame    = g_gpu_host_framecount - updateInterval;
+
+    if (realloc) {
+        for (int i=0; i<BackBufferCount; ++i) {
+            auto& buffer = slot.m_instances[i];
+            null_Release(buffer.m_object);
+            if (i >= instances) continue;
+            buffer.m_object = null_CreateObject(NullObj_DynVertexBuffer, bufferSizeInBytes, nullptr);
+        }
+        slot.m_capacity = bufferSizeInBytes;
+    }
+
+    if (diag_name) {
+        for (int i=0; i<instances; ++i) {
+            xStrCopy(slot.m_instances[i].m_name, sizeof(slot.m_instances[i].m_name), diag_name);
+        }
+    }
+
+    dest.m_buffer_idx = bufferIdx;
+}
+
+void GPU_DynVsBuffer::Dispose()
+{
+    if (!IsValid()) return;
+
+    auto& slot = s_DynBufferPool[m_buffer_idx];
+    for (auto& buffer : slot.m_instances) {
+        null_Release(buffer.m_object);
+    }
+    xMemZero(slot);
+    slot.m_next_free    = s_DynBufferFreeList;
+    s_DynBufferFreeList = m_buffer_idx;
+    m_buffer_idx        = -1;
+}
+
+void GPU_VertexBuffer::Dispose()
+{
+    null_Release(m_driverData);
+}
+
+void dx11_CreateStaticMesh(GPU_VertexBuffer& dest, void* vertexData, int itemSizeInBytes, int vertexCount)
+{
+    dest.Dispose();
+    dest.m_driverData = (sptr)null_CreateObject(NullObj_VertexBuffer, itemSizeInBytes * vertexCount, vertexData);
+}
+
+void dx11_CreateIndexBuffer(GPU_IndexBuffer& dest, void* indexBuffer, int bufferSize)
+{
+    null_Release(dest.m_driverData);
+    dest.m_driverData = (sptr)null_CreateObject(NullObj_IndexBuffer, bufferSize, indexBuffer);
+}
+
+void dx11_CreateConstantBuffer(GPU_ConstantBuffer& dest, int bufferSize)
+{
+    null_Release(dest.m_driverData);
+    dest.m_driverData = (sptr)null_CreateObject(NullObj_ConstantBuffer, (bufferSize + 15) & ~15, nullptr);
+}
+
+void dx11_CreateTexture2D(GPU_TextureResource2D& dest, const xBitmapDataRO& bitmap, GPU_ResourceFmt format)
+{
+    dx11_CreateTexture2D(dest, bitmap.buffer, bitmap.size.x, bitmap.size.y, format);
+}
+
+void dx11_CreateTexture2D(GPU_TextureResource2D& dest, const void* src_bitmap_data, const int2& size, GPU_ResourceFmt format)
+{
+    dx11_CreateTexture2D(dest, src_bitmap_data, size.x, size.y, format);
+}
+
+void dx11_CreateTexture2D(GPU_TextureResource2D& dest, const void* src_bitmap_data, int width, int height, GPU_ResourceFmt format)
+{
+    null_Release(dest.m_driverData_tex);
+
+    // same pitch rules as the DX11 backend.
+    int bytespp = 4;
+    if (format == GPU_ResourceFmt_R32G32_UINT ) bytespp = 8;
+    if (format == GPU_ResourceFmt_R32G32_FLOAT) bytespp = 8;
+
+    auto* texture = null_CreateObject(NullObj_Texture, width * height * bytespp, src_bitmap_data);
+
+    // texture and view are the same object; only the view is bound.
+    dest.m_driverData_tex   = (sptr)texture;
+    dest.m_driverData_view  = (sptr)texture;
+}
+
+// Shaders aren't compiled.  The source file is still required to exist, so that missing or misnamed
+// shaders fail headless runs the same way they'd fail on a device.
+static bool null_TryLoadShader(sptr& dest, NullObjectType type, const xString& srcfile, const char* entryPointFn)
+{
+    bug_on( !entryPointFn || !entryPointFn[0] );
+
+    null_Release(dest);
+    if (!xFileStat(srcfile).IsFile()) {
+        warn_host("[null-gpu] Shader source not found: %s", srcfile.c_str());
+        return false;
+    }
+
+    dest = (sptr)null_CreateObject(type, 0, nullptr);
+    return true;
+}
+
+bool dx11_TryLoadShaderVS(GPU_ShaderVS& dest, const xString& srcfile, const char* entryPointFn)
+{
+    return null_TryLoadShader(dest.m_driverBinary, NullObj_ShaderVS, srcfile, entryPointFn);
+}
+
+bool dx11_TryLoadShaderFS(GPU_ShaderFS& dest, const xString& srcfile, const char* entryPointFn)
+{
+    return null_TryLoadShader(dest.m_driverBinary, NullObj_ShaderFS, srcfile, entryPointFn);
+}
+
+void dx11_LoadShaderVS(GPU_ShaderVS& dest, const xString& srcfile, const char* entryPointFn)
+{
+    auto result = dx11_TryLoadShaderVS(dest, srcfile, entryPointFn);
+    bug_on_qa(!result, "Errors during shader compiler and no error handler is registered.");
+}
+
+void dx11_LoadShaderFS(GPU_ShaderFS& dest, const xString& srcfile, const char* entryPointFn)
+{
+    auto result = dx11_TryLoadShaderFS(dest, srcfile, entryPointFn);
+    bug_on_qa(!result, "Errors during shader compiler and no error handler is registered.");
+}
+
+// Shaders aren't compiled, so there is nothing to prefetch.
+void dx11_PrefetchShaders(const GPU_ShaderPrefetch* shaders, int count)
+{
+}
+
+// --------------------------------------------------------------------------------------
+//  Uploads
+// --------------------------------------------------------------------------------------
+
+void dx11_UploadDynamicBufferData(const GPU_DynVsBuffer& src, const void* srcData, int sizeInBytes)
+{
+    bug_on(!srcData);
+    bug_on(!src.IsValid());
+    if (!src.IsValid()) return;
+
+    auto& slot  = s_DynBufferPool[src.m_buffer_idx];
+    auto& sched = slot.m_sched;
+    if (sched.m_upload_frame == g_gpu_host_framecount) {
+        const auto& named = slot.m_instances[0];
+        log_perf("[null-gpu] Dynamic buffer data was already updated this frame [size=%d%s%s]", sizeInBytes,
+           named.m_name[0] ? " name="      : "",
+           named.m_name[0] ? named.m_name : ""
+        );
+    }
+    else if (sched.m_interval > 1) {
+        sched.m_current = (sched.m_current + 1) % sched.m_instances;
+    }
+    sched.m_upload_frame = g_gpu_host_framecount;
+
+    auto& buffer = slot.m_instances[null_GetDynBufferInstance(src.m_buffer_idx)];
+    bug_on_qa(!buffer.m_object, "Dynamic buffer id=%d has not been created.", src.m_buffer_idx);
+    bug_on_qa(sizeInBytes > buffer.m_object->size, "Dynamic buffer upload overflow [size=%d capacity=%d]", sizeInBytes, buffer.m_object->size);
+
+    xMemCopy(buffer.m_object->data, srcData, sizeInBytes);
+    s_stats_frame.dynamicBufferBytes += sizeInBytes;
+}
+
+void dx11_UpdateConstantBuffer(const GPU_ConstantBuffer& buffer, const void* data)
+{
+    auto* obj = (NullObject*)null_Resolve(buffer.m_driverData, NullObj_ConstantBuffer, "ConstantBuffer");
+    if (!obj) return;
+
+    xMemCopy(obj->data, data, obj->size);
+    s_stats_frame.constantBufferBytes += obj->size;
+}
+
+GPU_ConstantSlice dx11_ReserveConstants(int sizeInBytes)
+{
+    auto&   ring        = s_cbRing[s_curBufferIdx];
+    int     size        = (sizeInBytes + 15) & ~15;
+    int     offset      = 0;
+    int     chunkIdx    = ring.alloc.Alloc(size, offset);
+
+    while (chunkIdx >= (int)ring.chunks.size()) {
+        ring.chunks.push_back(null_CreateObject(NullObj_ConstantBuffer, NullConstantRingChunkSize, nullptr));
+    }
+
+    auto*   chunk       = ring.chunks[chunkIdx];
+    GPU_ConstantSlice slice;
+    slice.data          = chunk->data + offset;
+    slice.m_driverData  = (sptr)chunk;
+    slice.offset        = offset;
+    slice.size          = size;
+    return slice;
+}
+
+// --------------------------------------------------------------------------------------
+//  Binds and draws
+// --------------------------------------------------------------------------------------
+
+void dx11_SetInputLayout(const GPU_InputDesc& layout)
+{
+    bug_on_qa(!layout.GetHash(), "Binding an empty input layout.");
+    s_CurrentInputDesc = &layout;
+}
+
+void dx11_SetRasterState(GpuRasterFillMode fill, GpuRasterCullMode cull, GpuRasterScissorMode scissor)
+{
+    if (g_gpu_ForceWireframe) {
+        fill = GPU_Fill_Wireframe;
+    }
+    null_UpdateBound(s_bound.rasterState, u32((fill << 16) | (cull << 8) | scissor));
+}
+
+void dx11_SetPrimType(GpuPrimitiveType primType)
+{
+    bug_on_qa(primType < GPU_PRIM_POINTLIST || primType > GPU_PRIM_TRIANGLESTRIP, "Invalid primitive type=%d", primType);
+    null_UpdateBound(s_bound.primType, (int)primType);
+}
+
+void dx11_BindConstantBuffer(const GPU_ConstantBuffer& buffer, int startSlot)
+{
+    bug_on(startSlot < 0 || startSlot >= NullConstantBufferSlots);
+    null_Resolve(buffer.m_driverData, NullObj_ConstantBuffer, "ConstantBuffer");
+    null_UpdateBound(s_bound.constantBuffers[startSlot], NullConstantBinding{ buffer.m_driverData, 0 });
+}
+
+void dx11_BindConstantSlice(const GPU_ConstantSlice& slice, int startSlot)
+{
+    bug_on(startSlot < 0 || startSlot >= NullConstantBufferSlots);
+    bug_on(!slice.IsValid(), "Binding an unreserved constant slice.");
+    null_Resolve(slice.m_driverData, NullObj_ConstantBuffer, "ConstantSlice");
+    null_UpdateBound(s_bound.constantBuffers[startSlot], NullConstantBinding{ slice.m_driverData, slice.offset });
+    s_stats_frame.constantBufferBytes += slice.size;
+}
+
+void dx11_BindShaderResource(const GPU_ShaderResource& res, int startSlot)
+{
+    bug_on(startSlot < 0);
+    null_Resolve(res.m_driverData_view, NullObj_Texture, "ShaderResource");
+    if (startSlot < NullShaderResourceSlots) {
+        null_UpdateBound(s_bound.shaderResources[startSlot], res.m_driverData_view);
+    }
+    else {
+        s_stats_frame.bindsIssued += 1;
+    }
+}
+
+void dx11_BindShaderVS(const GPU_ShaderVS& vs)
+{
+    bug_on_qa(!vs.m_driverBinary, "Uninitialized VS shader resource.");
+    s_CurrentShaderVS = &vs;
+}
+
+void dx11_BindShaderFS(const GPU_ShaderFS& fs)
+{
+    bug_on_qa(!fs.m_driverBinary, "Uninitialized FS shader resource.");
+    s_CurrentShaderFS = &fs;
+}
+
+void dx11_SetVertexBuffer(const GPU_DynVsBuffer& src, int shaderSlot, int _stride, int _offset)
+{
+    bug_on(!src.IsValid());
+    if (!src.IsValid()) return;
+    bug_on(shaderSlot < 0 || shaderSlot >= NullVertexSlots);
+
+    auto& buffer = s_DynBufferPool[src.m_buffer_idx].m_instances[null_GetDynBufferInstance(src.m_buffer_idx)];
+    bug_on_qa(!buffer.m_object, "Dynamic buffer id=%d has not been created.", src.m_buffer_idx);
+
+    s_dyn_bound[shaderSlot] = src.m_buffer_idx+1;
+    u64 strideOffset = (u64(u32(_stride)) << 32) | u32(_offset);
+    if (s_bound.vertexBuffers[shaderSlot] == (sptr)buffer.m_object && s_bound.vertexStrideOffset[shaderSlot] == strideOffset) {
+        s_stats_frame.bindsSkipped += 1;
+        return;
+    }
+    s_bound.vertexBuffers       [shaderSlot] = (sptr)buffer.m_object;
+    s_bound.vertexStrideOffset  [shaderSlot] = strideOffset;
+    s_stats_frame.bindsIssued += 1;
+}
+
+void dx11_SetVertexBuffer(const GPU_VertexBuffer& vbuffer, int shaderSlot, int _stride, int _offset)
+{
+    bug_on(shaderSlot < 0 || shaderSlot >= NullVertexSlots);
+    null_Resolve(vbuffer.m_driverData, NullObj_VertexBuffer, "VertexBuffer");
+
+    s_dyn_bound[shaderSlot] = 0;
+    u64 strideOffset = (u64(u32(_stride)) << 32) | u32(_offset);
+    if (s_bound.vertexBuffers[shaderSlot] == vbuffer.m_driverData && s_bound.vertexStrideOffset[shaderSlot] == strideOffset) {
+        s_stats_frame.bindsSkipped += 1;
+        return;
+    }
+    s_bound.vertexBuffers       [shaderSlot] = vbuffer.m_driverData;
+    s_bound.vertexStrideOffset  [shaderSlot] = strideOffset;
+    s_stats_frame.bindsIssued += 1;
+}
+
+void dx11_SetTransientVertexBuffer(const void* srcData, int sizeInBytes, int shaderSlot, int _stride)
+{
+    bug_on(!srcData);
+    bug_on(shaderSlot < 0 || shaderSlot >= NullVertexSlots);
+    x_abort_on(sizeInBytes > NullTransientHeapChunkSize, "Transient vertex upload is too large [size=%d max=%d]",
+        sizeInBytes, NullTransientHeapChunkSize
+    );
+
+    auto&   heap        = s_vbHeap[s_curBufferIdx];
+    int     offset      = 0;
+    int     chunkIdx    = heap.alloc.Alloc(sizeInBytes, offset);
+
+    while (chunkIdx >= (int)heap.chunks.size()) {
+        heap.chunks.push_back(null_CreateObject(NullObj_VertexBuffer, NullTransientHeapChunkSize, nullptr));
+    }
+
+    auto*   chunk       = heap.chunks[chunkIdx];
+    xMemCopy(chunk->data + offset, srcData, sizeInBytes);
+    s_stats_frame.transientBufferBytes += sizeInBytes;
+
+    s_dyn_bound[shaderSlot] = 0;
+    u64 strideOffset = (u64(u32(_stride)) << 32) | u32(offset);
+    if (s_bound.vertexBuffers[shaderSlot] == (sptr)chunk && s_bound.vertexStrideOffset[shaderSlot] == strideOffset) {
+        s_stats_frame.bindsSkipped += 1;
+        return;
+    }
+    s_bound.vertexBuffers       [shaderSlot] = (sptr)chunk;
+    s_bound.vertexStrideOffset  [shaderSlot] = strideOffset;
+    s_stats_frame.bindsIssued += 1;
+}
+
+void dx11_SetIndexBuffer(const GPU_IndexBuffer& indexBuffer, int bitsPerIndex, int offset)
+{
+    switch (bitsPerIndex) {
+        case 8:
+        case 16:
+        case 32:    break;
+        default:    unreachable("Invalid parameter 'bitsPerindex=%d'", bitsPerIndex);
+    }
+    null_Resolve(indexBuffer.m_driverData, NullObj_IndexBuffer, "IndexBuffer");
+
+    u64 formatOffset = (u64(u32(bitsPerIndex)) << 32) | u32(offset);
+    if (s_bound.indexBuffer == indexBuffer.m_driverData && s_bound.indexFormatOffset == formatOffset) {
+        s_stats_frame.bindsSkipped += 1;
+        return;
+    }
+    s_bound.indexBuffer         = indexBuffer.m_driverData;
+    s_bound.indexFormatOffset   = formatOffset;
+    s_stats_frame.bindsIssued += 1;
+}
+
+void dx11_Draw(int indexCount, int startVertLoc)
+{
+    null_PreDrawPrep(1);
+}
+
+void dx11_DrawIndexed(int indexCount, int startIndexLoc, int baseVertLoc)
+{
+    null_PreDrawPrep(1);
+}
+
+void dx11_DrawInstanced(int vertsPerInstance, int instanceCount, int startVertLoc, int startInstanceLoc)
+{
+    null_PreDrawPrep(instanceCount);
+}
+
+void dx11_DrawIndexedInstanced(int indexesPerInstance, int instanceCount, int startIndex, int baseVertex, int startInstance)
+{
+    null_PreDrawPrep(instanceCount);
+}
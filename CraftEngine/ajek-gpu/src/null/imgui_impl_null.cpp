@@ -0,0 +1,56 @@
+// ImGui binding for the null GPU backend (see dx11-null.cpp).
+// Implements the imgui_impl_dx11.h interface so that hosts don't need to know which backend is linked.
+// The font atlas is still built, since ImGui::NewFrame() requires it, but draw data is discarded.
+
+#include "imgui.h"
+#include "imgui_impl_dx11.h"
+
+static bool     g_FontsCreated = false;
+
+void ImGui_ImplDX11_RenderDrawLists(ImDrawData* draw_data)
+{
+    // The DX11 backend renders with its own pipeline state, outside of GPU_PipelineStats, so there
+    // is nothing to count here either.
+    (void)draw_data;
+}
+
+bool    ImGui_ImplDX11_CreateDeviceObjects()
+{
+    if (g_FontsCreated)
+        ImGui_ImplDX11_InvalidateDeviceObjects();
+
+    ImGuiIO& io = ImGui::GetIO();
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+
+    // Any non-null identifier will do, nothing is ever sampled.
+    io.Fonts->TexID = (void *)&g_FontsCreated;
+    g_FontsCreated = true;
+    return true;
+}
+
+void    ImGui_ImplDX11_InvalidateDeviceObjects()
+{
+    if (!g_FontsCreated)
+        return;
+
+    ImGui::GetIO().Fonts->TexID = NULL;
+    g_FontsCreated = false;
+}
+
+bool    ImGui_ImplDX11_Init(ID3D11Device* device, ID3D11DeviceContext* device_context)
+{
+    (void)device;
+    (void)device_context;
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.RenderDrawListsFn = NULL;    // draw data is submitted by the scene via ImGui_ImplDX11_RenderDrawLists().
+    return true;
+}
+
+void ImGui_ImplDX11_Shutdown()
+{
+    ImGui_ImplDX11_InvalidateDeviceObjects();
+    ImGui::Shutdown();
+}
@@ -0,0 +1,1240 @@
+#include "x-types.h"
+#include "x-stl.h"
+#include "x-string.h"
+#include "x-stdlib.h"
+#include "x-stdalloc.h"
+#include "x-stdfile.h"
+#include "x-thread.h"
+#include "x-workers.h"
+#include "x-assertion.h"
+#include "x-ThrowContext.h"
+#include "x-png-encode.h"
+#include "x-png-decode.h"
+
+#include "v-float.h"
+#include "x-gpu-ifc.h"
+#include "x-gpu-ring.h"
+#include "x-gpu-soft.h"
+
+#include "imgui_impl_dx11.h"
+
+#include "soft-raster.h"
+#include "soft-shaders.h"
+
+#include <unordered_set>
+
+// --------------------------------------------------------------------------------------
+//  Soft GPU Backend
+// --------------------------------------------------------------------------------------
+// CPU rasterizer implementing the x-gpu-ifc.h interface, for golden-image and frame-time tests on
+// machines without a GPU, and for headless capture of map previews.  Link this in place of the msw
+// backend, along with null/imgui_impl_null.cpp (ImGui draw data is not rendered).
+//
+// Only the feature set used by the engine is supported:
+//  * Indexed and non-indexed triangle lists and strips, instanced or not.
+//  * The programs in TileMap.fx, Sprite.fx and SpriteInstanced.fx, via their CPU equivalents in
+//    soft-shaders.cpp.  Shaders without an equivalent load fine but their draws are skipped.
+//  * R8G8B8A8 textures bound to t0, point sampled.  Everything draws alpha blended.
+//  * Back/front face culling.  Wireframe fill and scissor are ignored.
+//
+// Vertex work is done at draw time, so constant and vertex buffer contents are captured exactly
+// as a device would capture them.  Rasterization is deferred until the frame is submitted (or the
+// back buffer is read) and is then done tile-parallel, see soft-raster.cpp.
+//
+// Handles, validation, and GPU_PipelineStats behave the same as the null backend.
+//
+
+static const int BackBufferCount = 3;
+
+int2                    g_client_size_pix       = {0, 0};
+float                   g_client_aspect_ratio   = 1.0f;
+GPU_RenderTarget        g_gpu_BackBuffer;
+int                     g_gpu_host_framecount   = 0;
+
+bool                    g_gpu_soft_CaptureFrames = false;
+
+xString                 g_gpu_soft_GoldenImage;
+int                     g_gpu_soft_GoldenFrame      = 0;
+int                     g_gpu_soft_GoldenTolerance  = 0;
+
+static SoftGoldenResult s_golden_result         = SoftGolden_Pending;
+
+static int              s_curBufferIdx          = 0;
+static bool             s_device_ready          = false;
+static SoftRasterizer   s_raster;
+
+enum SoftObjectType : u8 {
+    SoftObj_VertexBuffer,
+    SoftObj_IndexBuffer,
+    SoftObj_ConstantBuffer,
+    SoftObj_DynVertexBuffer,
+    SoftObj_Texture,
+    SoftObj_RenderTarget,
+    SoftObj_ShaderVS,
+    SoftObj_ShaderFS,
+};
+
+// Stand-in for any device object.  Handles (m_driverData and friends) point directly at these.
+struct SoftObject
+{
+    SoftObjectType      type;
+    int                 size;
+    u8*                 data;
+
+    int2                texSize;            // textures only
+    int                 texBytesPP;         // textures only
+    const SoftProgram*  program;            // shaders only, nullptr if there is no CPU equivalent
+};
+
+using SoftObjectSet = std::unordered_set<const void*, FunctHashAlignedPtr>;
+static SoftObjectSet    s_soft_objects;
+
+struct SoftDynBufferItem
+{
+    SoftObject*         m_object;
+    char                m_name[30];
+};
+
+// Same schedule as the DX11 backend: buffers updated every frame use the instance matching s_curBufferIdx,
+// sparse buffers rotate through their first m_instances rows with each frame's first upload.
+struct SoftDynBufferSchedule
+{
+    int                 m_interval;
+    int                 m_instances;
+    int                 m_current;
+    int                 m_upload_frame;
+};
+
+// Same handle pool as the DX11 backend: disposed handles are chained through m_next_free and reused
+// before the pool grows.
+struct SoftDynBufferSlot
+{
+    SoftDynBufferItem       m_instances[BackBufferCount];
+    SoftDynBufferSchedule   m_sched;
+    int                     m_capacity;
+    int                     m_next_free;
+};
+
+static std::vector<SoftDynBufferSlot>   s_DynBufferPool;
+static int                              s_DynBufferFreeList = -1;
+
+static __ai int soft_GetDynBufferInstance(int bufferIdx)
+{
+    const auto& sched = s_DynBufferPool[bufferIdx].m_sched;
+    return (sched.m_interval > 1) ? sched.m_current : s_curBufferIdx;
+}
+
+static SoftObject* soft_CreateObject(SoftObjectType type, int size, const void* src)
+{
+    bug_on(size < 0);
+
+    auto* obj   = (SoftObject*)xMalloc(sizeof(SoftObject));
+    obj->type       = type;
+    obj->size       = size;
+    obj->data       = size ? (u8*)xMalloc(size) : nullptr;
+    obj->texSize    = {0, 0};
+    obj->texBytesPP = 0;
+    obj->program    = nullptr;
+    if (src && size) {
+        xMemCopy(obj->data, src, size);
+    }
+
+    s_soft_objects.insert(obj);
+    return obj;
+}
+
+static void soft_Unbind(const SoftObject* obj);
+
+template< typename T >
+static void soft_Release(T& handle)
+{
+    if (!handle) return;
+
+    auto* obj = (SoftObject*)handle;
+    auto  it  = s_soft_objects.find(obj);
+    if (it == s_soft_objects.end()) {
+        bug("Unmanaged soft GPU object @ %s", cPtrStr(obj, ""));
+    }
+    else {
+        // queued triangles sample texels directly out of the texture object.
+        if (obj->type == SoftObj_Texture) {
+            s_raster.Flush();
+        }
+        soft_Unbind(obj);
+        s_soft_objects.erase(it);
+        xFree(obj->data);
+        xFree(obj);
+    }
+    handle = 0;
+}
+
+// Returns the object behind a handle, reporting handles which have been released or which refer to
+// an object of the wrong type.
+static const SoftObject* soft_Resolve(sptr handle, SoftObjectType type, const char* what)
+{
+    bug_on_qa(!handle, "Uninitialized %s resource.", what);
+    if (!handle) return nullptr;
+
+    auto* obj = (const SoftObject*)handle;
+    if (s_soft_objects.find(obj) == s_soft_objects.end()) {
+        bug_qa("%s resource has been deinitialized since being created.", what);
+        return nullptr;
+    }
+    bug_on_qa(obj->type != type, "%s resource handle refers to an object of another type (type=%d).", what, obj->type);
+    return (obj->type == type) ? obj : nullptr;
+}
+
+// --------------------------------------------------------------------------------------
+//  Pipeline state and stats
+// --------------------------------------------------------------------------------------
+// Same filtering as the null backend.  Unlike the null backend, the soft backend needs the actual
+// stride/offset and buffer contents of every bound slot, which are tracked separately in s_streams
+// since they must be valid regardless of whether a bind was filtered.
+
+static const int SoftVertexSlots            = 16;
+static const int SoftConstantBufferSlots    = 14;
+static const int SoftShaderResourceSlots    = 16;
+
+// constant slices share ring chunks, so bindings differ by offset as well.
+struct SoftConstantBinding
+{
+    sptr            object;
+    int             offset;
+
+    bool operator==(const SoftConstantBinding& right) const {
+        return (object == right.object) && (offset == right.offset);
+    }
+};
+
+struct SoftPipelineState
+{
+    sptr            vertexBuffers       [SoftVertexSlots];
+    u64             vertexStrideOffset  [SoftVertexSlots];
+    SoftConstantBinding constantBuffers [SoftConstantBufferSlots];
+    sptr            shaderResources     [SoftShaderResourceSlots];
+    sptr            indexBuffer;
+    u64             indexFormatOffset;
+    u64             inputLayoutHash;
+    sptr            shaderVS;
+    sptr            shaderFS;
+    u32             rasterState;
+    int             primType;
+
+    void Invalidate() {
+        memset(this, 0xff, sizeof(*this));
+    }
+};
+
+struct SoftVertexStream
+{
+    const SoftObject*   object;
+    int                 stride;
+    int                 offset;
+};
+
+struct SoftConstantStream
+{
+    const SoftObject*   object;
+    int                 offset;
+    int                 size;
+};
+
+static SoftPipelineState        s_bound;
+static const GPU_InputDesc*     s_CurrentInputDesc  = nullptr;
+static const GPU_ShaderVS*      s_CurrentShaderVS   = nullptr;
+static const GPU_ShaderFS*      s_CurrentShaderFS   = nullptr;
+static int                      s_dyn_bound         [SoftVertexSlots];      // dyn buffer idx+1, for update checks
+
+static SoftVertexStream         s_streams           [SoftVertexSlots];
+static SoftConstantStream       s_constantBuffers   [SoftConstantBufferSlots];
+static const SoftObject*        s_texture0          = nullptr;
+static const SoftObject*        s_indexBuffer       = nullptr;
+static int                      s_indexBits         = 16;
+static int                      s_indexOffset       = 0;
+static GpuPrimitiveType         s_primType          = GPU_PRIM_TRIANGLELIST;
+static SoftCullMode             s_cullMode          = SoftCull_None;
+
+static GPU_PipelineStats        s_stats_frame       = {};
+static GPU_PipelineStats        s_stats_last        = {};
+static xSpinLock                s_stats_lock;
+
+template< typename T >
+static __ai bool soft_UpdateBound(T& bound, const T& value)
+{
+    if (bound == value) {
+        s_stats_frame.bindsSkipped += 1;
+        return false;
+    }
+    bound = value;
+    s_stats_frame.bindsIssued += 1;
+    return true;
+}
+
+GPU_PipelineStats dx11_GetPipelineStats()
+{
+    xScopedSpinLock lock(s_stats_lock);
+    return s_stats_last;
+}
+
+static void soft_ResetStreams()
+{
+    xMemZero(s_streams);
+    xMemZero(s_constantBuffers);
+    s_texture0      = nullptr;
+    s_indexBuffer   = nullptr;
+}
+
+// Drops an object which is being released from the draw state, so that draws issued afterward
+// report a missing bind rather than reading freed memory.
+static void soft_Unbind(const SoftObject* obj)
+{
+    for (auto& stream : s_streams) {
+        if (stream.object == obj) stream.object = nullptr;
+    }
+    for (auto& cb : s_constantBuffers) {
+        if (cb.object == obj) cb = {};
+    }
+    if (s_texture0    == obj) s_texture0    = nullptr;
+    if (s_indexBuffer == obj) s_indexBuffer = nullptr;
+}
+
+static void soft_PreDrawPrep(int instanceCount)
+{
+    throw_abort_on(!s_CurrentInputDesc, "No input layout has been bound to the pipeline.");
+    throw_abort_on(!s_CurrentShaderVS,  "No VS shader is bound to the draw pipeline.");
+    throw_abort_on(!s_CurrentShaderFS,  "No FS shader is bound to the draw pipeline.");
+
+    soft_Resolve(s_CurrentShaderVS->m_driverBinary, SoftObj_ShaderVS, "VS shader");
+    soft_Resolve(s_CurrentShaderFS->m_driverBinary, SoftObj_ShaderFS, "FS shader");
+
+    for (int i=0; i<SoftVertexSlots; ++i) {
+        if (!s_dyn_bound[i]) continue;
+        auto  dynidx = s_dyn_bound[i] - 1;
+        const auto& sched = s_DynBufferPool[dynidx].m_sched;
+        if (g_gpu_host_framecount - sched.m_upload_frame >= sched.m_interval) {
+            const auto& buffer = s_DynBufferPool[dynidx].m_instances[0];
+            warn_host("GPU_DynVsBuffer was not updated %s. id=%d%s%s",
+                (sched.m_interval > 1) ? "within its update interval" : "this frame", dynidx,
+                buffer.m_name[0] ? " name=" : "",
+                buffer.m_name[0] ? buffer.m_name : ""
+            );
+        }
+    }
+
+    soft_UpdateBound(s_bound.inputLayoutHash,   s_CurrentInputDesc->GetHash());
+    soft_UpdateBound(s_bound.shaderVS,          s_CurrentShaderVS->m_driverBinary);
+    soft_UpdateBound(s_bound.shaderFS,          s_CurrentShaderFS->m_driverBinary);
+
+    s_stats_frame.draws     += 1;
+    s_stats_frame.instances += instanceCount;
+}
+
+// --------------------------------------------------------------------------------------
+//  Vertex fetch
+// --------------------------------------------------------------------------------------
+
+struct SoftInputFetch
+{
+    int     slot;
+    int     byteOffset;
+    int     stepRate;                   // 0 for per-vertex data
+    GPU_ResourceFmt format;
+};
+
+static int soft_GetFormatSize(GPU_ResourceFmt format)
+{
+    switch (format) {
+        case GPU_ResourceFmt_R32G32B32A32_FLOAT:
+        case GPU_ResourceFmt_R32G32B32A32_UINT:
+        case GPU_ResourceFmt_R32G32B32A32_SINT:     return 16;
+        case GPU_ResourceFmt_R32G32B32_FLOAT:
+        case GPU_ResourceFmt_R32G32B32_UINT:
+        case GPU_ResourceFmt_R32G32B32_SINT:        return 12;
+        case GPU_ResourceFmt_R32G32_FLOAT:
+        case GPU_ResourceFmt_R32G32_UINT:
+        case GPU_ResourceFmt_R32G32_SINT:           return 8;
+        case GPU_ResourceFmt_R32_FLOAT:
+        case GPU_ResourceFmt_R32_UINT:
+        case GPU_ResourceFmt_R32_SINT:
+        case GPU_ResourceFmt_R8G8B8A8_UNORM:        return 4;
+        default:                                    return 0;
+    }
+}
+
+static void soft_FetchAttrib(GPU_ResourceFmt format, const u8* src, SoftAttrib& dest)
+{
+    dest.f[0] = 0.0f;
+    dest.f[1] = 0.0f;
+    dest.f[2] = 0.0f;
+    dest.f[3] = 1.0f;
+
+    switch (format) {
+        case GPU_ResourceFmt_R32G32B32A32_FLOAT:    memcpy(dest.f, src, 16);    break;
+        case GPU_ResourceFmt_R32G32B32_FLOAT:       memcpy(dest.f, src, 12);    break;
+        case GPU_ResourceFmt_R32G32_FLOAT:          memcpy(dest.f, src,  8);    break;
+        case GPU_ResourceFmt_R32_FLOAT:             memcpy(dest.f, src,  4);    break;
+
+        case GPU_ResourceFmt_R32G32B32A32_UINT:
+        case GPU_ResourceFmt_R32G32B32A32_SINT:     memcpy(dest.u, src, 16);    break;
+        case GPU_ResourceFmt_R32G32B32_UINT:
+        case GPU_ResourceFmt_R32G32B32_SINT:        dest.u[3] = 1; memcpy(dest.u, src, 12);  break;
+        case GPU_ResourceFmt_R32G32_UINT:
+        case GPU_ResourceFmt_R32G32_SINT:           dest.u[2] = 0; dest.u[3] = 1; memcpy(dest.u, src, 8);  break;
+        case GPU_ResourceFmt_R32_UINT:
+        case GPU_ResourceFmt_R32_SINT:              dest.u[1] = 0; dest.u[2] = 0; dest.u[3] = 1; memcpy(dest.u, src, 4);  break;
+
+        case GPU_ResourceFmt_R8G8B8A8_UNORM:
+            for (int i=0; i<4; ++i) {
+                dest.f[i] = src[i] * (1.0f / 255.0f);
+            }
+        break;
+
+        default: unreachable("Unsupported vertex format=%d", format);
+    }
+}
+
+// Resolves the program's inputs against the bound input layout.  Returns false (after reporting
+// why) if the layout lacks an input or uses a format the soft backend can't fetch.
+static bool soft_ResolveInputs(const SoftProgram& program, SoftInputFetch (&fetch)[SoftMaxInputs])
+{
+    const auto& layout = *s_CurrentInputDesc;
+
+    for (int n=0; n<program.numInputs; ++n) {
+        bool found = false;
+        for (int s=0; s<layout.GetSlotCount() && !found; ++s) {
+            const auto& slot   = layout.GetSlot(s);
+            int         offset = 0;
+            for (int i=0; i<slot.m_numElements; ++i) {
+                const auto& item = slot.m_Items[i];
+                int itemSize   = soft_GetFormatSize(item.Format);
+                int itemOffset = (item.ByteOffset < 0) ? offset : item.ByteOffset;
+                offset = itemOffset + itemSize;
+
+                if (strcmp(item.SemanticName, program.inputs[n])) continue;
+                if (!itemSize) {
+                    warn_host("[soft-gpu] %s: unsupported vertex format=%d for input %s", program.filename, item.Format, item.SemanticName);
+                    return false;
+                }
+                fetch[n].slot       = s;
+                fetch[n].byteOffset = itemOffset;
+                fetch[n].stepRate   = slot.m_InstanceDataStepRate;
+                fetch[n].format     = item.Format;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            warn_host("[soft-gpu] %s: bound input layout has no %s input.", program.filename, program.inputs[n]);
+            return false;
+        }
+        if (!s_streams[fetch[n].slot].object) {
+            warn_host("[soft-gpu] %s: no vertex buffer bound to slot %d.", program.filename, fetch[n].slot);
+            return false;
+        }
+    }
+    return true;
+}
+
+// --------------------------------------------------------------------------------------
+//  Draw execution
+// --------------------------------------------------------------------------------------
+
+struct SoftDrawVertex
+{
+    SoftVertex  vert;
+    bool        valid;              // false when behind the eye (w <= 0)
+    float       z;
+};
+
+static std::vector<SoftDrawVertex>  s_draw_verts;
+
+static bool soft_ReadIndex(int location, int& index)
+{
+    int bytes   = s_indexBits / 8;
+    int offset  = s_indexOffset + (location * bytes);
+    if (offset < 0 || offset + bytes > s_indexBuffer->size) return false;
+
+    const u8* src = s_indexBuffer->data + offset;
+    switch (s_indexBits) {
+        case 8:     index = *src;               break;
+        case 16:    index = *(const u16*)src;   break;
+        case 32:    index = *(const s32*)src;   break;
+    }
+    return true;
+}
+
+static void soft_AssembleTriangle(const SoftDrawVertex& a, const SoftDrawVertex& b, const SoftDrawVertex& c, const SoftTexture& tex, SoftPixelShader ps)
+{
+    if (!a.valid || !b.valid || !c.valid) return;
+
+    // triangles are never clipped, only rejected when entirely outside of the depth range.
+    if (a.z < 0.0f && b.z < 0.0f && c.z < 0.0f) return;
+    if (a.z > 1.0f && b.z > 1.0f && c.z > 1.0f) return;
+
+    s_raster.AddTriangle(a.vert, b.vert, c.vert, tex, ps, s_cullMode);
+}
+
+static void soft_ExecuteDraw(int vertsPerInstance, int instanceCount, int startLoc, int baseVertex, int startInstance, bool indexed)
+{
+    soft_PreDrawPrep(instanceCount);
+
+    const auto* vsObj = (const SoftObject*)s_CurrentShaderVS->m_driverBinary;
+    const auto* fsObj = (const SoftObject*)s_CurrentShaderFS->m_driverBinary;
+    if (!vsObj || !fsObj || !vsObj->program || !fsObj->program) return;      // reported at load
+
+    const auto& program = *vsObj->program;
+
+    if (s_primType != GPU_PRIM_TRIANGLELIST && s_primType != GPU_PRIM_TRIANGLESTRIP) {
+        warn_host("[soft-gpu] %s: only triangle lists and strips are rasterized (primType=%d).", program.filename, s_primType);
+        return;
+    }
+
+    if (indexed && !s_indexBuffer) {
+        warn_host("[soft-gpu] %s: indexed draw without an index buffer.", program.filename);
+        return;
+    }
+
+    if (!s_texture0) {
+        warn_host("[soft-gpu] %s: no texture bound to slot 0.", program.filename);
+        return;
+    }
+
+    if (s_texture0->texBytesPP != 4) {
+        warn_host("[soft-gpu] %s: only R8G8B8A8 textures can be sampled.", program.filename);
+        return;
+    }
+
+    SoftVsContext ctx;
+    for (int i=0; i<SoftMaxCBuffers; ++i) {
+        const auto& cb = s_constantBuffers[i];
+        ctx.cbuffer[i] = cb.object ? (cb.object->data + cb.offset) : nullptr;
+        ctx.cbsize [i] = cb.object ? cb.size : 0;
+        if ((program.cbuffersRequired & (1 << i)) && !cb.object) {
+            warn_host("[soft-gpu] %s: no constant buffer bound to b%d.", program.filename, i);
+            return;
+        }
+    }
+    ctx.texSize = s_texture0->texSize;
+
+    SoftInputFetch fetch[SoftMaxInputs];
+    if (!soft_ResolveInputs(program, fetch)) return;
+
+    SoftTexture tex;
+    tex.texels  = (const u32*)s_texture0->data;
+    tex.width   = s_texture0->texSize.x;
+    tex.height  = s_texture0->texSize.y;
+
+    const float halfW = g_client_size_pix.x * 0.5f;
+    const float halfH = g_client_size_pix.y * 0.5f;
+
+    s_draw_verts.resize(vertsPerInstance);
+
+    for (int inst=0; inst<instanceCount; ++inst) {
+        for (int v=0; v<vertsPerInstance; ++v) {
+            auto& dv = s_draw_verts[v];
+            dv.valid = false;
+
+            int vertexId = startLoc + v;
+            if (indexed && !soft_ReadIndex(vertexId, vertexId)) {
+                warn_host("[soft-gpu] %s: index read past the end of the index buffer.", program.filename);
+                return;
+            }
+            if (indexed) {
+                vertexId += baseVertex;
+            }
+
+            SoftAttrib inputs[SoftMaxInputs];
+            for (int n=0; n<program.numInputs; ++n) {
+                const auto& stream  = s_streams[fetch[n].slot];
+                int element = fetch[n].stepRate ? (startInstance + (inst / fetch[n].stepRate)) : vertexId;
+                int offset  = stream.offset + (element * stream.stride) + fetch[n].byteOffset;
+                if (offset < 0 || offset + soft_GetFormatSize(fetch[n].format) > stream.object->size) {
+                    warn_host("[soft-gpu] %s: vertex fetch of %s past the end of its buffer.", program.filename, program.inputs[n]);
+                    return;
+                }
+                soft_FetchAttrib(fetch[n].format, stream.object->data + offset, inputs[n]);
+            }
+
+            SoftVsOutput outp;
+            program.vs(ctx, inputs, inst, outp);
+
+            if (!(outp.pos.w > 0.0f)) continue;
+
+            float rcpw      = 1.0f / outp.pos.w;
+            dv.vert.x       = ( outp.pos.x * rcpw + 1.0f) * halfW;
+            dv.vert.y       = (-outp.pos.y * rcpw + 1.0f) * halfH;
+            dv.vert.u       = outp.uv.x;
+            dv.vert.v       = outp.uv.y;
+            dv.vert.color   = outp.color;
+            dv.z            = outp.pos.z * rcpw;
+            dv.valid        = true;
+        }
+
+        if (s_primType == GPU_PRIM_TRIANGLELIST) {
+            for (int v=0; v+2<vertsPerInstance; v+=3) {
+                soft_AssembleTriangle(s_draw_verts[v], s_draw_verts[v+1], s_draw_verts[v+2], tex, fsObj->program->ps);
+            }
+        }
+        else {
+            // odd triangles of a strip are reversed, to keep a consistent winding.
+            for (int v=0; v+2<vertsPerInstance; ++v) {
+                const auto& a = s_draw_verts[(v & 1) ? v+1 : v  ];
+                const auto& b = s_draw_verts[(v & 1) ? v   : v+1];
+                soft_AssembleTriangle(a, b, s_draw_verts[v+2], tex, fsObj->program->ps);
+            }
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------------
+//  Constant ring
+// --------------------------------------------------------------------------------------
+// Same scheme as the null backend.  Draws read constants at draw time, so a slice only needs to
+// survive until the frame is submitted -- one ring per back buffer is kept anyway, for parity.
+
+static const int SoftConstantRingChunkSize  = 65536;
+static const int SoftConstantRingAlignment  = 256;
+
+struct SoftConstantRing
+{
+    GPU_RingAllocator           alloc;
+    std::vector<SoftObject*>    chunks;
+};
+
+static SoftConstantRing         s_cbRing            [BackBufferCount];
+
+// --------------------------------------------------------------------------------------
+//  Transient vertex heap
+// --------------------------------------------------------------------------------------
+// Same scheme as the null backend, for dx11_SetTransientVertexBuffer().  Vertices are fetched at
+// draw time, so heap contents need only survive the frame, but chunks are sized as on DX11 so that
+// uploads too large for the device are caught here as well.
+
+static const int SoftTransientHeapChunkSize = _4mb;
+static const int SoftTransientHeapAlignment = 16;
+
+struct SoftTransientHeap
+{
+    GPU_RingAllocator           alloc;
+    std::vector<SoftObject*>    chunks;
+};
+
+static SoftTransientHeap        s_vbHeap            [BackBufferCount];
+
+// --------------------------------------------------------------------------------------
+//  Device and frame
+// --------------------------------------------------------------------------------------
+
+void dx11_InitDevice()
+{
+    s_DynBufferPool.clear();
+    s_DynBufferFreeList = -1;
+
+    // There is no window to size the client area from.  Hosts may still assign g_client_size_pix
+    // beforehand to render at a specific resolution.
+    if (g_client_size_pix.cmp_any() <= 0) {
+        g_client_size_pix = { 1280, 720 };
+    }
+    g_client_aspect_ratio = float(g_client_size_pix.x) / float(g_client_size_pix.y);
+
+    s_raster.Init(g_client_size_pix);
+
+    auto* backbuffer = soft_CreateObject(SoftObj_RenderTarget, 0, nullptr);
+    backbuffer->texSize     = g_client_size_pix;
+    backbuffer->texBytesPP  = 4;
+    g_gpu_BackBuffer = GPU_RenderTarget(backbuffer);
+
+    for (auto& ring : s_cbRing) {
+        ring.alloc.Init(SoftConstantRingChunkSize, SoftConstantRingAlignment);
+    }
+    for (auto& heap : s_vbHeap) {
+        heap.alloc.Init(SoftTransientHeapChunkSize, SoftTransientHeapAlignment);
+    }
+    s_bound.Invalidate();
+    soft_ResetStreams();
+    s_device_ready = true;
+
+    ImGui_ImplDX11_Init(nullptr, nullptr);
+    ImGui_ImplDX11_CreateDeviceObjects();
+}
+
+void dx11_CleanupDevice()
+{
+    if (!s_device_ready) return;
+
+    ImGui_ImplDX11_Shutdown();
+
+    s_raster.Dispose();
+    for (const auto* obj : s_soft_objects) {
+        xFree(((SoftObject*)obj)->data);
+        xFree((void*)obj);
+    }
+    s_soft_objects.clear();
+    s_DynBufferPool.clear();
+    s_DynBufferFreeList = -1;
+
+    // chunks are freed along with the other objects, above
+    for (auto& ring : s_cbRing) {
+        ring.chunks.clear();
+    }
+    for (auto& heap : s_vbHeap) {
+        heap.chunks.clear();
+    }
+    soft_ResetStreams();
+
+    g_gpu_BackBuffer = GPU_RenderTarget();
+    s_device_ready   = false;
+}
+
+void dx11_NewFrame()
+{
+    s_CurrentShaderVS = {};
+    s_CurrentShaderFS = {};
+    s_bound.Invalidate();
+    xMemZero(s_dyn_bound);
+    s_cbRing[s_curBufferIdx].alloc.Reset();
+    s_vbHeap[s_curBufferIdx].alloc.Reset();
+}
+
+void dx11_BeginFrameDrawing()
+{
+}
+
+extern xString xGetTempDir();
+
+SoftGoldenResult soft_GetGoldenResult()
+{
+    return s_golden_result;
+}
+
+// The comparison is done on the decoded PNG rather than the raw back buffer, so that the check
+// covers the same bytes a developer sees when inspecting golden-actual.png by hand.
+static SoftGoldenResult soft_CheckGoldenImage()
+{
+    if (!xFileStat(g_gpu_soft_GoldenImage).IsFile()) {
+        auto pos = g_gpu_soft_GoldenImage.FindLast('/');
+        if (pos != xString::npos) {
+            xCreateDirectory(g_gpu_soft_GoldenImage.GetSubstring(0, pos));
+        }
+        soft_SaveBackBufferToPng(g_gpu_soft_GoldenImage);
+        warn_host("[soft-gpu] Golden image '%s' did not exist and has been recorded from frame %d.",
+            g_gpu_soft_GoldenImage.c_str(), g_gpu_host_framecount
+        );
+        return SoftGolden_Recorded;
+    }
+
+    auto actualpath = xGetTempDir() + "/golden-actual.png";
+    soft_SaveBackBufferToPng(actualpath);
+
+    xBitmapData golden;
+    xBitmapData actual;
+    png_LoadFromFile(golden, g_gpu_soft_GoldenImage);
+    png_LoadFromFile(actual, actualpath);
+
+    if (golden.size != actual.size) {
+        warn_host("[soft-gpu] Golden image mismatch: size is %dx%d, expected %dx%d (%s)",
+            actual.size.x, actual.size.y, golden.size.x, golden.size.y, g_gpu_soft_GoldenImage.c_str()
+        );
+        return SoftGolden_Mismatch;
+    }
+
+    int numpix      = golden.size.x * golden.size.y;
+    int numdiffs    = 0;
+    int maxdelta    = 0;
+
+    auto* src = golden.buffer.GetPtr();
+    auto* dst = actual.buffer.GetPtr();
+    for (int i=0; i<numpix*4; i+=4) {
+        int delta = 0;
+        for (int c=0; c<4; ++c) {
+            delta = std::max(delta, abs(int(src[i+c]) - int(dst[i+c])));
+        }
+        numdiffs += (delta > g_gpu_soft_GoldenTolerance);
+        maxdelta  = std::max(maxdelta, delta);
+    }
+
+    if (numdiffs) {
+        warn_host("[soft-gpu] Golden image mismatch: %d of %d pixels differ (max channel delta=%d, tolerance=%d)\n"
+            "    golden: %s\n"
+            "    actual: %s",
+            numdiffs, numpix, maxdelta, g_gpu_soft_GoldenTolerance,
+            g_gpu_soft_GoldenImage.c_str(), actualpath.c_str()
+        );
+        return SoftGolden_Mismatch;
+    }
+
+    log_host("[soft-gpu] Golden image match at frame %d: %s", g_gpu_host_framecount, g_gpu_soft_GoldenImage.c_str());
+    return SoftGolden_Match;
+}
+
+void dx11_SubmitFrameAndSwap()
+{
+    s_raster.Flush();
+
+    if (g_gpu_soft_CaptureFrames) {
+        soft_SaveBackBufferToPng(xGetTempDir() + xFmtStr("/screen%d.png", g_gpu_host_framecount));
+    }
+
+    if (!g_gpu_soft_GoldenImage.IsEmpty() && g_gpu_host_framecount == g_gpu_soft_GoldenFrame) {
+        s_golden_result = soft_CheckGoldenImage();
+    }
+
+    s_curBufferIdx = (s_curBufferIdx+1) % BackBufferCount;
+
+    s_stats_frame.frame = g_gpu_host_framecount;
+    {
+        xScopedSpinLock lock(s_stats_lock);
+        s_stats_last = s_stats_frame;
+    }
+    s_stats_frame = {};
+
+    ++g_gpu_host_framecount;
+}
+
+void dx11_ClearRenderTarget(const GPU_RenderTarget& target, const float4& color)
+{
+    if (!soft_Resolve(target.m_driverData, SoftObj_RenderTarget, "RenderTarget")) return;
+    s_raster.Clear(color);
+}
+
+void dx11_InputLayoutCache_DisposeAll()
+{
+    // layouts are resolved against programs at draw time, so there's nothing cached.
+}
+
+xBitmapDataRO soft_GetBackBuffer()
+{
+    s_raster.Flush();
+    return { s_raster.GetSize(), s_raster.GetPixels() };
+}
+
+void soft_SaveBackBufferToPng(const xString& filename)
+{
+    auto backbuffer = soft_GetBackBuffer();
+    if (!backbuffer.buffer) {
+        warn_host("Back buffer capture failure: device has not been initialized.");
+        return;
+    }
+
+    x_png_enc pngenc;
+    pngenc.WriteImage(backbuffer);
+
+    log_host("[soft-gpu] Writing back buffer to disk: %s", filename.c_str());
+    pngenc.StripAlphaChannel();
+    pngenc.SaveImage(filename.c_str(), 1);
+}
+
+// --------------------------------------------------------------------------------------
+//  Resource creation
+// --------------------------------------------------------------------------------------
+
+void dx11_CreateDynamicVertexBuffer(GPU_DynVsBuffer& dest, int bufferSizeInBytes, const char* diag_name, int updateInterval)
+{
+    bug_on(updateInterval < 1, "Invalid dynamic buffer update interval=%d", updateInterval);
+    bug_on(bufferSizeInBytes <= 0);
+
+    int bufferIdx = dest.m_buffer_idx;
+
+    if (bufferIdx < 0) {
+        if (s_DynBufferFreeList >= 0) {
+            bufferIdx           = s_DynBufferFreeList;
+            s_DynBufferFreeList = s_DynBufferPool[bufferIdx].m_next_free;
+        }
+        else {
+            bufferIdx = (int)s_DynBufferPool.size();
+            s_DynBufferPool.emplace_back();
+        }
+        xMemZero(s_DynBufferPool[bufferIdx]);
+        s_DynBufferPool[bufferIdx].m_next_free = -1;
+    }
+
+    auto& slot      = s_DynBufferPool[bufferIdx];
+    auto& sched     = slot.m_sched;
+    int   instances = GPU_GetDynBufferInstanceCount(BackBufferCount, updateInterval);
+
+    // existing buffers are kept when they're already big enough, as on DX11.
+    bool  realloc   = (bufferSizeInBytes > slot.m_capacity) || (instances != sched.m_instances);
+
+    sched.m_interval        = updateInterval;
+    sched.m_instances       = instances;
+    sched.m_current         = instances - 1;            // first upload rotates to instance 0
+    sched.m_upload_frame    = g_gpu_host_framecount - updateInterval;
+
+    if (realloc) {
+        for (int i=0; i<BackBufferCount; ++i) {
+            auto& buffer = slot.m_instances[i];
+            soft_Release(buffer.m_object);
+            if (i >= instances) continue;
+            buffer.m_object = soft_CreateObject(SoftObj_DynVertexBuffer, bufferSizeInBytes, nullptr);
+        }
+        slot.m_capacity = bufferSizeInBytes;
+    }
+
+    if (diag_name) {
+        for (int i=0; i<instances; ++i) {
+            xStrCopy(slot.m_instances[i].m_name, sizeof(slot.m_instances[i].m_name), diag_name);
+        }
+    }
+
+    dest.m_buffer_idx = bufferIdx;
+}
+
+void GPU_DynVsBuffer::Dispose()
+{
+    if (!IsValid()) return;
+
+    auto& slot = s_DynBufferPool[m_buffer_idx];
+    for (auto& buffer : slot.m_instances) {
+        soft_Release(buffer.m_object);
+    }
+    xMemZero(slot);
+    slot.m_next_free    = s_DynBufferFreeList;
+    s_DynBufferFreeList = m_buffer_idx;
+    m_buffer_idx        = -1;
+}
+
+void GPU_VertexBuffer::Dispose()
+{
+    soft_Release(m_driverData);
+}
+
+void dx11_CreateStaticMesh(GPU_VertexBuffer& dest, void* vertexData, int itemSizeInBytes, int vertexCount)
+{
+    dest.Dispose();
+    dest.m_driverData = (sptr)soft_CreateObject(SoftObj_VertexBuffer, itemSizeInBytes * vertexCount, vertexData);
+}
+
+void dx11_CreateIndexBuffer(GPU_IndexBuffer& dest, void* indexBuffer, int bufferSize)
+{
+    soft_Release(dest.m_driverData);
+    dest.m_driverData = (sptr)soft_CreateObject(SoftObj_IndexBuffer, bufferSize, indexBuffer);
+}
+
+void dx11_CreateConstantBuffer(GPU_ConstantBuffer& dest, int bufferSize)
+{
+    soft_Release(dest.m_driverData);
+    dest.m_driverData = (sptr)soft_CreateObject(SoftObj_ConstantBuffer, (bufferSize + 15) & ~15, nullptr);
+}
+
+void dx11_CreateTexture2D(GPU_TextureResource2D& dest, const xBitmapDataRO& bitmap, GPU_ResourceFmt format)
+{
+    dx11_CreateTexture2D(dest, bitmap.buffer, bitmap.size.x, bitmap.size.y, format);
+}
+
+void dx11_CreateTexture2D(GPU_TextureResource2D& dest, const void* src_bitmap_data, const int2& size, GPU_ResourceFmt format)
+{
+    dx11_CreateTexture2D(dest, src_bitmap_data, size.x, size.y, format);
+}
+
+void dx11_CreateTexture2D(GPU_TextureResource2D& dest, const void* src_bitmap_data, int width, int height, GPU_ResourceFmt format)
+{
+    soft_Release(dest.m_driverData_tex);
+
+    // same pitch rules as the DX11 backend.
+    int bytespp = 4;
+    if (format == GPU_ResourceFmt_R32G32_UINT ) bytespp = 8;
+    if (format == GPU_ResourceFmt_R32G32_FLOAT) bytespp = 8;
+
+    auto* texture = soft_CreateObject(SoftObj_Texture, width * height * bytespp, src_bitmap_data);
+    texture->texSize    = { width, height };
+    texture->texBytesPP = bytespp;
+
+    // texture and view are the same object; only the view is bound.
+    dest.m_driverData_tex   = (sptr)texture;
+    dest.m_driverData_view  = (sptr)texture;
+}
+
+// Shaders aren't compiled.  The source file is still required to exist, so that missing or misnamed
+// shaders fail headless runs the same way they'd fail on a device.
+static bool soft_TryLoadShader(sptr& dest, SoftObjectType type, const xString& srcfile, const char* entryPointFn)
+{
+    bug_on( !entryPointFn || !entryPointFn[0] );
+
+    soft_Release(dest);
+    if (!xFileStat(srcfile).IsFile()) {
+        warn_host("[soft-gpu] Shader source not found: %s", srcfile.c_str());
+        return false;
+    }
+
+    auto* shader = soft_CreateObject(type, 0, nullptr);
+    shader->program = (type == SoftObj_ShaderVS)
+        ? soft_FindProgramVS(srcfile, entryPointFn)
+        : soft_FindProgramFS(srcfile, entryPointFn);
+
+    if (!shader->program) {
+        warn_host("[soft-gpu] No CPU equivalent for %s:%s, draws using it will be skipped.", srcfile.c_str(), entryPointFn);
+    }
+
+    dest = (sptr)shader;
+    return true;
+}
+
+bool dx11_TryLoadShaderVS(GPU_ShaderVS& dest, const xString& srcfile, const char* entryPointFn)
+{
+    return soft_TryLoadShader(dest.m_driverBinary, SoftObj_ShaderVS, srcfile, entryPointFn);
+}
+
+bool dx11_TryLoadShaderFS(GPU_ShaderFS& dest, const xString& srcfile, const char* entryPointFn)
+{
+    return soft_TryLoadShader(dest.m_driverBinary, SoftObj_ShaderFS, srcfile, entryPointFn);
+}
+
+void dx11_LoadShaderVS(GPU_ShaderVS& dest, const xString& srcfile, const char* entryPointFn)
+{
+    auto result = dx11_TryLoadShaderVS(dest, srcfile, entryPointFn);
+    bug_on_qa(!result, "Errors during shader compiler and no error handler is registered.");
+}
+
+void dx11_LoadShaderFS(GPU_ShaderFS& dest, const xString& srcfile, const char* entryPointFn)
+{
+    auto result = dx11_TryLoadShaderFS(dest, srcfile, entryPointFn);
+    bug_on_qa(!result, "Errors during shader compiler and no error handler is registered.");
+}
+
+// Soft programs are built in, so there is nothing to compile ahead of time.
+void dx11_PrefetchShaders(const GPU_ShaderPrefetch* shaders, int count)
+{
+}
+
+// --------------------------------------------------------------------------------------
+//  Uploads
+// --------------------------------------------------------------------------------------
+
+void dx11_UploadDynamicBufferData(const GPU_DynVsBuffer& src, const void* srcData, int sizeInBytes)
+{
+    bug_on(!srcData);
+    bug_on(!src.IsValid());
+    if (!src.IsValid()) return;
+
+    auto& slot  = s_DynBufferPool[src.m_buffer_idx];
+    auto& sched = slot.m_sched;
+    if (sched.m_upload_frame == g_gpu_host_framecount) {
+        const auto& named = slot.m_instances[0];
+        log_perf("[soft-gpu] Dynamic buffer data was already updated this frame [size=%d%s%s]", sizeInBytes,
+           named.m_name[0] ? " name="      : "",
+           named.m_name[0] ? named.m_name : ""
+        );
+    }
+    else if (sched.m_interval > 1) {
+        sched.m_current = (sched.m_current + 1) % sched.m_instances;
+    }
+    sched.m_upload_frame = g_gpu_host_framecount;
+
+    auto& buffer = slot.m_instances[soft_GetDynBufferInstance(src.m_buffer_idx)];
+    bug_on_qa(!buffer.m_object, "Dynamic buffer id=%d has not been created.", src.m_buffer_idx);
+    bug_on_qa(sizeInBytes > buffer.m_object->size, "Dynamic buffer upload overflow [size=%d capacity=%d]", sizeInBytes, buffer.m_object->size);
+
+    xMemCopy(buffer.m_object->data, srcData, sizeInBytes);
+    s_stats_frame.dynamicBufferBytes += sizeInBytes;
+}
+
+void dx11_UpdateConstantBuffer(const GPU_ConstantBuffer& buffer, const void* data)
+{
+    auto* obj = (SoftObject*)soft_Resolve(buffer.m_driverData, SoftObj_ConstantBuffer, "ConstantBuffer");
+    if (!obj) return;
+
+    xMemCopy(obj->data, data, obj->size);
+    s_stats_frame.constantBufferBytes += obj->size;
+}
+
+GPU_ConstantSlice dx11_ReserveConstants(int sizeInBytes)
+{
+    auto&   ring        = s_cbRing[s_curBufferIdx];
+    int     size        = (sizeInBytes + 15) & ~15;
+    int     offset      = 0;
+    int     chunkIdx    = ring.alloc.Alloc(size, offset);
+
+    while (chunkIdx >= (int)ring.chunks.size()) {
+        ring.chunks.push_back(soft_CreateObject(SoftObj_ConstantBuffer, SoftConstantRingChunkSize, nullptr));
+    }
+
+    auto*   chunk       = ring.chunks[chunkIdx];
+    GPU_ConstantSlice slice;
+    slice.data          = chunk->data + offset;
+    slice.m_driverData  = (sptr)chunk;
+    slice.offset        = offset;
+    slice.size          = size;
+    return slice;
+}
+
+// --------------------------------------------------------------------------------------
+//  Binds and draws
+// --------------------------------------------------------------------------------------
+
+void dx11_SetInputLayout(const GPU_InputDesc& layout)
+{
+    bug_on_qa(!layout.GetHash(), "Binding an empty input layout.");
+    s_CurrentInputDesc = &layout;
+}
+
+void dx11_SetRasterState(GpuRasterFillMode fill, GpuRasterCullMode cull, GpuRasterScissorMode scissor)
+{
+    if (g_gpu_ForceWireframe) {
+        fill = GPU_Fill_Wireframe;
+    }
+
+    switch (cull) {
+        case GPU_Cull_Front:    s_cullMode = SoftCull_Front;    break;
+        case GPU_Cull_Back:     s_cullMode = SoftCull_Back;     break;
+        default:                s_cullMode = SoftCull_None;     break;
+    }
+    soft_UpdateBound(s_bound.rasterState, u32((fill << 16) | (cull << 8) | scissor));
+}
+
+void dx11_SetPrimType(GpuPrimitiveType primType)
+{
+    bug_on_qa(primType < GPU_PRIM_POINTLIST || primType > GPU_PRIM_TRIANGLESTRIP, "Invalid primitive type=%d", primType);
+    s_primType = primType;
+    soft_UpdateBound(s_bound.primType, (int)primType);
+}
+
+void dx11_BindConstantBuffer(const GPU_ConstantBuffer& buffer, int startSlot)
+{
+    bug_on(startSlot < 0 || startSlot >= SoftConstantBufferSlots);
+    const auto* obj = soft_Resolve(buffer.m_driverData, SoftObj_ConstantBuffer, "ConstantBuffer");
+    s_constantBuffers[startSlot] = { obj, 0, obj ? obj->size : 0 };
+    soft_UpdateBound(s_bound.constantBuffers[startSlot], SoftConstantBinding{ buffer.m_driverData, 0 });
+}
+
+void dx11_BindConstantSlice(const GPU_ConstantSlice& slice, int startSlot)
+{
+    bug_on(startSlot < 0 || startSlot >= SoftConstantBufferSlots);
+    bug_on(!slice.IsValid(), "Binding an unreserved constant slice.");
+    const auto* obj = soft_Resolve(slice.m_driverData, SoftObj_ConstantBuffer, "ConstantSlice");
+    s_constantBuffers[startSlot] = { obj, slice.offset, slice.size };
+    soft_UpdateBound(s_bound.constantBuffers[startSlot], SoftConstantBinding{ slice.m_driverData, slice.offset });
+    s_stats_frame.constantBufferBytes += slice.size;
+}
+
+void dx11_BindShaderResource(const GPU_ShaderResource& res, int startSlot)
+{
+    bug_on(startSlot < 0);
+    auto* texture = soft_Resolve(res.m_driverData_view, SoftObj_Texture, "ShaderResource");
+    if (startSlot == 0) {
+        s_texture0 = texture;
+    }
+
+    if (startSlot < SoftShaderResourceSlots) {
+        soft_UpdateBound(s_bound.shaderResources[startSlot], res.m_driverData_view);
+    }
+    else {
+        s_stats_frame.bindsIssued += 1;
+    }
+}
+
+void dx11_BindShaderVS(const GPU_ShaderVS& vs)
+{
+    bug_on_qa(!vs.m_driverBinary, "Uninitialized VS shader resource.");
+    s_CurrentShaderVS = &vs;
+}
+
+void dx11_BindShaderFS(const GPU_ShaderFS& fs)
+{
+    bug_on_qa(!fs.m_driverBinary, "Uninitialized FS shader resource.");
+    s_CurrentShaderFS = &fs;
+}
+
+static void soft_SetStream(int shaderSlot, const SoftObject* object, int _stride, int _offset)
+{
+    s_streams[shaderSlot].object = object;
+    s_streams[shaderSlot].stride = _stride;
+    s_streams[shaderSlot].offset = _offset;
+
+    u64 strideOffset = (u64(u32(_stride)) << 32) | u32(_offset);
+    if (s_bound.vertexBuffers[shaderSlot] == (sptr)object && s_bound.vertexStrideOffset[shaderSlot] == strideOffset) {
+        s_stats_frame.bindsSkipped += 1;
+        return;
+    }
+    s_bound.vertexBuffers       [shaderSlot] = (sptr)object;
+    s_bound.vertexStrideOffset  [shaderSlot] = strideOffset;
+    s_stats_frame.bindsIssued += 1;
+}
+
+void dx11_SetVertexBuffer(const GPU_DynVsBuffer& src, int shaderSlot, int _stride, int _offset)
+{
+    bug_on(!src.IsValid());
+    if (!src.IsValid()) return;
+    bug_on(shaderSlot < 0 || shaderSlot >= SoftVertexSlots);
+
+    auto& buffer = s_DynBufferPool[src.m_buffer_idx].m_instances[soft_GetDynBufferInstance(src.m_buffer_idx)];
+    bug_on_qa(!buffer.m_object, "Dynamic buffer id=%d has not been created.", src.m_buffer_idx);
+
+    s_dyn_bound[shaderSlot] = src.m_buffer_idx+1;
+    soft_SetStream(shaderSlot, buffer.m_object, _stride, _offset);
+}
+
+void dx11_SetVertexBuffer(const GPU_VertexBuffer& vbuffer, int shaderSlot, int _stride, int _offset)
+{
+    bug_on(shaderSlot < 0 || shaderSlot >= SoftVertexSlots);
+    auto* object = soft_Resolve(vbuffer.m_driverData, SoftObj_VertexBuffer, "VertexBuffer");
+
+    s_dyn_bound[shaderSlot] = 0;
+    soft_SetStream(shaderSlot, object, _stride, _offset);
+}
+
+void dx11_SetTransientVertexBuffer(const void* srcData, int sizeInBytes, int shaderSlot, int _stride)
+{
+    bug_on(!srcData);
+    bug_on(shaderSlot < 0 || shaderSlot >= SoftVertexSlots);
+    x_abort_on(sizeInBytes > SoftTransientHeapChunkSize, "Transient vertex upload is too large [size=%d max=%d]",
+        sizeInBytes, SoftTransientHeapChunkSize
+    );
+
+    auto&   heap        = s_vbHeap[s_curBufferIdx];
+    int     offset      = 0;
+    int     chunkIdx    = heap.alloc.Alloc(sizeInBytes, offset);
+
+    while (chunkIdx >= (int)heap.chunks.size()) {
+        heap.chunks.push_back(soft_CreateObject(SoftObj_VertexBuffer, SoftTransientHeapChunkSize, nullptr));
+    }
+
+    auto*   chunk       = heap.chunks[chunkIdx];
+    xMemCopy(chunk->data + offset, srcData, sizeInBytes);
+    s_stats_frame.transientBufferBytes += sizeInBytes;
+
+    s_dyn_bound[shaderSlot] = 0;
+    soft_SetStream(shaderSlot, chunk, _stride, offset);
+}
+
+void dx11_SetIndexBuffer(const GPU_IndexBuffer& indexBuffer, int bitsPerIndex, int offset)
+{
+    switch (bitsPerIndex) {
+        case 8:
+        case 16:
+        case 32:    break;
+        default:    unreachable("Invalid parameter 'bitsPerindex=%d'", bitsPerIndex);
+    }
+    s_indexBuffer   = soft_Resolve(indexBuffer.m_driverData, SoftObj_IndexBuffer, "IndexBuffer");
+    s_indexBits     = bitsPerIndex;
+    s_indexOffset   = offset;
+
+    u64 formatOffset = (u64(u32(bitsPerIndex)) << 32) | u32(offset);
+    if (s_bound.indexBuffer == indexBuffer.m_driverData && s_bound.indexFormatOffset == formatOffset) {
+        s_stats_frame.bindsSkipped += 1;
+        return;
+    }
+    s_bound.indexBuffer         = indexBuffer.m_driverData;
+    s_bound.indexFormatOffset   = formatOffset;
+    s_stats_frame.bindsIssued += 1;
+}
+
+void dx11_Draw(int indexCount, int startVertLoc)
+{
+    soft_ExecuteDraw(indexCount, 1, startVertLoc, 0, 0, false);
+}
+
+void dx11_DrawIndexed(int indexCount, int startIndexLoc, int baseVertLoc)
+{
+    soft_ExecuteDraw(indexCount, 1, startIndexLoc, baseVertLoc, 0, true);
+}
+
+void dx11_DrawInstanced(int vertsPerInstance, int instanceCount, int startVertLoc, int startInstanceLoc)
+{
+    soft_ExecuteDraw(vertsPerInstance, instanceCount, startVertLoc, 0, startInstanceLoc, false);
+}
+
+void dx11_DrawIndexedInstanced(int indexesPerInstance, int instanceCount, int startIndex, int baseVertex, int startInstance)
+{
+    soft_ExecuteDraw(indexesPerInstance, instanceCount, startIndex, baseVertex, startInstance, true);
+}
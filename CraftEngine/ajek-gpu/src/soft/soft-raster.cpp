@@ -0,0 +1,324 @@
+
+#include "x-types.h"
+#include "x-stdalloc.h"
+#include "x-assertion.h"
+#include "x-simd.h"
+#include "x-workers.h"
+
+#include "soft-raster.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Coordinates beyond this many pixels from the origin aren't rasterized.  Keeps snapped vertices
+// and edge products well inside float precision.  Geometry this far off-screen is always culled
+// anyway, since triangles are never clipped.
+static const float  GuardBandPix    = 16384.0f;
+static const float  SubPixelScale   = 256.0f;
+
+static __ai float snapToSubPixel(float v)
+{
+    return floorf(v * SubPixelScale + 0.5f) * (1.0f / SubPixelScale);
+}
+
+u32 soft_PackColor(const float4& color)
+{
+    __m128 val = _mm_setr_ps(color.x, color.y, color.z, color.w);
+    val = _mm_min_ps(_mm_max_ps(val, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    val = _mm_mul_ps(val, _mm_set1_ps(255.0f));
+
+    __m128i ival = _mm_cvtps_epi32(val);
+    ival = _mm_packs_epi32 (ival, ival);
+    ival = _mm_packus_epi16(ival, ival);
+    return (u32)_mm_cvtsi128_si32(ival);
+}
+
+static __ai __m128 unpackTexel(u32 texel)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i ival = _mm_cvtsi32_si128((int)texel);
+    ival = _mm_unpacklo_epi8 (ival, zero);
+    ival = _mm_unpacklo_epi16(ival, zero);
+    return _mm_cvtepi32_ps(ival);
+}
+
+static __ai u32 packTexel(__m128 val)
+{
+    __m128i ival = _mm_cvtps_epi32(val);
+    ival = _mm_packs_epi32 (ival, ival);
+    ival = _mm_packus_epi16(ival, ival);
+    return (u32)_mm_cvtsi128_si32(ival);
+}
+
+void SoftRasterizer::Init(const int2& size)
+{
+    bug_on(size.x <= 0 || size.y <= 0);
+
+    Flush();
+    m_size      = size;
+    m_tiles     = { (size.x + TileSize - 1) / TileSize, (size.y + TileSize - 1) / TileSize };
+    m_target    = (u32*)xRealloc(m_target, size.x * size.y * sizeof(u32));
+    m_bins.resize(m_tiles.x * m_tiles.y);
+    memset(m_target, 0, size.x * size.y * sizeof(u32));
+
+    m_pool.Init();
+}
+
+void SoftRasterizer::Dispose()
+{
+    m_pool.Shutdown();
+    m_triangles.clear();
+    m_bins.clear();
+    xFree(m_target);
+    m_target    = nullptr;
+    m_size      = {0, 0};
+    m_tiles     = {0, 0};
+}
+
+bool SoftRasterizer::AddTriangle(const SoftVertex& a, const SoftVertex& b, const SoftVertex& c, const SoftTexture& tex, SoftPixelShader shader, SoftCullMode cull)
+{
+    const SoftVertex* vert[3] = { &a, &b, &c };
+
+    float x[3], y[3];
+    for (int i=0; i<3; ++i) {
+        x[i] = snapToSubPixel(vert[i]->x);
+        y[i] = snapToSubPixel(vert[i]->y);
+
+        // written to also reject NaNs.
+        if (!(fabsf(x[i]) < GuardBandPix && fabsf(y[i]) < GuardBandPix)) return false;
+    }
+
+    // Pixel space is Y-down, so triangles which are clockwise on screen (D3D front faces) have
+    // positive area.
+    float area = (x[1]-x[0])*(y[2]-y[0]) - (y[1]-y[0])*(x[2]-x[0]);
+    if (area == 0.0f)                           return false;
+    if (cull == SoftCull_Back  && area < 0.0f)  return false;
+    if (cull == SoftCull_Front && area > 0.0f)  return false;
+
+    SoftTriangle tri;
+    tri.bbox.x = std::max(0,            (int)ceilf (std::min({x[0], x[1], x[2]}) - 0.5f));
+    tri.bbox.y = std::max(0,            (int)ceilf (std::min({y[0], y[1], y[2]}) - 0.5f));
+    tri.bbox.z = std::min(m_size.x - 1, (int)floorf(std::max({x[0], x[1], x[2]}) - 0.5f));
+    tri.bbox.w = std::min(m_size.y - 1, (int)floorf(std::max({y[0], y[1], y[2]}) - 0.5f));
+    if (tri.bbox.x > tri.bbox.z || tri.bbox.y > tri.bbox.w) return false;
+
+    float orient = (area > 0.0f) ? 1.0f : -1.0f;
+    for (int e=0; e<3; ++e) {
+        int i0 = e;
+        int i1 = (e + 1) % 3;
+
+        // Endpoints are ordered the same way regardless of which triangle the edge belongs to, so
+        // that neighbors compute bit-identical values and differ only by sign.
+        bool swap = (y[i1] < y[i0]) || (y[i1] == y[i0] && x[i1] < x[i0]);
+        int  p    = swap ? i1 : i0;
+        int  q    = swap ? i0 : i1;
+
+        tri.ox  [e] = x[p];
+        tri.oy  [e] = y[p];
+        tri.dx  [e] = x[q] - x[p];
+        tri.dy  [e] = y[q] - y[p];
+        tri.sign[e] = swap ? -orient : orient;
+
+        // top-left rule, from the gradient of the oriented edge function (-sign*dy, sign*dx).
+        float gx = -tri.sign[e] * tri.dy[e];
+        float gy =  tri.sign[e] * tri.dx[e];
+        bool  topLeft = (gx > 0.0f) || (gx == 0.0f && gy > 0.0f);
+        tri.tie [e] = topLeft ? 0xffffffffu : 0;
+    }
+
+    float attr[3][6];
+    for (int i=0; i<3; ++i) {
+        attr[i][0] = vert[i]->u;
+        attr[i][1] = vert[i]->v;
+        attr[i][2] = vert[i]->color.x;
+        attr[i][3] = vert[i]->color.y;
+        attr[i][4] = vert[i]->color.z;
+        attr[i][5] = vert[i]->color.w;
+    }
+
+    tri.x0 = x[0];
+    tri.y0 = y[0];
+    float rcpArea = 1.0f / area;
+    for (int k=0; k<6; ++k) {
+        float d1 = attr[1][k] - attr[0][k];
+        float d2 = attr[2][k] - attr[0][k];
+        tri.base[k] = attr[0][k];
+        tri.ddx [k] = (d1 * (y[2]-y[0]) - d2 * (y[1]-y[0])) * rcpArea;
+        tri.ddy [k] = (d2 * (x[1]-x[0]) - d1 * (x[2]-x[0])) * rcpArea;
+    }
+
+    bool flat = true;
+    for (int k=2; k<6; ++k) {
+        flat = flat && (attr[0][k] == attr[1][k]) && (attr[0][k] == attr[2][k]);
+    }
+
+    tri.texture     = tex;
+    tri.shader      = shader;
+    tri.flatColor   = (shader == SoftPS_Texture) || flat;
+    tri.opaqueTint  = (shader == SoftPS_Texture) || (flat &&
+        attr[0][2] == 1.0f && attr[0][3] == 1.0f && attr[0][4] == 1.0f && attr[0][5] == 1.0f
+    );
+
+    m_triangles.push_back(tri);
+    return true;
+}
+
+void SoftRasterizer::RasterizeTile(int tileIdx) const
+{
+    int tileX0 = (tileIdx % m_tiles.x) * TileSize;
+    int tileY0 = (tileIdx / m_tiles.x) * TileSize;
+    int tileX1 = std::min(tileX0 + TileSize, m_size.x) - 1;
+    int tileY1 = std::min(tileY0 + TileSize, m_size.y) - 1;
+
+    const __m128 zero       = _mm_setzero_ps();
+    const __m128 one        = _mm_set1_ps(1.0f);
+    const __m128 rcp255     = _mm_set1_ps(1.0f / 255.0f);
+    const __m128 laneOffs   = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 alphaMask  = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+
+    for (u32 triIdx : m_bins[tileIdx]) {
+        const auto& tri = m_triangles[triIdx];
+
+        int x0 = std::max(tri.bbox.x, tileX0);
+        int y0 = std::max(tri.bbox.y, tileY0);
+        int x1 = std::min(tri.bbox.z, tileX1);
+        int y1 = std::min(tri.bbox.w, tileY1);
+
+        __m128 eOx[3], eDy[3], eSign[3], eTie[3];
+        for (int e=0; e<3; ++e) {
+            eOx  [e] = _mm_set1_ps(tri.ox[e]);
+            eDy  [e] = _mm_set1_ps(tri.dy[e]);
+            eSign[e] = _mm_set1_ps(tri.sign[e]);
+            eTie [e] = _mm_castsi128_ps(_mm_set1_epi32((int)tri.tie[e]));
+        }
+
+        const SoftTexture& tex  = tri.texture;
+        const __m128 texW       = _mm_set1_ps((float)tex.width);
+        const __m128 texH       = _mm_set1_ps((float)tex.height);
+        const __m128 texMaxX    = _mm_set1_ps((float)(tex.width  - 1));
+        const __m128 texMaxY    = _mm_set1_ps((float)(tex.height - 1));
+        const __m128 flatColor  = _mm_setr_ps(tri.base[2], tri.base[3], tri.base[4], tri.base[5]);
+        const bool   tinted     = (tri.shader == SoftPS_TextureTinted);
+        const int    numAttr    = tri.flatColor ? 2 : 6;
+
+        __m128 ddx[6];
+        for (int k=0; k<numAttr; ++k) {
+            ddx[k] = _mm_set1_ps(tri.ddx[k]);
+        }
+
+        const __m128 xEnd   = _mm_set1_ps((float)(x1 + 1));
+        const __m128 planeX = _mm_set1_ps(tri.x0);
+
+        for (int py=y0; py<=y1; ++py) {
+            float  pyc = (float)py + 0.5f;
+            u32*   row = m_target + (py * m_size.x);
+
+            __m128 rowTerm[3];
+            for (int e=0; e<3; ++e) {
+                rowTerm[e] = _mm_set1_ps(tri.dx[e] * (pyc - tri.oy[e]));
+            }
+
+            __m128 rowBase[6];
+            for (int k=0; k<numAttr; ++k) {
+                rowBase[k] = _mm_set1_ps(tri.base[k] + tri.ddy[k] * (pyc - tri.y0));
+            }
+
+            for (int px=x0; px<=x1; px+=4) {
+                __m128 pxc   = _mm_add_ps(_mm_set1_ps((float)px), laneOffs);
+                __m128 cover = _mm_cmplt_ps(pxc, xEnd);
+
+                for (int e=0; e<3; ++e) {
+                    __m128 w  = _mm_mul_ps(eSign[e], _mm_sub_ps(rowTerm[e], _mm_mul_ps(eDy[e], _mm_sub_ps(pxc, eOx[e]))));
+                    __m128 in = _mm_or_ps(_mm_cmpgt_ps(w, zero), _mm_and_ps(_mm_cmpeq_ps(w, zero), eTie[e]));
+                    cover = _mm_and_ps(cover, in);
+                }
+
+                int mask = _mm_movemask_ps(cover);
+                if (!mask) continue;
+
+                __m128 relx = _mm_sub_ps(pxc, planeX);
+                __m128 attr[6];
+                for (int k=0; k<numAttr; ++k) {
+                    attr[k] = _mm_add_ps(rowBase[k], _mm_mul_ps(ddx[k], relx));
+                }
+
+                // point sample, clamp addressing.  max_ps also maps NaNs to zero.
+                __m128 fu = _mm_min_ps(_mm_max_ps(_mm_mul_ps(attr[0], texW), zero), texMaxX);
+                __m128 fv = _mm_min_ps(_mm_max_ps(_mm_mul_ps(attr[1], texH), zero), texMaxY);
+
+                alignas(16) s32   tu[4];
+                alignas(16) s32   tv[4];
+                alignas(16) float color[6][4];
+                _mm_store_si128((__m128i*)tu, _mm_cvttps_epi32(fu));
+                _mm_store_si128((__m128i*)tv, _mm_cvttps_epi32(fv));
+                for (int k=2; k<numAttr; ++k) {
+                    _mm_store_ps(color[k], attr[k]);
+                }
+
+                for (int i=0; i<4; ++i) {
+                    if (!(mask & (1 << i))) continue;
+
+                    u32  texel = tex.texels[(tv[i] * tex.width) + tu[i]];
+                    u32& dest  = row[px + i];
+
+                    if (tri.opaqueTint) {
+                        u32 alpha = texel >> 24;
+                        if (alpha == 255) { dest = texel; continue; }
+                        if (alpha == 0)   { continue; }
+                    }
+
+                    __m128 src = unpackTexel(texel);
+                    if (tinted) {
+                        __m128 tint = tri.flatColor ? flatColor : _mm_setr_ps(color[2][i], color[3][i], color[4][i], color[5][i]);
+                        src = _mm_mul_ps(src, tint);
+                    }
+
+                    __m128 sa   = _mm_mul_ps(_mm_shuffle_ps(src, src, _MM_SHUFFLE(3,3,3,3)), rcp255);
+                    __m128 srcF = _mm_or_ps(_mm_andnot_ps(alphaMask, sa), _mm_and_ps(alphaMask, one));
+                    __m128 dstF = _mm_sub_ps(one, sa);
+                    __m128 dst  = unpackTexel(dest);
+                    dest = packTexel(_mm_add_ps(_mm_mul_ps(src, srcF), _mm_mul_ps(dst, dstF)));
+                }
+            }
+        }
+    }
+}
+
+void SoftRasterizer::Flush()
+{
+    if (m_triangles.empty()) return;
+
+    for (auto& bin : m_bins) {
+        bin.clear();
+    }
+
+    int count = (int)m_triangles.size();
+    for (int i=0; i<count; ++i) {
+        const auto& bbox = m_triangles[i].bbox;
+        for (int ty = bbox.y / TileSize; ty <= bbox.w / TileSize; ++ty) {
+            for (int tx = bbox.x / TileSize; tx <= bbox.z / TileSize; ++tx) {
+                m_bins[(ty * m_tiles.x) + tx].push_back((u32)i);
+            }
+        }
+    }
+
+    // Tiles don't share pixels, so they need no synchronization beyond the ParallelFor() join.
+    m_pool.ParallelFor(m_tiles.x * m_tiles.y, 1, [this](int begin, int end) {
+        for (int t=begin; t<end; ++t) {
+            if (!m_bins[t].empty()) {
+                RasterizeTile(t);
+            }
+        }
+    });
+
+    m_triangles.clear();
+}
+
+void SoftRasterizer::Clear(const float4& color)
+{
+    // anything still queued would be entirely overwritten, so it's discarded rather than drawn.
+    m_triangles.clear();
+
+    u32 packed = soft_PackColor(color);
+    std::fill(m_target, m_target + (m_size.x * m_size.y), packed);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "x-types.h"
+#include "x-simd.h"
+#include "x-workers.h"
+
+#include <vector>
+
+// --------------------------------------------------------------------------------------
+//  Soft Rasterizer
+// --------------------------------------------------------------------------------------
+// Back end of the soft GPU backend (see dx11-soft.cpp).  Triangles arrive already transformed into
+// pixel space and are queued in submission order.  Flush() bins them into screen tiles, and tiles
+// are rasterized in parallel.  Each tile walks its triangles in submission order, so blending is
+// ordered exactly as if triangles had been drawn one at a time.
+//
+// Rasterization follows D3D rules closely enough for golden images:
+//  * Pixel centers are at +0.5.  Vertices are snapped to 1/256th of a pixel.
+//  * Shared edges are evaluated canonically (same endpoint order for both triangles) so that the
+//    two triangles of a quad produce exactly negated edge values, and the top-left rule assigns
+//    pixels on the shared edge to exactly one of them.  No gaps and no double-blended seams.
+//  * Textures are point sampled with clamp addressing, matching the sampler created by the DX11
+//    backend.
+//  * Blending is SRC_ALPHA / INV_SRC_ALPHA for color, and ONE / INV_SRC_ALPHA for alpha, which
+//    keeps the back buffer opaque.
+//
+// All of the per-pixel work is SSE2.  Results depend only on the submitted triangles and not on
+// the number of worker threads.
+//
+
+struct SoftTexture
+{
+    const u32*      texels      = nullptr;      // R8G8B8A8
+    int             width       = 0;
+    int             height      = 0;
+};
+
+// Post-transform vertex, in pixels.
+struct SoftVertex
+{
+    float           x, y;
+    float           u, v;
+    float4          color;
+};
+
+enum SoftPixelShader : u8
+{
+    SoftPS_Texture,                 // sampled texel
+    SoftPS_TextureTinted,           // sampled texel * vertex color
+};
+
+struct SoftTriangle
+{
+    // Canonical edge functions: w = sign * (dx*(py - oy) - dy*(px - ox)).  Interior is w > 0, and
+    // pixels on an edge (w == 0) are included only if tie[i] is set (top-left rule).
+    float           ox[3], oy[3];
+    float           dx[3], dy[3];
+    float           sign[3];
+    u32             tie[3];
+
+    // attribute planes: attr = base + ddx*(px - x0) + ddy*(py - y0)
+    float           x0, y0;
+    float           base[6];
+    float           ddx [6];
+    float           ddy [6];
+
+    int4            bbox;                   // inclusive pixel range, clipped to the render target
+    SoftTexture     texture;
+    SoftPixelShader shader;
+    u8              flatColor;              // vertex colors are equal; color planes are constant
+    u8              opaqueTint;             // flatColor and color is (1,1,1,1)
+};
+
+enum SoftCullMode : u8
+{
+    SoftCull_None,
+    SoftCull_Front,
+    SoftCull_Back,
+};
+
+class SoftRasterizer
+{
+    NONCOPYABLE_OBJECT( SoftRasterizer );
+
+public:
+    static const int    TileSize    = 64;
+
+protected:
+    u32*                        m_target        = nullptr;
+    int2                        m_size          = {0, 0};
+    int2                        m_tiles         = {0, 0};
+
+    std::vector<SoftTriangle>       m_triangles;
+    std::vector<std::vector<u32>>   m_bins;
+
+    // Private pool: the scene's g_WorkerPool may be in use by the producer thread while the render
+    // thread executes draws.
+    xWorkerPool                     m_pool;
+
+public:
+    SoftRasterizer() { }
+    ~SoftRasterizer() throw() { Dispose(); }
+
+    void        Init            (const int2& size);
+    void        Dispose         ();
+
+    bool        AddTriangle     (const SoftVertex& a, const SoftVertex& b, const SoftVertex& c, const SoftTexture& tex, SoftPixelShader shader, SoftCullMode cull);
+    void        Flush           ();
+    void        Clear           (const float4& color);
+
+    int         GetPendingCount () const    { return (int)m_triangles.size(); }
+    const u32*  GetPixels       () const    { return m_target; }
+    const int2& GetSize         () const    { return m_size;   }
+
+protected:
+    void        RasterizeTile   (int tileIdx) const;
+};
+
+extern u32      soft_PackColor  (const float4& color);
@@ -0,0 +1,170 @@
+
+#include "x-types.h"
+#include "x-string.h"
+#include "x-assertion.h"
+#include "x-simd.h"
+
+#include "soft-shaders.h"
+
+// Constant buffers are uploaded with transposed matrices (see GPU_ViewCameraConsts users), which
+// HLSL then reads as column-major.  For a row vector, mul(v, M) is therefore the dot product of v
+// against each uploaded row.
+static __ai float4 mulTransposed(const float4& v, const float* m)
+{
+    float4 result;
+    result.x = (v.x * m[ 0]) + (v.y * m[ 1]) + (v.z * m[ 2]) + (v.w * m[ 3]);
+    result.y = (v.x * m[ 4]) + (v.y * m[ 5]) + (v.z * m[ 6]) + (v.w * m[ 7]);
+    result.z = (v.x * m[ 8]) + (v.y * m[ 9]) + (v.z * m[10]) + (v.w * m[11]);
+    result.w = (v.x * m[12]) + (v.y * m[13]) + (v.z * m[14]) + (v.w * m[15]);
+    return result;
+}
+
+// cbuffer ConstantBuffer0 : register( b0 ) -- common to all programs.
+struct SoftCB_ViewCamera
+{
+    float       View        [16];
+    float       Projection  [16];
+};
+
+static __ai float4 viewProject(const SoftVsContext& ctx, const float4& pos)
+{
+    const auto& cb0 = *(const SoftCB_ViewCamera*)ctx.cbuffer[0];
+    return mulTransposed(mulTransposed(pos, cb0.View), cb0.Projection);
+}
+
+// --------------------------------------------------------------------------------------
+//  TileMap.fx
+// --------------------------------------------------------------------------------------
+
+struct SoftCB_TileMap
+{
+    float2      TileAlignedDisp;
+    int2        SrcTexSizeInTiles;
+    int2        SrcTexTileSizePix;
+    int2        SrcTexBorderPix;
+    int2        ViewMeshSize;
+};
+
+static void vs_TileMap(const SoftVsContext& ctx, const SoftAttrib* inputs, int instID, SoftVsOutput& outp)
+{
+    const auto& cb1     = *(const SoftCB_TileMap*)ctx.cbuffer[1];
+    const auto& pos     = inputs[0];
+    const auto& uv      = inputs[1];
+    u32         tileID  = inputs[2].u[0];
+
+    // HLSL would return garbage; a zero W gets the triangle culled instead.
+    if (cb1.ViewMeshSize.x <= 0 || cb1.SrcTexSizeInTiles.x <= 0) {
+        outp = {};
+        return;
+    }
+
+    int   tile_x = instID % cb1.ViewMeshSize.x;
+    int   tile_y = instID / cb1.ViewMeshSize.x;
+    float disp_x = (cb1.ViewMeshSize.x * -0.5f) + tile_x - 0.5f;
+    float disp_y = (cb1.ViewMeshSize.y * -0.5f) + tile_y - 0.5f;
+
+    float4 wpos;
+    wpos.x =  (pos.f[0] + disp_x + cb1.TileAlignedDisp.x);
+    wpos.y = -(pos.f[1] + disp_y + cb1.TileAlignedDisp.y);     // +Y is UP!
+    wpos.z = 1.0f;
+    wpos.w = 1.0f;
+    outp.pos = viewProject(ctx, wpos);
+
+    int tiletex_u = int(tileID % u32(cb1.SrcTexSizeInTiles.x));
+    int tiletex_v = int(tileID / u32(cb1.SrcTexSizeInTiles.x));
+    tiletex_u  *= (cb1.SrcTexBorderPix.x * 2) + cb1.SrcTexTileSizePix.x;
+    tiletex_v  *= (cb1.SrcTexBorderPix.y * 2) + cb1.SrcTexTileSizePix.y;
+    tiletex_u  += 1;
+    tiletex_v  += 1;
+    tiletex_u   = int(tiletex_u + (uv.f[0] * cb1.SrcTexTileSizePix.x));
+    tiletex_v   = int(tiletex_v + (uv.f[1] * cb1.SrcTexTileSizePix.y));
+
+    outp.uv.x   = float(tiletex_u) / ctx.texSize.x;
+    outp.uv.y   = float(tiletex_v) / ctx.texSize.y;
+    outp.color  = { 1.0f, 0.0f, 0.0f, 1.0f };
+}
+
+// --------------------------------------------------------------------------------------
+//  Sprite.fx
+// --------------------------------------------------------------------------------------
+
+struct SoftCB_Sprite
+{
+    float2      worldpos;
+    u32         ViewMeshSize[2];
+};
+
+static void vs_Sprite(const SoftVsContext& ctx, const SoftAttrib* inputs, int instID, SoftVsOutput& outp)
+{
+    const auto& cb1 = *(const SoftCB_Sprite*)ctx.cbuffer[1];
+    const auto& pos = inputs[0];
+    const auto& uv  = inputs[1];
+
+    float4 wpos;
+    wpos.x =  (pos.f[0] + cb1.worldpos.x - 0.5f);
+    wpos.y = -(pos.f[1] + cb1.worldpos.y - 0.5f);               // +Y is UP!
+    wpos.z = pos.f[2];
+    wpos.w = 1.0f;
+    outp.pos = viewProject(ctx, wpos);
+
+    outp.uv.x   = uv.f[0] / ctx.texSize.x;
+    outp.uv.y   = uv.f[1] / ctx.texSize.y;
+    outp.color  = { uv.f[0], uv.f[1], 0.0f, 1.0f };
+}
+
+// --------------------------------------------------------------------------------------
+//  SpriteInstanced.fx
+// --------------------------------------------------------------------------------------
+
+static void vs_SpriteInstanced(const SoftVsContext& ctx, const SoftAttrib* inputs, int instID, SoftVsOutput& outp)
+{
+    const auto& pos         = inputs[0];
+    const auto& uv          = inputs[1];
+    const auto& worldpos    = inputs[2];
+    const auto& size        = inputs[3];
+    const auto& uvrect      = inputs[4];
+    const auto& tint        = inputs[5];
+
+    float4 wpos;
+    wpos.x =  ((pos.f[0] * size.f[0]) + worldpos.f[0] - 0.5f);
+    wpos.y = -((pos.f[1] * size.f[1]) + worldpos.f[1] - 0.5f);  // +Y is UP!
+    wpos.z = 1.0f;
+    wpos.w = 1.0f;
+    outp.pos = viewProject(ctx, wpos);
+
+    outp.color  = { tint.f[0], tint.f[1], tint.f[2], tint.f[3] };
+    outp.uv.x   = (uvrect.f[0] + (uvrect.f[2] - uvrect.f[0]) * uv.f[0]) / ctx.texSize.x;
+    outp.uv.y   = (uvrect.f[1] + (uvrect.f[3] - uvrect.f[1]) * uv.f[1]) / ctx.texSize.y;
+}
+
+// --------------------------------------------------------------------------------------
+//  Program table
+// --------------------------------------------------------------------------------------
+
+static const SoftProgram s_programs[] =
+{
+    { "TileMap.fx",         "VS", "PS", vs_TileMap,         SoftPS_Texture,         0x3, 3, { "POSITION", "TEXCOORD", "TileID" } },
+    { "Sprite.fx",          "VS", "PS", vs_Sprite,          SoftPS_Texture,         0x3, 2, { "POSITION", "TEXCOORD" } },
+    { "SpriteInstanced.fx", "VS", "PS", vs_SpriteInstanced, SoftPS_TextureTinted,   0x1, 6, { "POSITION", "TEXCOORD", "WORLDPOS", "SIZE", "UVRECT", "COLOR" } },
+};
+
+static const SoftProgram* findProgram(const xString& srcfile, const char* entryPointFn, bool isVS)
+{
+    auto basename = xBaseFilename(srcfile);
+    for (const auto& program : s_programs) {
+        if (strcmp(basename.c_str(), program.filename)) continue;
+        if (strcmp(entryPointFn, isVS ? program.entryVS : program.entryFS)) continue;
+        return &program;
+    }
+    return nullptr;
+}
+
+const SoftProgram* soft_FindProgramVS(const xString& srcfile, const char* entryPointFn)
+{
+    return findProgram(srcfile, entryPointFn, true);
+}
+
+const SoftProgram* soft_FindProgramFS(const xString& srcfile, const char* entryPointFn)
+{
+    return findProgram(srcfile, entryPointFn, false);
+}
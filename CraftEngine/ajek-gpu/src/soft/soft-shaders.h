@@ -0,0 +1,60 @@
+#pragma once
+
+#include "x-types.h"
+#include "x-simd.h"
+#include "x-string.h"
+
+#include "soft-raster.h"
+
+// --------------------------------------------------------------------------------------
+//  Soft Shader Programs
+// --------------------------------------------------------------------------------------
+// HLSL can't be run on the CPU, so the soft backend carries hand-written equivalents of the .fx
+// programs the engine uses, looked up by source filename and entry point at shader load.  Any
+// edit to one of the listed .fx files needs the matching edit in soft-shaders.cpp, or golden
+// images will diverge from the DX11 output.
+//
+// Vertex inputs are fetched by semantic name from the bound GPU_InputDesc, in the order listed by
+// the program.  Float formats are expanded to float4 with missing components as (0,0,0,1), as D3D
+// does.  Integer formats keep their bits.
+//
+
+static const int SoftMaxInputs      = 6;
+static const int SoftMaxCBuffers    = 2;
+
+union SoftAttrib
+{
+    float   f[4];
+    u32     u[4];
+};
+
+struct SoftVsContext
+{
+    const u8*       cbuffer [SoftMaxCBuffers];      // constants bound to b0, b1 (nullptr if unbound)
+    int             cbsize  [SoftMaxCBuffers];
+    int2            texSize;                        // dimensions of the resource bound to t0
+};
+
+struct SoftVsOutput
+{
+    float4          pos;                            // clip space
+    float2          uv;
+    float4          color;
+};
+
+typedef void SoftVsFn(const SoftVsContext& ctx, const SoftAttrib* inputs, int instanceId, SoftVsOutput& outp);
+
+struct SoftProgram
+{
+    const char*         filename;
+    const char*         entryVS;
+    const char*         entryFS;
+    SoftVsFn*           vs;
+    SoftPixelShader     ps;
+    int                 cbuffersRequired;           // bitmask of b# slots which must be bound
+    int                 numInputs;
+    const char*         inputs[SoftMaxInputs];
+};
+
+extern const SoftProgram*   soft_FindProgramVS  (const xString& srcfile, const char* entryPointFn);
+extern const SoftProgram*   soft_FindProgramFS  (const xString& srcfile, const char* entryPointFn);
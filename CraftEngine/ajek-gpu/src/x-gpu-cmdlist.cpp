@@ -0,0 +1,217 @@
+#include "x-types.h"
+#include "x-assertion.h"
+#include "x-stdlib.h"
+#include "x-workers.h"
+#include "x-gpu-ifc.h"
+#include "x-gpu-cmdlist.h"
+
+// Inline data is kept 16-byte aligned, since constant buffer contents are typically made of
+// vector types and the backend may hand the pointer straight to the driver.
+static const int CmdDataAlignment = 16;
+
+void GPU_CommandList::Reset()
+{
+    // retain capacity: lists are typically re-recorded every frame with similar content.
+    m_cmds.clear();
+    m_data.clear();
+}
+
+GPU_Command& GPU_CommandList::Append(GPU_CommandOp op, const void* res)
+{
+    m_cmds.emplace_back();
+    auto& cmd   = m_cmds.back();
+    cmd.op      = op;
+    cmd.res     = res;
+    return cmd;
+}
+
+s32 GPU_CommandList::AppendData(const void* src, int sizeInBytes)
+{
+    bug_on(sizeInBytes < 0);
+    s32 offset  = ((s32)m_data.size() + (CmdDataAlignment-1)) & ~(CmdDataAlignment-1);
+    m_data.resize(offset + sizeInBytes);
+    if (sizeInBytes) {
+        xMemCopy(m_data.data() + offset, src, sizeInBytes);
+    }
+    return offset;
+}
+
+void GPU_CommandList::SetInputLayout(const GPU_InputDesc& layout)
+{
+    Append(GPU_Cmd_SetInputLayout, &layout);
+}
+
+void GPU_CommandList::SetRasterState(GpuRasterFillMode fill, GpuRasterCullMode cull, GpuRasterScissorMode scissor)
+{
+    auto& cmd   = Append(GPU_Cmd_SetRasterState, nullptr);
+    cmd.args[0] = fill;
+    cmd.args[1] = cull;
+    cmd.args[2] = scissor;
+}
+
+void GPU_CommandList::SetPrimType(GpuPrimitiveType primType)
+{
+    auto& cmd   = Append(GPU_Cmd_SetPrimType, nullptr);
+    cmd.args[0] = primType;
+}
+
+void GPU_CommandList::BindShaderVS(const GPU_ShaderVS& vs)
+{
+    Append(GPU_Cmd_BindShaderVS, &vs);
+}
+
+void GPU_CommandList::BindShaderFS(const GPU_ShaderFS& fs)
+{
+    Append(GPU_Cmd_BindShaderFS, &fs);
+}
+
+void GPU_CommandList::BindConstantBuffer(const GPU_ConstantBuffer& buffer, int startSlot)
+{
+    auto& cmd   = Append(GPU_Cmd_BindConstantBuffer, &buffer);
+    cmd.args[0] = startSlot;
+}
+
+void GPU_CommandList::BindConstants(const void* data, int sizeInBytes, int startSlot)
+{
+    s32   offset  = AppendData(data, sizeInBytes);
+    auto& cmd     = Append(GPU_Cmd_BindConstants, nullptr);
+    cmd.args[0]   = offset;
+    cmd.args[1]   = sizeInBytes;
+    cmd.args[2]   = startSlot;
+}
+
+void GPU_CommandList::BindShaderResource(const GPU_ShaderResource& res, int startSlot)
+{
+    auto& cmd   = Append(GPU_Cmd_BindShaderResource, &res);
+    cmd.args[0] = startSlot;
+}
+
+void GPU_CommandList::SetVertexBuffer(const GPU_DynVsBuffer& vbuffer, int shaderSlot, int _stride, int _offset)
+{
+    auto& cmd   = Append(GPU_Cmd_SetVertexBufferDyn, &vbuffer);
+    cmd.args[0] = shaderSlot;
+    cmd.args[1] = _stride;
+    cmd.args[2] = _offset;
+}
+
+void GPU_CommandList::SetVertexBuffer(const GPU_VertexBuffer& vbuffer, int shaderSlot, int _stride, int _offset)
+{
+    auto& cmd   = Append(GPU_Cmd_SetVertexBuffer, &vbuffer);
+    cmd.args[0] = shaderSlot;
+    cmd.args[1] = _stride;
+    cmd.args[2] = _offset;
+}
+
+void GPU_CommandList::SetTransientVertexBuffer(const void* srcData, int sizeInBytes, int shaderSlot, int _stride)
+{
+    s32   offset  = AppendData(srcData, sizeInBytes);
+    auto& cmd     = Append(GPU_Cmd_SetTransientVertexBuffer, nullptr);
+    cmd.args[0]   = offset;
+    cmd.args[1]   = sizeInBytes;
+    cmd.args[2]   = shaderSlot;
+    cmd.args[3]   = _stride;
+}
+
+void GPU_CommandList::SetIndexBuffer(const GPU_IndexBuffer& indexBuffer, int bitsPerIndex, int offset)
+{
+    auto& cmd   = Append(GPU_Cmd_SetIndexBuffer, &indexBuffer);
+    cmd.args[0] = bitsPerIndex;
+    cmd.args[1] = offset;
+}
+
+void GPU_CommandList::UpdateConstantBuffer(const GPU_ConstantBuffer& buffer, const void* data, int sizeInBytes)
+{
+    s32   offset  = AppendData(data, sizeInBytes);
+    auto& cmd     = Append(GPU_Cmd_UpdateConstantBuffer, &buffer);
+    cmd.args[0]   = offset;
+    cmd.args[1]   = sizeInBytes;
+}
+
+void GPU_CommandList::UploadDynamicBufferData(const GPU_DynVsBuffer& buffer, const void* srcData, int sizeInBytes)
+{
+    s32   offset  = AppendData(srcData, sizeInBytes);
+    auto& cmd     = Append(GPU_Cmd_UploadDynamicBufferData, &buffer);
+    cmd.args[0]   = offset;
+    cmd.args[1]   = sizeInBytes;
+}
+
+void GPU_CommandList::Draw(int indexCount, int startVertLoc)
+{
+    auto& cmd   = Append(GPU_Cmd_Draw, nullptr);
+    cmd.args[0] = indexCount;
+    cmd.args[1] = startVertLoc;
+}
+
+void GPU_CommandList::DrawIndexed(int indexCount, int startIndexLoc, int baseVertLoc)
+{
+    auto& cmd   = Append(GPU_Cmd_DrawIndexed, nullptr);
+    cmd.args[0] = indexCount;
+    cmd.args[1] = startIndexLoc;
+    cmd.args[2] = baseVertLoc;
+}
+
+void GPU_CommandList::DrawInstanced(int vertsPerInstance, int instanceCount, int startVertLoc, int startInstanceLoc)
+{
+    auto& cmd   = Append(GPU_Cmd_DrawInstanced, nullptr);
+    cmd.args[0] = vertsPerInstance;
+    cmd.args[1] = instanceCount;
+    cmd.args[2] = startVertLoc;
+    cmd.args[3] = startInstanceLoc;
+}
+
+void GPU_CommandList::DrawIndexedInstanced(int indexesPerInstance, int instanceCount, int startIndex, int baseVertex, int startInstance)
+{
+    auto& cmd   = Append(GPU_Cmd_DrawIndexedInstanced, nullptr);
+    cmd.args[0] = indexesPerInstance;
+    cmd.args[1] = instanceCount;
+    cmd.args[2] = startIndex;
+    cmd.args[3] = baseVertex;
+    cmd.args[4] = startInstance;
+}
+
+void GPU_CommandList::Execute() const
+{
+    bug_on(xWorkerPool_InParallelRegion(), "Command lists must be executed from the render thread.");
+
+    const u8* data = m_data.data();
+
+    for (const auto& cmd : m_cmds) {
+        const auto* args = cmd.args;
+
+        switch (cmd.op) {
+            case GPU_Cmd_SetInputLayout:            dx11_SetInputLayout         (*(const GPU_InputDesc*)cmd.res);                                       break;
+            case GPU_Cmd_SetRasterState:            dx11_SetRasterState         ((GpuRasterFillMode)args[0], (GpuRasterCullMode)args[1], (GpuRasterScissorMode)args[2]); break;
+            case GPU_Cmd_SetPrimType:               dx11_SetPrimType            ((GpuPrimitiveType)args[0]);                                            break;
+            case GPU_Cmd_BindShaderVS:              dx11_BindShaderVS           (*(const GPU_ShaderVS*)cmd.res);                                        break;
+            case GPU_Cmd_BindShaderFS:              dx11_BindShaderFS           (*(const GPU_ShaderFS*)cmd.res);                                        break;
+            case GPU_Cmd_BindConstantBuffer:        dx11_BindConstantBuffer     (*(const GPU_ConstantBuffer*)cmd.res, args[0]);                         break;
+            case GPU_Cmd_BindConstants: {
+                auto slice = dx11_ReserveConstants(args[1]);
+                xMemCopy(slice.data, data + args[0], args[1]);
+                dx11_BindConstantSlice(slice, args[2]);
+            } break;
+
+            case GPU_Cmd_BindShaderResource:        dx11_BindShaderResource     (*(const GPU_ShaderResource*)cmd.res, args[0]);                         break;
+            case GPU_Cmd_SetVertexBufferDyn:        dx11_SetVertexBuffer        (*(const GPU_DynVsBuffer*) cmd.res, args[0], args[1], args[2]);         break;
+            case GPU_Cmd_SetVertexBuffer:           dx11_SetVertexBuffer        (*(const GPU_VertexBuffer*)cmd.res, args[0], args[1], args[2]);         break;
+            case GPU_Cmd_SetTransientVertexBuffer:  dx11_SetTransientVertexBuffer(data + args[0], args[1], args[2], args[3]);                       break;
+            case GPU_Cmd_SetIndexBuffer:            dx11_SetIndexBuffer         (*(const GPU_IndexBuffer*) cmd.res, args[0], args[1]);                  break;
+            case GPU_Cmd_UpdateConstantBuffer:      dx11_UpdateConstantBuffer   (*(const GPU_ConstantBuffer*)cmd.res, data + args[0]);                  break;
+            case GPU_Cmd_UploadDynamicBufferData:   dx11_UploadDynamicBufferData(*(const GPU_DynVsBuffer*) cmd.res, data + args[0], args[1]);           break;
+            case GPU_Cmd_Draw:                      dx11_Draw                   (args[0], args[1]);                                                     break;
+            case GPU_Cmd_DrawIndexed:               dx11_DrawIndexed            (args[0], args[1], args[2]);                                            break;
+            case GPU_Cmd_DrawInstanced:             dx11_DrawInstanced          (args[0], args[1], args[2], args[3]);                                   break;
+            case GPU_Cmd_DrawIndexedInstanced:      dx11_DrawIndexedInstanced   (args[0], args[1], args[2], args[3], args[4]);                          break;
+
+            default: bug_on(true, "Invalid command list opcode: %d", cmd.op);
+        }
+    }
+}
+
+// Replays lists in array order, which is the only ordering guarantee between lists.
+void GPU_ExecuteCommandLists(const GPU_CommandList* lists, int count)
+{
+    for (int i=0; i<count; ++i) {
+        lists[i].Execute();
+    }
+}
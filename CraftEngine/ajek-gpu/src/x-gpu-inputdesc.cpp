@@ -0,0 +1,69 @@
+#include "x-types.h"
+#include "x-stdlib.h"
+#include "x-string.h"
+#include "x-simd.h"
+#include "x-ThrowContext.h"
+#include "x-gpu-ifc.h"
+
+// Input layout descriptions are plain data and shared by all backends.  Backends resolve them against
+// the bound vertex shader when a draw is issued (see dx11_SetInputLayout).
+
+void GPU_InputDesc::_AddHash(const InputLayoutSlot& src)
+{
+    bug_on (!src.m_numElements, "Unexpected zero-sized src data.");
+
+    u32 hashval = i_crc32(0, src.m_InstanceDataStepRate);
+    for (int i=0; i<src.m_numElements; ++i) {
+        hashval = i_crc32(hashval, src.m_Items[i].Format        );
+        hashval = i_crc32(hashval, src.m_Items[i].ByteOffset    );
+        static_assert(bulkof(src.m_Items[i].SemanticName) == 16, "");
+        hashval = i_crc32(hashval, (u64&)src.m_Items[i].SemanticName[0]);
+        hashval = i_crc32(hashval, (u64&)src.m_Items[i].SemanticName[8]);
+    }
+
+    // neat trick, serves 2 purposes.
+    //  1. ensures full 64 bit hash is never zero if something meaningful has been assigned
+    //     to this InputLayoutDesc.
+    //  2. Allows InstanceDataStepRate to be modified later on, and also allows incrementally
+    //     adding additional elements to this slot.
+
+    m_hashval = hashval | (u64(src.m_InstanceDataStepRate+1) << 32);
+}
+
+InputLayoutSlot& InputLayoutSlot::SetInstanceStepRate(int step)
+{
+    m_InstanceDataStepRate = step;
+    return *this;
+}
+
+InputLayoutSlot& InputLayoutSlot::Append(const InputLayoutItem& item)
+{
+    Append(item.SemanticName, item.Format);
+    return *this;
+}
+
+InputLayoutSlot& InputLayoutSlot::Append(const InputLayoutItemEx& item)
+{
+    Append(item.SemanticName, item.Format, item.offset);
+    return *this;
+}
+
+InputLayoutSlot& InputLayoutSlot::Append(const char* semanticName, GPU_ResourceFmt format, int offset)
+{
+    x_abort_on(m_numElements >= MaxElementsPerSlot, "Too many data elements added to InputLayoutSlot.");
+
+    // Check for redundant semantic name ...
+    for (int i=0; i<m_numElements; ++i) {
+        if (strcmp(semanticName, m_Items[i].SemanticName) == 0) {
+            throw_abort("Duplicate semantic name: %s", semanticName);
+        }
+    }
+
+    auto& newItem = m_Items[m_numElements];
+    xStrCopyT(newItem.SemanticName, semanticName);
+    newItem.ByteOffset  = offset;
+    newItem.Format      = format;
+
+    m_numElements += 1;
+    return *this;
+}
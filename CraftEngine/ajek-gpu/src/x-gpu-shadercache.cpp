@@ -0,0 +1,309 @@
+#include "x-types.h"
+#include "x-assertion.h"
+#include "x-string.h"
+#include "x-stl.h"
+#include "x-stdfile.h"
+#include "x-workers.h"
+#include "x-gpu-shadercache.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+extern xString xGetTempDir();
+
+// Bump whenever the layout of cache files changes.
+static const u32    ShaderCacheMagic        = 0x43444853;      // 'SHDC'
+static const u32    ShaderCacheVersion      = 1;
+
+// Guards against include cycles and runaway recursion; HLSL sources in this project are shallow.
+static const int    MaxIncludeDepth         = 16;
+
+struct ShaderCacheFileHeader
+{
+    u32     magic;
+    u32     version;
+    u64     key;
+    u32     sizeInBytes;
+    u32     reserved;
+};
+
+static GPU_ShaderCompiler*                          s_compiler  = nullptr;
+static std::unordered_map<u64, std::vector<u8>>     s_prefetched;
+
+void GPU_ShaderCache_SetCompiler(GPU_ShaderCompiler* compiler)
+{
+    s_compiler = compiler;
+    GPU_ShaderCache_Purge();
+}
+
+void GPU_ShaderCache_Purge()
+{
+    s_prefetched.clear();
+}
+
+// --------------------------------------------------------------------------------------
+//  Key Generation
+// --------------------------------------------------------------------------------------
+// FNV-1a: keys only need to be stable across runs and well distributed, and sources are small
+// enough that hashing cost is noise next to a single file open.
+
+static const u64 FnvOffsetBasis = 0xcbf29ce484222325ull;
+static const u64 FnvPrime       = 0x00000100000001b3ull;
+
+static u64 hash_bytes(u64 hash, const void* src, size_t length)
+{
+    auto* bytes = (const u8*)src;
+    for (size_t i=0; i<length; ++i) {
+        hash ^= bytes[i];
+        hash *= FnvPrime;
+    }
+    return hash;
+}
+
+static u64 hash_str(u64 hash, const char* str)
+{
+    // include the terminator so that adjacent strings can't alias ("ab"+"c" vs "a"+"bc").
+    return hash_bytes(hash, str, strlen(str) + 1);
+}
+
+static bool readWholeFile(std::vector<u8>& dest, const xString& path)
+{
+    FILE* fp = xFopen(path, "rb");
+    if (!fp) return false;
+    Defer(fclose(fp));
+
+    fseek(fp, 0, SEEK_END);
+    long length = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (length < 0) return false;
+
+    dest.resize(length);
+    return !length || (fread(dest.data(), 1, length, fp) == (size_t)length);
+}
+
+static xString dirOf(const xString& path)
+{
+    auto pos = path.FindLast("/\\");
+    return (pos == xString::npos) ? xString() : path.GetSubstring(0, pos+1);
+}
+
+// Hashes the contents of srcfile and, recursively, of every file it includes via #include.
+// Returns false if srcfile itself can't be read.  Unreadable includes hash by name only: the
+// compiler will fail on them anyway, and the key changes once they appear.
+static bool hash_source(u64& hash, const xString& srcfile, std::unordered_set<std::string>& visited, int depth)
+{
+    if (depth > MaxIncludeDepth) return true;
+    if (!visited.insert(srcfile.c_str()).second) return true;
+
+    std::vector<u8> text;
+    if (!readWholeFile(text, srcfile)) return false;
+
+    hash = hash_str  (hash, srcfile.c_str());
+    hash = hash_bytes(hash, text.data(), text.size());
+
+    auto srcdir = dirOf(srcfile);
+    const char* pos = (const char*)text.data();
+    const char* end = pos + text.size();
+
+    while (pos < end) {
+        const char* eol = (const char*)memchr(pos, '\n', end - pos);
+        if (!eol) eol = end;
+
+        const char* cur = pos;
+        pos = eol + 1;
+
+        while (cur < eol && (*cur == ' ' || *cur == '\t')) ++cur;
+        if (cur >= eol || *cur != '#') continue;
+        ++cur;
+        while (cur < eol && (*cur == ' ' || *cur == '\t')) ++cur;
+        if ((eol - cur) < 7 || strncmp(cur, "include", 7)) continue;
+        cur += 7;
+
+        // The standard include handler resolves <name> the same way as "name", so track both.
+        while (cur < eol && (*cur == ' ' || *cur == '\t')) ++cur;
+        if (cur >= eol || (*cur != '"' && *cur != '<')) continue;
+        const char* open  = cur;
+        const char* close = (const char*)memchr(open+1, (*open == '<') ? '>' : '"', eol - (open+1));
+        if (!close || close == open+1) continue;
+
+        xString incname;
+        incname.Append(open+1, int(close - (open+1)));
+
+        bool isAbsolute = (incname[0] == '/') || (incname[0] == '\\') || (incname.GetLength() > 1 && incname[1] == ':');
+        xString incpath = isAbsolute ? incname : (srcdir + incname);
+
+        if (!hash_source(hash, incpath, visited, depth+1)) {
+            hash = hash_str(hash, incpath.c_str());
+        }
+    }
+    return true;
+}
+
+static bool shaderCache_ComputeKey(u64& key, const xString& srcfile, const char* entryPointFn, const char* profile)
+{
+    std::unordered_set<std::string> visited;
+
+    u64 hash = FnvOffsetBasis;
+    if (!hash_source(hash, srcfile, visited, 0)) return false;
+
+    hash = hash_str(hash, entryPointFn);
+    hash = hash_str(hash, profile);
+    hash = hash_str(hash, s_compiler->GetConfigName());
+    key  = hash;
+    return true;
+}
+
+// --------------------------------------------------------------------------------------
+//  Disk Storage
+// --------------------------------------------------------------------------------------
+
+static xString shaderCache_GetDir()
+{
+    auto dir = xGetTempDir() + "/shadercache";
+    xCreateDirectory(dir);
+    return dir;
+}
+
+static xString shaderCache_GetPath(const xString& dir, u64 key)
+{
+    return dir + xFmtStr("/%016llx.bin", (unsigned long long)key);
+}
+
+static bool shaderCache_Read(std::vector<u8>& dest, const xString& path, u64 key)
+{
+    FILE* fp = xFopen(path, "rb");
+    if (!fp) return false;
+    Defer(fclose(fp));
+
+    ShaderCacheFileHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1) return false;
+    if (header.magic != ShaderCacheMagic || header.version != ShaderCacheVersion || header.key != key) {
+        return false;
+    }
+
+    dest.resize(header.sizeInBytes);
+    return header.sizeInBytes && (fread(dest.data(), 1, header.sizeInBytes, fp) == header.sizeInBytes);
+}
+
+// Safe to call from pool workers.  Written to a temp file first and then renamed into place, so a
+// concurrent reader (or another running instance) never sees a partial entry.
+static void shaderCache_Write(const xString& path, u64 key, const std::vector<u8>& bytecode)
+{
+    auto tmppath = path + xFmtStr(".%d.tmp", xWorkerPool_GetThreadIndex());
+
+    ShaderCacheFileHeader header = {};
+    header.magic        = ShaderCacheMagic;
+    header.version      = ShaderCacheVersion;
+    header.key          = key;
+    header.sizeInBytes  = (u32)bytecode.size();
+
+    bool written = false;
+    if (FILE* fp = xFopen(tmppath, "wb")) {
+        written =  (fwrite(&header, sizeof(header), 1, fp) == 1)
+                && (fwrite(bytecode.data(), 1, bytecode.size(), fp) == bytecode.size());
+        written = (fclose(fp) == 0) && written;
+    }
+
+    // rename fails if the entry already exists, which only happens if someone else stored the
+    // same key first -- contents are identical, so dropping ours is fine.
+    if (!written || !xFileRename(tmppath, path)) {
+        xFileUnlink(tmppath);
+    }
+}
+
+// --------------------------------------------------------------------------------------
+//  Fetch / Prefetch
+// --------------------------------------------------------------------------------------
+
+bool GPU_ShaderCache_Fetch(std::vector<u8>& dest, const xString& srcfile, const char* entryPointFn, const char* profile, xString& errors)
+{
+    bug_on(!s_compiler, "No shader compiler is registered. Backends should call GPU_ShaderCache_SetCompiler() at device init.");
+    bug_on(!entryPointFn || !entryPointFn[0]);
+
+    u64     key;
+    xString path;
+    bool    hasKey = shaderCache_ComputeKey(key, srcfile, entryPointFn, profile);
+
+    if (hasKey) {
+        auto it = s_prefetched.find(key);
+        if (it != s_prefetched.end()) {
+            dest = std::move(it->second);
+            s_prefetched.erase(it);
+            return true;
+        }
+
+        path = shaderCache_GetPath(shaderCache_GetDir(), key);
+        if (shaderCache_Read(dest, path, key)) {
+            return true;
+        }
+    }
+
+    // missing source files end up here too, so that the compiler reports them in its own words.
+    if (!s_compiler->Compile(srcfile, entryPointFn, profile, dest, errors)) {
+        return false;
+    }
+
+    if (hasKey) {
+        shaderCache_Write(path, key, dest);
+    }
+    return true;
+}
+
+void GPU_ShaderCache_Prefetch(const GPU_ShaderCacheRequest* requests, int count)
+{
+    if (!s_compiler || count <= 0) return;
+
+    struct PrefetchJob
+    {
+        const GPU_ShaderCacheRequest*   req;
+        u64                             key;
+        xString                         path;
+        std::vector<u8>                 bytecode;
+        bool                            compiled;
+    };
+
+    // Cache lookups are done up front on the calling thread: they're cheap, and xGetTempDir()
+    // isn't meant to be called from workers.
+    auto dir = shaderCache_GetDir();
+
+    std::vector<PrefetchJob>    jobs;
+    std::unordered_set<u64>     keys;
+
+    for (int i=0; i<count; ++i) {
+        const auto& req = requests[i];
+        u64 key;
+        if (!shaderCache_ComputeKey(key, req.srcfile, req.entryPointFn, req.profile)) continue;
+        if (!keys.insert(key).second)                   continue;
+        if (s_prefetched.count(key))                    continue;
+
+        auto path = shaderCache_GetPath(dir, key);
+        if (xFileStat(path).IsFile())                   continue;
+
+        jobs.push_back({ &req, key, path, {}, false });
+    }
+
+    if (jobs.empty()) return;
+
+    // One shader per chunk: compile times are long and uneven, so finer balancing is pointless.
+    auto* compiler = s_compiler;
+    g_WorkerPool.ParallelFor((int)jobs.size(), 1, [&](int begin, int end) {
+        for (int i=begin; i<end; ++i) {
+            auto&   job = jobs[i];
+            xString errors;
+            job.compiled = compiler->Compile(job.req->srcfile, job.req->entryPointFn, job.req->profile, job.bytecode, errors);
+            if (job.compiled) {
+                shaderCache_Write(job.path, job.key, job.bytecode);
+            }
+        }
+    });
+
+    int numCompiled = 0;
+    for (auto& job : jobs) {
+        if (!job.compiled) continue;
+        s_prefetched[job.key] = std::move(job.bytecode);
+        ++numCompiled;
+    }
+
+    log_perf("ShaderCache: prefetch compiled %d of %d shaders (%d failed, deferred to load)",
+        numCompiled, count, int(jobs.size()) - numCompiled);
+}
@@ -0,0 +1,103 @@
+#include "x-types.h"
+#include "x-assertion.h"
+#include "x-gpu-ifc.h"
+#include "x-gpu-sortkey.h"
+
+#include <algorithm>
+
+static const int    ShaderIdBits    = 12;
+static const int    LayoutIdBits    = 8;
+static const int    TextureIdBits   = 12;
+static const int    DepthBits       = 24;
+static const int    StateBits       = ShaderIdBits + LayoutIdBits + TextureIdBits;
+static const u32    DepthMask       = (1u << DepthBits) - 1;
+
+// murmur3 finalizer, keeping the top (best mixed) bits.
+static __ai u32 foldHash(u64 val, int bits)
+{
+    val ^= val >> 33;
+    val *= 0xff51afd7ed558ccdull;
+    val ^= val >> 33;
+    val *= 0xc4ceb9fe1a85ec53ull;
+    val ^= val >> 33;
+    return (u32)(val >> (64 - bits));
+}
+
+// Same mapping as used by OrderedDrawList: negative floats have all bits flipped and positive floats
+// have only the sign bit flipped, so that the result sorts as unsigned.  The low mantissa bits are
+// dropped to fit the key; draws which become equal keep submission order.
+static __ai u32 makeDepthKey(float depth)
+{
+    u32 bits = (u32&)depth;
+    u32 mask = (bits & 0x80000000u) ? 0xffffffffu : 0x80000000u;
+    return (bits ^ mask) >> (32 - DepthBits);
+}
+
+u64 GPU_MakeSortKey(const GPU_SortKeyDesc& desc)
+{
+    bug_on_qa(desc.layer < 0 || desc.layer >= GPU_SortKey_MaxLayers, "Sort key layer out of range: %d", desc.layer);
+
+    u64 shaderId    = foldHash((u64)(uptr)desc.shaderVS * 31 + (u64)(uptr)desc.shaderFS, ShaderIdBits);
+    u64 layoutId    = desc.layout ? foldHash(desc.layout->GetHash(), LayoutIdBits) : 0;
+    u64 textureId   = foldHash((u64)(uptr)desc.texture, TextureIdBits);
+    u64 depth       = makeDepthKey(desc.depth);
+    u64 state       = (shaderId << (LayoutIdBits + TextureIdBits)) | (layoutId << TextureIdBits) | textureId;
+
+    u64 key = (u64)(desc.layer & (GPU_SortKey_MaxLayers-1)) << 60;
+    if (desc.translucent) {
+        // back-to-front: the farthest (highest) depth must produce the lowest key.
+        key |= 1ull     << 59;
+        key |= (~depth & DepthMask) << (59 - DepthBits);
+        key |= state    << (59 - DepthBits - StateBits);
+    }
+    else {
+        key |= state    << (59 - StateBits);
+        key |= depth    << (59 - StateBits - DepthBits);
+    }
+    return key;
+}
+
+// Eight 8-bit LSD radix passes, ping-ponging between items and scratch.  Passes in which every key
+// shares the same digit are skipped -- typically the unused bits and the high bits of the layer.
+// The sort is stable, so draws with equal keys keep submission order.
+void GPU_SortByKey(std::vector<GPU_SortItem>& items, std::vector<GPU_SortItem>& scratch)
+{
+    int count = (int)items.size();
+    if (count < 2) return;
+
+    u32 histogram[8][256] = {};
+    for (const auto& item : items) {
+        for (int pass=0; pass<8; ++pass) {
+            histogram[pass][(item.key >> (pass * 8)) & 0xff] += 1;
+        }
+    }
+
+    scratch.resize(count);
+    auto* src = &items;
+    auto* dst = &scratch;
+
+    for (int pass=0; pass<8; ++pass) {
+        auto& hist  = histogram[pass];
+        int   shift = pass * 8;
+
+        u32 firstDigit = ((*src)[0].key >> shift) & 0xff;
+        if (hist[firstDigit] == (u32)count) continue;
+
+        u32 offset[256];
+        u32 sum = 0;
+        for (int i=0; i<256; ++i) {
+            offset[i] = sum;
+            sum += hist[i];
+        }
+
+        for (const auto& item : *src) {
+            u32 digit = (item.key >> shift) & 0xff;
+            (*dst)[offset[digit]++] = item;
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != &items) {
+        items.swap(scratch);
+    }
+}
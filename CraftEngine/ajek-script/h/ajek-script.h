@@ -257,10 +257,18 @@ struct AjekScriptEnv
 
     xString             m_log_buffer;
 
+    // batchcall state -- registry keys are created lazily on first use, and are invalidated
+    // along with the lua_State by DisposeState().
+    int                 m_batch_driver;         // regkey: function(fn, selves, n, arg)
+    int                 m_batch_selves;         // regkey: reusable array of self tables
+    int                 m_batch_count;          // number of selves added to the current batch
+    int                 m_batch_highwater;      // largest batch submitted since the selves table was created
+
 volatile
     AjekScriptEnv() {
         m_L             = nullptr;
         m_ThrowCtx      = nullptr;
+        ResetBatchState();
     }
 
     bool HasError() const {
@@ -304,6 +312,17 @@ volatile
     bool            call            (int nArgs, int nRet);
     void            pop             (int num);
 
+// batchcall - invokes a single Lua function against many self tables using one protected call
+// into a Lua-side driver, eg. fn(selves[i], arg) for i=1..n.  This avoids a C->Lua transition and
+// a pair of registry lookups per self object.  Usage:
+//     batchcall_begin(fn);  batchcall_add(self) [repeat];  batchcall_end(arg);
+// Nothing may be pushed or popped from the Lua stack between begin and end.
+
+    void            batchcall_begin (const AjekReg_Closure&     closure_id);
+    void            batchcall_add   (const AjekReg_Table&       table_id);
+    bool            batchcall_end   (float arg);
+    void            ResetBatchState ();
+
     bool            glob_IsNil      (const char* varname)   const;
 
     lua_s32         get_s32         (int stackidx = -1)     const;
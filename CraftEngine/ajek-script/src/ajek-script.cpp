@@ -348,6 +348,7 @@ void AjekScriptEnv::DisposeState()
 
     lua_close(m_L);
     m_L         = nullptr;
+    ResetBatchState();
 }
 
 
@@ -819,6 +820,82 @@ bool AjekScriptEnv::call(int nArgs, int nRet)
     return true;
 }
 
+// --------------------------------------------------------------------------------------
+//  batchcall
+// --------------------------------------------------------------------------------------
+// The driver is compiled once per lua_State and held in the registry.  The selves array is reused
+// from batch to batch: only the first n entries are meaningful to the driver, and entries beyond
+// n left over from a previous larger batch are cleared after the call so that they don't keep
+// removed entities' tables alive.
+
+static const char* s_batch_driver_src =
+    "return function(fn, selves, n, arg)\n"
+    "    for i=1,n do fn(selves[i], arg) end\n"
+    "end\n";
+
+void AjekScriptEnv::ResetBatchState()
+{
+    m_batch_driver      = LUA_NOREF;
+    m_batch_selves      = LUA_NOREF;
+    m_batch_count       = 0;
+    m_batch_highwater   = 0;
+}
+
+void AjekScriptEnv::batchcall_begin(const AjekReg_Closure& closure)
+{
+    bug_on (!m_L, "Invalid object state: uninitialized script environment.");
+
+    if (m_batch_driver == LUA_NOREF) {
+        int ret = luaL_loadbuffer(m_L, s_batch_driver_src, strlen(s_batch_driver_src), "=batchcall");
+        x_abort_on(ret, "batchcall driver failed to compile: %s", lua_tostring(m_L, -1));
+        lua_call(m_L, 0, 1);
+        m_batch_driver = luaL_ref(m_L, LUA_REGISTRYINDEX);
+
+        lua_createtable(m_L, 256, 0);
+        m_batch_selves = luaL_ref(m_L, LUA_REGISTRYINDEX);
+        m_batch_highwater = 0;
+    }
+
+    lua_rawgeti(m_L, LUA_REGISTRYINDEX, m_batch_driver);
+    pushreg(closure);
+    lua_rawgeti(m_L, LUA_REGISTRYINDEX, m_batch_selves);
+    m_batch_count = 0;
+}
+
+void AjekScriptEnv::batchcall_add(const AjekReg_Table& table)
+{
+    lua_rawgeti(m_L, LUA_REGISTRYINDEX, table.m_regkey);
+    lua_rawseti(m_L, -2, ++m_batch_count);
+}
+
+bool AjekScriptEnv::batchcall_end(float arg)
+{
+    // stack: driver, fn, selves
+    // The selves table is pushed a second time so that it can be trimmed after the call.
+
+    lua_pushvalue   (m_L, -1);
+    lua_insert      (m_L, -4);
+    lua_pushinteger (m_L, m_batch_count);
+    lua_pushnumber  (m_L, arg);
+
+    int ret = lua_pcall(m_L, 4, 0, 0);
+    if (ret) {
+        xString msg = lua_tostring(m_L, -1);
+        lua_pop(m_L, 2);
+        m_lua_error = cvtLuaErrorToAjekError(ret);
+        throw_abort_ex(m_lua_error, "%s", msg.c_str());
+        return false;
+    }
+
+    for (int i=m_batch_count+1; i<=m_batch_highwater; ++i) {
+        lua_pushnil(m_L);
+        lua_rawseti(m_L, -2, i);
+    }
+    m_batch_highwater = m_batch_count;
+    lua_pop(m_L, 1);
+    return true;
+}
+
 LuaFuncScope::LuaFuncScope(LuaFuncScope&& rvalue) {
     auto&& dest = std::move(*this);
     xObjCopy(dest, rvalue);
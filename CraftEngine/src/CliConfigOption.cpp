@@ -9,6 +9,11 @@
 #include "x-stl.h"
 #include <type_traits>
 
+#if GPU_BACKEND_SOFT
+#   include "x-unipath.h"
+#   include "x-gpu-soft.h"
+#endif
+
 #if !defined(VALIDATE_CLI_OPTIONS_LIST)
 #   define VALIDATE_CLI_OPTIONS_LIST     1
 #endif
@@ -273,6 +278,19 @@ static const CliOptionDesc s_valid_options_list[] = {
     }},
     { "windowless-mode"             ,[](const xString& value){ to_bool(g_settings_app.windowless_mode, value); }},
     { "process-auto-kill"           ,[](const xString& value){ to_any_int(g_settings_app.kill_at_frame_number, value); }},
+    { "entity-gc-budget-us"         ,[](const xString& value){ to_any_int(g_settings_app.entity_gc_budget_us, value); }},
+    { "lua-tick-batching"           ,[](const xString& value){ to_bool(g_settings_app.lua_tick_batching, value); }},
+    { "entity-tick-lod"             ,[](const xString& value){ to_bool(g_settings_app.entity_tick_lod, value); }},
+    { "draw-culling"                ,[](const xString& value){ to_bool(g_settings_app.draw_culling, value); }},
+    { "render-frame-latency"        ,[](const xString& value){ to_any_int(g_settings_app.render_frame_latency, value); }},
+    { "fixed-frame-time-ms"         ,[](const xString& value){ to_float(g_settings_app.fixed_frame_time_ms, value); }},
+
+#if GPU_BACKEND_SOFT
+    { "gpu-soft-capture-frames"     ,[](const xString& value){ to_bool(g_gpu_soft_CaptureFrames, value); }},
+    { "gpu-soft-golden-image"       ,[](const xString& value){ g_gpu_soft_GoldenImage = xPathConvertFromMsw(value); }},
+    { "gpu-soft-golden-frame"       ,[](const xString& value){ to_any_int(g_gpu_soft_GoldenFrame, value); }},
+    { "gpu-soft-golden-tolerance"   ,[](const xString& value){ to_any_int(g_gpu_soft_GoldenTolerance, value); }},
+#endif
 
     { "audio-global-volume"         ,[](const xString& value){ to_float(g_settings_audio.glo_volume, value); }},
     { "audio-bgm-volume"            ,[](const xString& value){ to_float(g_settings_audio.bgm_volume, value); }},
@@ -4,9 +4,11 @@
 #include "x-stl.h"
 #include "x-assertion.h"
 #include "x-string.h"
+#include "x-thread.h"
 
 #include "x-png-decode.h"
 #include "x-gpu-ifc.h"
+#include "x-gpu-cmdlist.h"
 #include "v-float.h"
 
 #include "imgtools.h"
@@ -46,8 +48,6 @@ static GPU_ShaderVS             s_ShaderVS_DbgFont;
 static GPU_ShaderFS             s_ShaderFS_DbgFont;
 static GPU_VertexBuffer         s_mesh_anychar;
 static GPU_VertexBuffer         s_mesh_worldViewTileID;
-static GPU_ConstantBuffer       s_cnstbuf_Projection;
-static GPU_ConstantBuffer       s_cnstbuf_DbgFontSheet;
 static GPU_IndexBuffer          s_idx_UniformQuad;
 
 static GPU_ViewCameraConsts     m_ViewConsts;
@@ -67,8 +67,10 @@ void DbgFontSheet::AllocSheet(int2 sizeInPix)
     charmap     = (DbgChar*) xRealloc(charmap,  size.y * size.x * sizeof(DbgChar));
     colormap    = (DbgColor*)xRealloc(colormap, size.y * size.x * sizeof(DbgColor));
 
-    dx11_CreateDynamicVertexBuffer(gpu.mesh_charmap, size.y * size.x * sizeof(DbgChar ), "DbgTextOverlayChar");
-    dx11_CreateDynamicVertexBuffer(gpu.mesh_rgbamap, size.y * size.x * sizeof(DbgColor), "DbgTextOverlayColor");
+    dx11_CreateDynamicVertexBuffer(gpu.mesh_charmap, size.y * size.x * sizeof(DbgChar ), "DbgTextOverlayChar",  UpdateInterval);
+    dx11_CreateDynamicVertexBuffer(gpu.mesh_rgbamap, size.y * size.x * sizeof(DbgColor), "DbgTextOverlayColor", UpdateInterval);
+    gpu.framesUntilUpload = 0;
+    gpu.recordFrame       = 0;
 }
 
 template< typename T >
@@ -233,12 +235,14 @@ void DbgTextOverlay_LoadInit()
     dx11_LoadShaderVS(s_ShaderVS_DbgFont, consoleShaderFile, consoleShaderEntryVS);
     dx11_LoadShaderFS(s_ShaderFS_DbgFont, consoleShaderFile, consoleShaderEntryFS);
 
-    dx11_CreateConstantBuffer(s_cnstbuf_Projection,     sizeof(m_ViewConsts));
-    dx11_CreateConstantBuffer(s_cnstbuf_DbgFontSheet,   sizeof(g_DbgTextOverlay.gpu.consts));
     dx11_CreateIndexBuffer(s_idx_UniformQuad, g_ind_UniformQuad, sizeof(g_ind_UniformQuad));
 
     dx11_CreateStaticMesh(s_mesh_anychar,   g_mesh_UniformQuad, sizeof(g_mesh_UniformQuad[0]),  bulkof(g_mesh_UniformQuad));
 
+    // built once here rather than per-frame, since recorded command lists reference it until
+    // they're executed (possibly on the render thread).
+    DbgFont_MakeVertexLayout();
+
     u128    m_Eye;
     u128    m_At;
     u128    m_Up;           // X is angle.  Y is just +/- (orientation)? Z is unused?
@@ -263,7 +267,7 @@ void DbgTextOverlay_NewFrame()
     g_ConsoleSheet      .SceneLogic();
 }
 
-void DbgTextOverlay_SceneRender()
+void DbgTextOverlay_SceneRender(GPU_CommandList& cmds)
 {
     if (!s_canRender) return;
 
@@ -273,8 +277,22 @@ void DbgTextOverlay_SceneRender()
 
     g_DbgTextOverlay.Write(0,0, "RPGCraft Version 2018-01-01.BuildNumber");
 
-    dx11_UploadDynamicBufferData(g_DbgTextOverlay.gpu.mesh_charmap, g_DbgTextOverlay.charmap,  overlayMeshSize * sizeof(DbgChar ));
-    dx11_UploadDynamicBufferData(g_DbgTextOverlay.gpu.mesh_rgbamap, g_DbgTextOverlay.colormap, overlayMeshSize * sizeof(DbgColor));
+    // The countdown advances per recorded frame, but the backend measures the update interval in
+    // executed GPU frames.  If any frame went by without the overlay being recorded (s_canRender
+    // toggled, one-off error frames) the two drift apart, so upload now -- early is harmless, late
+    // trips the sparse buffer miss check.  With a pipelined render thread the count may also jump
+    // by two between recordings, which only costs an extra upload.
+    int gpuframe = cvolatize32(g_gpu_host_framecount);
+    if (gpuframe - g_DbgTextOverlay.gpu.recordFrame > 1) {
+        g_DbgTextOverlay.gpu.framesUntilUpload = 0;
+    }
+    g_DbgTextOverlay.gpu.recordFrame = gpuframe;
+
+    if (--g_DbgTextOverlay.gpu.framesUntilUpload <= 0) {
+        cmds.UploadDynamicBufferData(g_DbgTextOverlay.gpu.mesh_charmap, g_DbgTextOverlay.charmap,  overlayMeshSize * sizeof(DbgChar ));
+        cmds.UploadDynamicBufferData(g_DbgTextOverlay.gpu.mesh_rgbamap, g_DbgTextOverlay.colormap, overlayMeshSize * sizeof(DbgColor));
+        g_DbgTextOverlay.gpu.framesUntilUpload = DbgFontSheet::UpdateInterval;
+    }
 
     g_DbgTextOverlay.gpu.consts.SrcTexTileSizeUV    = vFloat2(1.0f / DbgFont::CharacterCodeCount, 1.0f);
     g_DbgTextOverlay.gpu.consts.SrcTexSizeInTiles   = vInt2(DbgFont::CharacterCodeCount,1);
@@ -288,29 +306,25 @@ void DbgTextOverlay_SceneRender()
     viewConsts.View         = XMMatrixTranspose(m_ViewConsts.View);
     viewConsts.Projection   = XMMatrixTranspose(m_ViewConsts.Projection);
 
-    dx11_UpdateConstantBuffer(s_cnstbuf_Projection,     &viewConsts);
-    dx11_UpdateConstantBuffer(s_cnstbuf_DbgFontSheet,   &g_DbgTextOverlay.gpu.consts);
-
     // Render!
 
-    DbgFont_MakeVertexLayout();
-    dx11_SetInputLayout(InputLayout_DbgFont);
+    cmds.SetInputLayout(InputLayout_DbgFont);
 
-    dx11_BindShaderVS(s_ShaderVS_DbgFont);
-    dx11_BindShaderFS(s_ShaderFS_DbgFont);
+    cmds.BindShaderVS(s_ShaderVS_DbgFont);
+    cmds.BindShaderFS(s_ShaderFS_DbgFont);
 
-    dx11_BindShaderResource(tex_6x8, 0);
+    cmds.BindShaderResource(tex_6x8, 0);
 
-    dx11_SetVertexBuffer(s_mesh_anychar,                    0, sizeof(g_mesh_UniformQuad[0]), 0);
-    dx11_SetVertexBuffer(g_DbgTextOverlay.gpu.mesh_charmap, 1, sizeof(DbgChar),  0);
-    dx11_SetVertexBuffer(g_DbgTextOverlay.gpu.mesh_rgbamap, 2, sizeof(DbgColor), 0);
+    cmds.SetVertexBuffer(s_mesh_anychar,                    0, sizeof(g_mesh_UniformQuad[0]), 0);
+    cmds.SetVertexBuffer(g_DbgTextOverlay.gpu.mesh_charmap, 1, sizeof(DbgChar),  0);
+    cmds.SetVertexBuffer(g_DbgTextOverlay.gpu.mesh_rgbamap, 2, sizeof(DbgColor), 0);
 
-    //dx11_SetVertexBuffer(g_mesh_worldViewColor, 2, sizeof(g_ViewUV[0]), 0);
+    //cmds.SetVertexBuffer(g_mesh_worldViewColor, 2, sizeof(g_ViewUV[0]), 0);
 
-    dx11_BindConstantBuffer(s_cnstbuf_Projection,   0);
-    dx11_BindConstantBuffer(s_cnstbuf_DbgFontSheet, 1);
-    dx11_SetIndexBuffer(s_idx_UniformQuad, 16, 0);
-    dx11_SetPrimType(GPU_PRIM_TRIANGLELIST);
-    dx11_DrawIndexedInstanced(6, overlayMeshSize, 0, 0, 0);
+    cmds.BindConstants(viewConsts,                  0);
+    cmds.BindConstants(g_DbgTextOverlay.gpu.consts, 1);
+    cmds.SetIndexBuffer(s_idx_UniformQuad, 16, 0);
+    cmds.SetPrimType(GPU_PRIM_TRIANGLELIST);
+    cmds.DrawIndexedInstanced(6, overlayMeshSize, 0, 0, 0);
 
 }
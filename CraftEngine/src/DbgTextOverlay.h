@@ -3,6 +3,7 @@
 #include "x-types.h"
 #include "v-float.h"
 #include "x-gpu-ifc.h"
+#include "x-gpu-cmdlist.h"
 
 #include "x-ForwardDefs.h"
 
@@ -40,6 +41,10 @@ union DbgColor
 
 struct DbgFontSheet
 {
+    // Debug text tolerates lagging a few frames behind, so the char and color meshes are uploaded
+    // sparsely rather than every frame.
+    static const int UpdateInterval = 3;
+
     int2    size;
 
     DbgChar*    charmap;
@@ -49,6 +54,8 @@ struct DbgFontSheet
         GPU_DbgFontConstants    consts;
         GPU_DynVsBuffer         mesh_charmap;
         GPU_DynVsBuffer         mesh_rgbamap;
+        int                     framesUntilUpload;      // meshes are refreshed once per UpdateInterval frames
+        int                     recordFrame;            // g_gpu_host_framecount as of the most recent SceneRender
     } gpu;
 
     struct {
@@ -71,6 +78,6 @@ struct DbgFontDrawItem
 
 extern void DbgTextOverlay_LoadInit        ();
 extern void DbgTextOverlay_NewFrame        ();
-extern void DbgTextOverlay_SceneRender     ();
+extern void DbgTextOverlay_SceneRender     (GPU_CommandList& cmds);
 
 extern DbgFontSheet g_DbgTextOverlay;
@@ -5,11 +5,19 @@
 #include "x-assertion.h"
 #include "x-string.h"
 #include "x-thread.h"
-#include "x-atomic.h"
+#include "x-chrono.h"
 
 #include "Entity.h"
+#include "EntityHeap.h"
+#include "EntityComponents.h"
+#include "EntityPrefab.h"
+#include "EntityEvents.h"
+#include "Scene.h"
 
 #include <unordered_set>
+#include <algorithm>
+#include <climits>
+#include <cfloat>
 
 // Entity Engineering Thoughts:
 //   Currently supporting managed and unmanaged entities for sake of completeness.  Unmnaged entities
@@ -17,70 +25,200 @@
 //   actually no good motivation currently to even have these as part of the "entity system."  I'm going
 //   to leave the managed flag in for now tho, in case some use case crops up.  --jstine
 //
-//   Entity lookup by gid_t can be optimized considerably using an associative cache.
-//      * create a fixed-sized array large enough to handle most entities in a scene (64k), containing:
-//               gid_t, pointer to entity
-//      * do lookup using gid_t & (cache_size-1)
-//               if (cache[gid_masked] == gid) { return result; } else { do_full_lookup(); }
+//   Entity lookup by gid_t is an indexed read into a dense slot table (see EntitySlotTable).  The GID
+//   carries a generation counter which is bumped when the slot is released, so stale GIDs from deleted
+//   entities fail lookup rather than aliasing onto a newly spawned entity.
 
 #define EntityLog(...)      log_host( __VA_ARGS__ )
 
-static u32 s_entity_spawn_id = 1;
-
 EntityPointerContainer  g_GlobalEntities;
 EntityNameAssociator    g_EntitiesByName;
 
 
-static std::vector<EntityGid_t> s_DeletedEntities;
+// Removed entities are freed only once the frame in which they were removed has finished rendering,
+// since draw lists built during that frame may still reference the object.  The queue is naturally
+// ordered by removal frame, so collection stops at the first entry that hasn't yet cleared its fence.
+struct DeletedEntityItem
+{
+    EntityGid_t     gid;
+    int             frame;          // scene frame during which the entity was removed
+};
+
+static std::deque<DeletedEntityItem>    s_DeletedEntities;
+static EntityGcStats                    s_gc_stats;
+
+static void removeFromNameIndex(const EntityPointerContainerItem& item);
+
+static u32 nextGeneration(u32 generation)
+{
+    // zero is an invalid generation, so that a GID of zero is never issued.
+    generation = (generation + 1) & EntityGid_GenMask;
+    return generation ? generation : 1;
+}
+
+EntityGid_t EntitySlotTable::Reserve()
+{
+    if (!m_freelist.empty()) {
+        auto idx = m_freelist.front();
+        m_freelist.pop_front();
+        m_liveCount += 1;
+        return m_slots[idx].gid;
+    }
+
+    auto idx = (u32)m_slots.size();
+    x_abort_on(idx > EntityGid_IndexMask, "Ran out of entity slots (max=%u)", EntityGid_IndexMask+1);
+
+    EntityPointerContainerItem item = {};
+    item.gid = MakeEntityGid(idx, 1);
+    m_slots.push_back(item);
+    m_liveCount += 1;
+    return item.gid;
+}
 
-static EntityGid_t getNextSpawnId()
+// Reserves count slots, growing the slot array at most once.  Recycled slots are issued first,
+// in the same FIFO order as Reserve().
+void EntitySlotTable::ReserveBatch(int count, EntityGid_t* dest)
 {
-    u32 result = AtomicInc((s32&)s_entity_spawn_id);
-    if (result == 0) {
-        // wrapped around the world.  impressive.
-        log_host("super-secret impossible easter egg found!");
-        // but zero is an invalid spawn ID, so discard it:
-        result = AtomicInc((s32&)s_entity_spawn_id);
+    int numRecycled = std::min(count, (int)m_freelist.size());
+    int numNew      = count - numRecycled;
+
+    for (int i=0; i<numRecycled; ++i) {
+        dest[i] = m_slots[m_freelist.front()].gid;
+        m_freelist.pop_front();
+    }
+
+    if (numNew) {
+        auto first = (u32)m_slots.size();
+        x_abort_on(first + numNew - 1 > EntityGid_IndexMask, "Ran out of entity slots (max=%u)", EntityGid_IndexMask+1);
+        m_slots.resize(first + numNew);
+        for (int i=0; i<numNew; ++i) {
+            auto& item = m_slots[first + i];
+            item = {};
+            item.gid = MakeEntityGid(first + i, 1);
+            dest[numRecycled + i] = item.gid;
+        }
     }
-    return { result };
+
+    m_liveCount += count;
+}
+
+void EntitySlotTable::Release(EntityGid_t gid)
+{
+    auto idx = gid.Index();
+    bug_on(idx >= m_slots.size());
+    auto& item = m_slots[idx];
+    bug_on(item.gid != gid);
+
+    item = {};
+    item.gid = MakeEntityGid(idx, nextGeneration(gid.Generation()));
+    m_freelist.push_back(idx);
+    m_liveCount -= 1;
 }
 
+// Releases all slots but retains their generation counters, so that GIDs held across a
+// reset remain stale rather than resolving to entities spawned after the reset.
+void EntitySlotTable::Clear()
+{
+    m_freelist.clear();
+    u32 idx = 0;
+    for (auto& item : m_slots) {
+        auto generation = item.objectptr ? nextGeneration(item.gid.Generation()) : item.gid.Generation();
+        item = {};
+        item.gid = MakeEntityGid(idx, generation);
+        m_freelist.push_back(idx);
+        ++idx;
+    }
+    m_liveCount = 0;
+}
 
 void* Entity_Malloc(int size)
 {
-    return xMalloc(size);
+    return EntityHeap_Alloc(size);
 }
 
 static void freeManagedEntity(EntityPointerContainerItem& item)
 {
-    xFree(item.classname);
+    // classname is interned and lives until the next EntityManager_Reset.
     if (item.managed) {
-        xFree(item.objectptr);
+        if (item.prefab && EntityPrefab_Recycle(item.prefab, item.objectptr)) return;
+        EntityHeap_Free(item.objectptr);
     }
 }
 
 void EntityManager_Reset()
 {
-    // Remove this once global entity MSPACE is provided...
-    for(auto& item : g_GlobalEntities) {
-        freeManagedEntity(item.second);
-    }
-
-    g_GlobalEntities.clear();
+    // Managed entities are never destructed, so there's no need to visit them individually.
+    // The entity heap is rewound in one go.
+    g_GlobalEntities.Clear();
     g_EntitiesByName.clear();
-    // Wipe mspace here...
+    s_DeletedEntities.clear();
+    s_gc_stats.queueDepth = 0;
+    EntityComponents_Reset();
+    EntityEvents_Reset();
+    EntityPrefab_ResetPools();
+    EntityHeap_Reset();
 }
 
-void EntityManager_CollectGarbage()
+static void collectEntity(EntityGid_t gid)
+{
+    auto* item = g_GlobalEntities.TryLookup( gid );
+    if (!item) return;
+    removeFromNameIndex(*item);
+    EntityComponents_Detach(gid);
+    freeManagedEntity(*item);
+    g_GlobalEntities.Release(gid);
+}
+
+// Frees removed entities whose removal frame is at or before completedFrame, stopping early once
+// budgetUs microseconds have elapsed.  Entities not processed carry over to the next call.
+// A budget of zero (or less) is unlimited.
+void EntityManager_CollectGarbage(int completedFrame, int budgetUs)
 {
-    for (const auto& gid : s_DeletedEntities)
+    // Checking the clock is not free, so it's only sampled every few entities.
+    static const int ClockCheckInterval = 16;
+
+    auto startTime  = HostClockTick::Now();
+    auto deadline   = startTime + HostClockTick::Seconds(budgetUs / 1000000.0);
+    int  numFreed   = 0;
+
+    while (!s_DeletedEntities.empty())
     {
-        auto it = g_GlobalEntities.find( gid );
-        if (it == g_GlobalEntities.end()) continue;
-        freeManagedEntity(it->second);
-        g_GlobalEntities.erase(it);
+        const auto& front = s_DeletedEntities.front();
+        if (front.frame > completedFrame) break;
+
+        collectEntity(front.gid);
+        s_DeletedEntities.pop_front();
+        numFreed += 1;
+
+        if (budgetUs > 0 && (numFreed % ClockCheckInterval) == 0) {
+            if (HostClockTick::Now() >= deadline) break;
+        }
     }
-    s_DeletedEntities.clear();
+
+    s_gc_stats.queueDepth       = (int)s_DeletedEntities.size();
+    s_gc_stats.freedLastFrame   = numFreed;
+    s_gc_stats.lastFrameUs      = (HostClockTick::Now() - startTime).asMicroseconds();
+    s_gc_stats.totalFreed      += numFreed;
+}
+
+void EntityManager_CollectGarbage()
+{
+    EntityManager_CollectGarbage(INT_MAX, 0);
+}
+
+int EntityManager_GetDeferredQueueDepth()
+{
+    return (int)s_DeletedEntities.size();
+}
+
+const EntityGcStats& EntityManager_GetGcStats()
+{
+    return s_gc_stats;
+}
+
+const EntityPointerContainer& EntityManager_GetEntities()
+{
+    return g_GlobalEntities;
 }
 
 const EntityPointerContainerItem s_missing =
@@ -92,13 +230,16 @@ const EntityPointerContainerItem s_missing =
     false
 };
 
-u32 _getStringHash(const char* name, int length, u32 curhash=0)
+// Runtime counterpart to Crc32c_ConstExpr -- both must produce identical results.
+StringHashVal Entity_GetNameHash(const char* name, int length)
 {
-    u32 result = curhash;
+    u32 result = 0;
     const char* c = name;
     int i=0;
-    for(; i<length/8; i += 4) {
-        result = i_crc32(result, (u32&)c[i]);
+    for(; i+8 <= length; i += 8) {
+        u64 chunk;
+        memcpy(&chunk, c+i, sizeof(chunk));
+        result = i_crc32(result, chunk);
     }
 
     for(; i<length; i += 1) {
@@ -108,45 +249,68 @@ u32 _getStringHash(const char* name, int length, u32 curhash=0)
     return result;
 }
 
-__xi const EntityPointerContainerItem* _impl_entity_TryLookup(const char* name, int length)
+const EntityPointerContainerItem* _impl_entity_TryLookup(const EntityNameKey& key)
 {
-    auto result = _getStringHash(name, length);
-    auto it1 = g_EntitiesByName.find(result);
-    auto it2 = g_GlobalEntities.find(it1->second);
-
-    if (it2 == g_GlobalEntities.end()) return nullptr;
-    return &it2->second;
+    // Multiple entities may share a name (or a hash).  The string is always verified, and the first
+    // live entity with a matching name wins.
+    auto range = g_EntitiesByName.equal_range(key.hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const auto& entry = it->second;
+        if (entry.length != key.length) continue;
+        if (entry.name != key.name && memcmp(entry.name, key.name, key.length)) continue;
+        auto* result = g_GlobalEntities.TryLookup(entry.gid);
+        if (result && !result->deleted) {
+            return result;
+        }
+    }
+    return nullptr;
 }
 
-const EntityPointerContainerItem& _impl_entity_Lookup(const char* name, int length)
+const EntityPointerContainerItem& _impl_entity_Lookup(const EntityNameKey& key)
 {
-    auto* result = _impl_entity_TryLookup(name, length);
+    auto* result = _impl_entity_TryLookup(key);
     if (!result) return s_missing;
     return *result;
 }
 
+static __ai EntityNameKey makeNameKey(const xString& name)
+{
+    return EntityNameKey(name.c_str(), (int)name.GetLength(), Entity_GetNameHash(name.c_str(), (int)name.GetLength()));
+}
+
+static void removeFromNameIndex(const EntityPointerContainerItem& item)
+{
+    if (!item.classname) return;
+    auto length = (int)strlen(item.classname);
+    auto range  = g_EntitiesByName.equal_range(Entity_GetNameHash(item.classname, length));
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.gid == item.gid) {
+            g_EntitiesByName.erase(it);
+            return;
+        }
+    }
+}
+
 const EntityPointerContainerItem* Entity_TryLookup(EntityGid_t gid)
 {
-    auto it = g_GlobalEntities.find( gid );
-    if (it == g_GlobalEntities.end()) return nullptr;
-    return &it->second;
+    return g_GlobalEntities.TryLookup( gid );
 }
 
 const EntityPointerContainerItem& Entity_Lookup(const xString& name)
 {
-    return _impl_entity_Lookup(name, name.GetLength());
+    return _impl_entity_Lookup(makeNameKey(name));
 }
 
 const EntityPointerContainerItem* Entity_TryLookup(const xString& name)
 {
-    return _impl_entity_TryLookup(name, name.GetLength());
+    return _impl_entity_TryLookup(makeNameKey(name));
 }
 
 const EntityPointerContainerItem& Entity_Lookup(EntityGid_t gid)
 {
-    auto it = g_GlobalEntities.find( gid );
-    if (it == g_GlobalEntities.end()) return s_missing;
-    return it->second;
+    auto* item = g_GlobalEntities.TryLookup( gid );
+    if (!item) return s_missing;
+    return *item;
 }
 
 const char* Entity_LookupName(EntityGid_t gid)
@@ -156,37 +320,36 @@ const char* Entity_LookupName(EntityGid_t gid)
 
 void Entity_Remove(EntityGid_t gid)
 {
-    auto it = g_GlobalEntities.find( gid );
-    if (it == g_GlobalEntities.end()) return;
-    if (it->second.managed) {
-        s_DeletedEntities.push_back(gid);
-        it->second.deleted = 1;
-    }
+    bug_on(xWorkerPool_InParallelRegion(), "Entities cannot be removed from parallel ticks.");
+
+    auto* item = g_GlobalEntities.TryLookup( gid );
+    if (!item || item->deleted) return;
+
+    // Unmanaged entities are queued like managed ones, even though they own no heap memory besides
+    // the interned classname: the slot has to stay resolvable until in-flight frames are done with
+    // it.  Tick entries are dropped here, so the gid is never ticked after it has been collected.
+    s_DeletedEntities.push_back({ gid, Scene_GetFrameCount() });
+    item->deleted = 1;
+    g_tickable_entities.Remove(gid);
 }
 
 EntityGid_t _impl_Entity_Spawn(EntityPointerContainerItem& item, const char* classname)
 {
     // TODO - change asManaged to a proper enum type.
 
-    char* namedup = nullptr;
-    auto  namelen = strlen(classname);
-    if (namelen) {
-        namedup = (char*)xMalloc(namelen+1);
-        strcpy(namedup, classname);
-    }
+    bug_on(xWorkerPool_InParallelRegion(), "Entities cannot be spawned from parallel ticks.");
 
-    item.classname = namedup;
+    auto  namelen = classname ? strlen(classname) : 0;
+    item.classname = EntityHeap_InternName(classname);
 
-    for (;;) {
-        item.gid = getNextSpawnId();
-        if (g_GlobalEntities.find(item.gid) != g_GlobalEntities.end()) {
-            continue;
-        }
-        auto namehash = _getStringHash(classname, namelen);
-        g_GlobalEntities.insert({item.gid, item});
-        g_EntitiesByName.insert({namehash, item.gid});
-        return item.gid;
+    item.gid = g_GlobalEntities.Reserve();
+    g_GlobalEntities.m_slots[item.gid.Index()] = item;
+
+    if (item.classname) {
+        auto namehash = Entity_GetNameHash(item.classname, (int)namelen);
+        g_EntitiesByName.insert({ namehash, { item.gid, item.classname, (int)namelen } });
     }
+    return item.gid;
 }
 
 void Entity_AddUnmanaged(EntityGid_t& gid, void* entity, const char* classname)
@@ -197,6 +360,7 @@ void Entity_AddUnmanaged(EntityGid_t& gid, void* entity, const char* classname)
     item.objectptr      = entity;
     item.managed        = 0;
     item.deleted        = 0;
+    item.prefab         = 0;
     gid = _impl_Entity_Spawn(item, classname);
 }
 
@@ -207,70 +371,172 @@ EntityGid_t Entity_AddManaged(void* entity, const char* classname)
     item.objectptr      = entity;
     item.managed        = 1;
     item.deleted        = 0;
+    item.prefab         = 0;
     return _impl_Entity_Spawn(item, classname);
 }
 
+// Registers count managed entities which share a classname.  The classname is interned and hashed
+// once for the whole batch, and the slot table and name index are grown at most once.
+void Entity_AddManagedBatch(void* const* entities, int count, const char* classname, s32 prefab, EntityGid_t* destGids)
+{
+    bug_on(xWorkerPool_InParallelRegion(), "Entities cannot be spawned from parallel ticks.");
+    if (count <= 0) return;
+
+    auto  namelen   = classname ? (int)strlen(classname) : 0;
+    auto* interned  = EntityHeap_InternName(classname);
+    auto  namehash  = interned ? Entity_GetNameHash(interned, namelen) : 0;
+
+    g_GlobalEntities.ReserveBatch(count, destGids);
+    if (interned) {
+        g_EntitiesByName.reserve(g_EntitiesByName.size() + count);
+    }
+
+    for (int i=0; i<count; ++i) {
+        auto& item      = g_GlobalEntities.m_slots[destGids[i].Index()];
+        item.gid        = destGids[i];
+        item.objectptr  = entities[i];
+        item.classname  = interned;
+        item.lua_object = {};
+        item.managed    = 1;
+        item.deleted    = 0;
+        item.prefab     = prefab;
+
+        if (interned) {
+            g_EntitiesByName.insert({ namehash, { item.gid, interned, namelen } });
+        }
+    }
+}
+
+// Applies all deferred adds and removes in a single batch:
+//   1. removals are collected (and cancel any adds queued ahead of them),
+//   2. the sorted array is compacted in one pass,
+//   3. surviving adds are sorted and merged in, ignoring duplicates.
+// Events are processed in submission order, so an add following a remove of the same item survives.
 void TickableEntityContainer::ExecEventQueue()
 {
-    //todo( "implement me!" );
-    //m_evt_queue
+    bug_on (m_iterator_mode, "Cannot modify tickable entity list while it is being iterated.");
+
+    if (m_evt_queue.empty()) return;
+
+    m_pending_adds      .clear();
+    m_pending_removes   .clear();
+
+    auto matchesRemove = [](const EntityGidOrderPair& item, const EntityGidOrderPair& rem) {
+        return (item.Gid() == rem.Gid()) && (rem.Order() == (u32)-1 || rem.Order() == item.Order());
+    };
+
+    for (const auto& evt : m_evt_queue) {
+        switch (evt.evtId) {
+            case ECEvt_EntityAdd:
+                m_pending_adds.push_back(evt.entityInfo);
+            break;
+
+            case ECEvt_EntityRemove: {
+                const auto& rem = evt.entityInfo.orderGidPair;
+                m_pending_adds.erase(
+                    std::remove_if(m_pending_adds.begin(), m_pending_adds.end(), [&](const TickableEntityItem& item) {
+                        return matchesRemove(item.orderGidPair, rem);
+                    }),
+                    m_pending_adds.end()
+                );
+                m_pending_removes.push_back(rem);
+            } break;
+
+            default: unreachable();
+        }
+    }
+    m_evt_queue.clear();
+
+    if (!m_pending_removes.empty()) {
+        std::sort(m_pending_removes.begin(), m_pending_removes.end(), [](const EntityGidOrderPair& left, const EntityGidOrderPair& right) {
+            return left.Gid().val < right.Gid().val;
+        });
+
+        m_ordered.erase(
+            std::remove_if(m_ordered.begin(), m_ordered.end(), [&](const TickableEntityItem& item) {
+                auto it = std::lower_bound(m_pending_removes.begin(), m_pending_removes.end(), item.orderGidPair,
+                    [](const EntityGidOrderPair& left, const EntityGidOrderPair& right) {
+                        return left.Gid().val < right.Gid().val;
+                    }
+                );
+                for (; it != m_pending_removes.end() && it->Gid() == item.orderGidPair.Gid(); ++it) {
+                    if (matchesRemove(item.orderGidPair, *it)) return true;
+                }
+                return false;
+            }),
+            m_ordered.end()
+        );
+    }
+
+    if (!m_pending_adds.empty()) {
+        // stable sort + stable merge: when duplicates exist, the item already in the list (or the
+        // earliest queued add) is kept, matching std::set insertion semantics.
+        std::stable_sort(m_pending_adds.begin(), m_pending_adds.end(), CompareTickableEntity_Less());
+
+        auto oldSize = m_ordered.size();
+        m_ordered.insert(m_ordered.end(), m_pending_adds.begin(), m_pending_adds.end());
+        std::inplace_merge(m_ordered.begin(), m_ordered.begin() + oldSize, m_ordered.end(), CompareTickableEntity_Less());
+
+        m_ordered.erase(
+            std::unique(m_ordered.begin(), m_ordered.end(), [](const TickableEntityItem& left, const TickableEntityItem& right) {
+                return left.orderGidPair.m_fullSortOrder == right.orderGidPair.m_fullSortOrder;
+            }),
+            m_ordered.end()
+        );
+    }
 }
 
 void TickableEntityContainer::Clear()
 {
-    m_hashed    .clear();
+    bug_on (m_iterator_mode, "Cannot clear tickable entity list while it is being iterated.");
     m_ordered   .clear();
-
-    // also clears memory which I'm not too thrilled aobut, but std::queue has no clear..
-    m_evt_queue = {};
+    m_evt_queue .clear();
 }
 
+// _Add and Remove may be called from parallel entity ticks.
 void TickableEntityContainer::_Add(const TickableEntityItem& entityInfo)
 {
-    if (!m_iterator_mode) {
-        m_hashed    .insert( { entityInfo.orderGidPair.Gid(), entityInfo.orderGidPair } );
-        m_ordered   .insert(entityInfo);
-    }
-    else {
-        m_evt_queue.push( { ECEvt_EntityAdd, entityInfo } );
-    }
+    xScopedSpinLock lock(m_evt_lock);
+    m_evt_queue.push_back( { ECEvt_EntityAdd, entityInfo } );
 }
 
 void TickableEntityContainer::Remove(EntityGid_t entityGid, u32 order)
 {
-    auto hashit = m_hashed.equal_range( entityGid );
+    xScopedSpinLock lock(m_evt_lock);
+    m_evt_queue.push_back( { ECEvt_EntityRemove, { MakeGidOrder(entityGid, order), nullptr } } );
+}
+
+// Draw lists are non-persistent, wiped before each Logic() update.  Therefore this container
+// doesn't need fast removal capability, and a flat array sorted once per frame (see Sort) beats
+// any node-based ordered container for both insertion and traversal.
+
+void OrderedDrawList::_Add(const DrawListItem& entityInfo, float zorder)
+{
+    static const float4 unbounded = { -FLT_MAX, -FLT_MAX, FLT_MAX, FLT_MAX };
+
+    xScopedSpinLock lock(m_add_lock);
+    m_ordered.push_back({ zorder, entityInfo, unbounded });
+    m_sorted = false;
+}
 
-    if (hashit.first == m_hashed.end()) {
-        // item not found... ?
+void OrderedDrawList::_Add(const DrawListItem& entityInfo, float zorder, const float4& bounds)
+{
+    if (!IsVisible(bounds)) {
+        AtomicInc(m_numCulled);
         return;
     }
 
-    if (!m_iterator_mode) {
-        for (auto it=hashit.first; it!=hashit.second; ++it) {
-            if (order != (u32)-1) {
-                if (it->second.Order() != order) {
-                    continue;
-                }
-            }
-            // don't care about function ptr, it's not checked as part of set comparison operation.
-            m_ordered.erase({ it->second, nullptr });
-            m_hashed.erase(it);
-        }
-    }
-    else {
-        m_evt_queue.push({ ECEvt_EntityRemove, { MakeGidOrder(entityGid, order), nullptr } });
-    }
+    xScopedSpinLock lock(m_add_lock);
+    m_ordered.push_back({ zorder, entityInfo, bounds });
+    m_sorted = false;
 }
 
-// todo: m_hashed is only needed for persistent-style entity lists, where quick removal is important.
-// Draw lists will instead be non-persistent, wiped before each Logic() update.  Therefore this container
-// doesn't need fast removal capability.  Using a hashed set should still be fine for performance.
-// On theory a linked list might be slightly faster for sorted insertion... but they have a lot of other
-// drawbacks so let's stick to the set unless it becomes a problem.  --jstine
-
-void OrderedDrawList::_Add(const DrawListItem& entityInfo, float zorder)
+// Enables culling of bounded items for the remainder of the frame.  area is in tile coords:
+// xy = min, zw = max.  Must be called before items are added.
+void OrderedDrawList::SetVisibleArea(const float4& area)
 {
-    m_ordered.insert({ zorder, entityInfo });
+    m_visibleArea   = area;
+    m_cull          = true;
 }
 
 void OrderedDrawList::Add(EntityGid_t entityGid, float zorder, EntityFn_Draw* draw) {
@@ -297,16 +563,10 @@ void OrderedDrawList::Remove(EntityGid_t entityGid, float order)
 
 void OrderedDrawList::Remove(void* objectData, float order)
 {
-    auto itpair = m_ordered.equal_range(order);
-    auto it = itpair.first;
-    while (it != m_ordered.end() && it != itpair.second) {
-        if (it->second.ObjectData == objectData) {
-            it = m_ordered.erase(it);
-        }
-        else {
-            ++it;
-        }
-    }
+    auto it = std::remove_if(m_ordered.begin(), m_ordered.end(), [&](const DrawListEntry& entry) {
+        return entry.zorder == order && entry.item.ObjectData == objectData;
+    });
+    m_ordered.erase(it, m_ordered.end());
 }
 
 void OrderedDrawList::Remove(EntityGid_t entityGid)
@@ -319,19 +579,77 @@ void OrderedDrawList::Remove(EntityGid_t entityGid)
 
 void OrderedDrawList::Remove(void* objectData)
 {
-    auto it = m_ordered.begin();
-    while (it != m_ordered.end()) {
-        if (it->second.ObjectData == objectData) {
-            it = m_ordered.erase(it);
-        }
-        else {
-            ++it;
-        }
-    }
+    auto it = std::remove_if(m_ordered.begin(), m_ordered.end(), [&](const DrawListEntry& entry) {
+        return entry.item.ObjectData == objectData;
+    });
+    m_ordered.erase(it, m_ordered.end());
 }
 
 
 void OrderedDrawList::Clear()
 {
     m_ordered   .clear();
+    m_sorted    = true;
+    m_cull      = false;
+    m_numCulled = 0;
+}
+
+// Maps a float onto a u32 which sorts in the same order as the float, when compared as unsigned:
+// negative values have all bits flipped (reversing their order), positive values have just the
+// sign bit flipped (placing them above all negatives).
+static __ai u32 makeSortableFloatKey(float zorder)
+{
+    u32 bits = (u32&)zorder;
+    u32 mask = (bits & 0x80000000u) ? 0xffffffffu : 0x80000000u;
+    return bits ^ mask;
+}
+
+// Four 8-bit LSD radix passes, ping-ponging between m_ordered and m_sort_scratch.  Passes in which
+// every key shares the same digit are skipped, which is the common case since draw lists tend to
+// use a handful of distinct z-orders.
+void OrderedDrawList::Sort()
+{
+    if (m_sorted) return;
+    m_sorted = true;
+
+    int count = (int)m_ordered.size();
+    if (count < 2) return;
+
+    u32 histogram[4][256] = {};
+    for (const auto& entry : m_ordered) {
+        u32 key = makeSortableFloatKey(entry.zorder);
+        histogram[0][(key >>  0) & 0xff] += 1;
+        histogram[1][(key >>  8) & 0xff] += 1;
+        histogram[2][(key >> 16) & 0xff] += 1;
+        histogram[3][(key >> 24) & 0xff] += 1;
+    }
+
+    m_sort_scratch.resize(count);
+    auto* src = &m_ordered;
+    auto* dst = &m_sort_scratch;
+
+    for (int pass=0; pass<4; ++pass) {
+        auto& hist  = histogram[pass];
+        int   shift = pass * 8;
+
+        u32 firstDigit = (makeSortableFloatKey((*src)[0].zorder) >> shift) & 0xff;
+        if (hist[firstDigit] == (u32)count) continue;
+
+        u32 offset[256];
+        u32 sum = 0;
+        for (int i=0; i<256; ++i) {
+            offset[i] = sum;
+            sum += hist[i];
+        }
+
+        for (const auto& entry : *src) {
+            u32 digit = (makeSortableFloatKey(entry.zorder) >> shift) & 0xff;
+            (*dst)[offset[digit]++] = entry;
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != &m_ordered) {
+        m_ordered.swap(m_sort_scratch);
+    }
 }
@@ -2,6 +2,7 @@
 
 #include "x-types.h"
 #include "x-stl.h"
+#include "x-workers.h"
 
 #include "ajek-script.h"
 
@@ -10,6 +11,9 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <queue>
+#include <deque>
+#include <type_traits>
+#include <vector>
 
 struct  EntityContainerEvent;
 
@@ -20,10 +24,22 @@ enum EntityContainerEvent_t
 };
 
 // EntityGid_t - Opaque type to avoid accidents during function overloading.
+//   The GID encodes a slot index into the global entity table (lower bits) and a generation counter
+//   (upper bits).  The generation is bumped each time a slot is released, so a stale GID fails lookup
+//   instead of resolving to whatever entity was spawned into the slot afterward.  Generation zero is
+//   never issued, which keeps a GID value of zero (ESGID_Empty) invalid.
+//
+static const int EntityGid_IndexBits    = 20;       // 1 million concurrent entities
+static const u32 EntityGid_IndexMask    = (1ul << EntityGid_IndexBits) - 1;
+static const u32 EntityGid_GenMask      = (1ul << (32 - EntityGid_IndexBits)) - 1;
+
 struct EntityGid_t
 {
     u32     val;
 
+    __ai u32 Index      () const { return val & EntityGid_IndexMask;   }
+    __ai u32 Generation () const { return val >> EntityGid_IndexBits;  }
+
     bool operator==(const EntityGid_t& right) const { return  val == right.val; }
     bool operator!=(const EntityGid_t& right) const { return  val != right.val; }
 };
@@ -32,16 +48,10 @@ enum EntitySystemGID_t : u32 {
     ESGID_Empty     = 0,
 };
 
-// Global hash registry can be optimized later using hash table LUT:
-//  - Define set maximum such as 20 bits of entity GIDs (1 million).
-//  - Pick new IDs sequentually.
-//  - If an entity exists in an ID slot, keep trying until an empty slot is realized.
-//
-// Or --
-//  - Define a smaller set maximum, eg. 14 bits (16k entities)
-//  - Perform a "cache check" when grabbing an entity to ensure that the full GID matches the cached one.
-//  - On mismatch, perform cache eviction -- reload correct entity from global hash into "fast lut"
-//
+inline EntityGid_t MakeEntityGid(u32 index, u32 generation)
+{
+    return { (index & EntityGid_IndexMask) | ((generation & EntityGid_GenMask) << EntityGid_IndexBits) };
+}
 
 typedef void (EntityFn_LogicTick)   (       void* objdata, int order, float deltaTime);
 typedef void (EntityFn_Draw)        (const  void* objdata, float zorder);
@@ -92,10 +102,27 @@ struct EntityPointerContainerItem
 {
     EntityGid_t     gid;
     void*           objectptr;
-    char*           classname;      // alloc'd in same heap as entity
+    const char*     classname;      // interned into the entity heap
     AjekReg_Table   lua_object;     // self table from lua
     bool            managed;        // managed entities are on the entity heap
-    bool            deleted;        // managed entity has been deleted.
+    bool            deleted;        // entity has been removed and is awaiting collection
+    s32             prefab;         // EntityPrefabId the entity was spawned from, or 0
+};
+
+enum EntityTickFlags : u32
+{
+    EntityTick_Default      = 0,
+
+    // Tick is independent of all other parallel ticks sharing the same order value, and may be run
+    // concurrently with them on worker threads.  Native ticks only.  Parallel ticks must not spawn
+    // entities or touch any other shared state that lacks its own thread safety.
+    EntityTick_Parallel     = (1<<0),
+
+    // Tick rate is reduced with distance from the view camera: every frame within the view, then every
+    // 2nd, 4th, or 8th frame in successive outer rings.  The tick receives the delta time accumulated
+    // since it last ran.  Requires an EntComp_Position row (entities without one tick at full rate),
+    // and native ticks only.  See EntityComponents_UpdateTickLod.
+    EntityTick_Lod          = (1<<1),
 };
 
 struct TickableEntityItem
@@ -103,6 +130,7 @@ struct TickableEntityItem
     EntityGidOrderPair      orderGidPair;
     EntityFn_LogicTick*     Tick;       // native C++ invocation
     AjekReg_Closure         lua_tick;   // for invoking Lua tick callback
+    u32                     flags;      // EntityTickFlags
 };
 
 struct DrawableEntityItem
@@ -177,52 +205,161 @@ public:
 
 extern EntityGidOrderPair MakeGidOrder(const EntityGid_t gid, u32 order);
 
-typedef std::queue<EntityContainerEvent> EntityContainerEventQueue;
+typedef std::vector<EntityContainerEvent> EntityContainerEventQueue;
 
 using StringHashVal = u32;
 
-// Could also be defined with a 32-bit displacement from the base heap pointer, if entities
-// are given a custom heap.
-typedef std::unordered_map<EntityGid_t, EntityPointerContainerItem, FunctHashEntityItem>    EntityPointerContainer;
-typedef std::unordered_multimap<StringHashVal, EntityGid_t, FunctHashIdentity>              EntityNameAssociator;
+// --------------------------------------------------------------------------------------
+//  Entity Name Hashing
+// --------------------------------------------------------------------------------------
+// Names are hashed using CRC32C (Castagnoli, reflected, no pre/post inversion), which matches the
+// SSE4.2 crc32 instruction.  The runtime implementation uses the instruction; the constexpr version
+// below computes the same result bit-by-bit so that literal names can be hashed at compile time.
+//
+static const u32 Crc32c_Polynomial = 0x82F63B78;
+
+inline constexpr StringHashVal Crc32c_ConstExpr(const char* name, int length, u32 crc = 0)
+{
+    for (int i=0; i<length; ++i) {
+        crc ^= (u8)name[i];
+        for (int b=0; b<8; ++b) {
+            crc = (crc >> 1) ^ (Crc32c_Polynomial & (0u - (crc & 1)));
+        }
+    }
+    return crc;
+}
+
+// EntityNameKey - pre-hashed name used for name index lookups.
+//   Construct via EntityNameLiteral(), which only accepts string literals and forces the hash to be
+//   evaluated at compile time.  Other names go through the xString APIs, hashed at runtime.
+struct EntityNameKey
+{
+    const char*         name;
+    int                 length;
+    StringHashVal       hash;
+
+    constexpr EntityNameKey(const char* _name, int _length, StringHashVal _hash)
+        : name(_name), length(_length), hash(_hash) { }
+};
+
+// The "" prefix rejects anything other than a string literal (char buffers, pointers), since only
+// adjacent literals concatenate.
+#define EntityNameLiteral(literal)  \
+    EntityNameKey( ("" literal), int(sizeof("" literal)-1), \
+        std::integral_constant<StringHashVal, Crc32c_ConstExpr(("" literal), int(sizeof("" literal)-1))>::value )
+
+struct EntityNameIndexItem
+{
+    EntityGid_t         gid;
+    const char*         name;       // interned classname (owned by entity heap)
+    int                 length;
+};
+
+// --------------------------------------------------------------------------------------
+//  EntitySlotTable
+// --------------------------------------------------------------------------------------
+// Dense slot array indexed by EntityGid_t::Index().  Lookup is a bounds check, an array read, and
+// a full GID compare (which rejects stale handles).  Free slots have a null objectptr and carry the
+// GID that will be issued next for that slot.
+//
+// Released slots are recycled FIFO so that the generation counter of any single slot advances as
+// slowly as possible, which minimizes the odds of a very old stale GID aliasing a new entity.
+//
+struct EntitySlotTable
+{
+    std::vector<EntityPointerContainerItem>     m_slots;
+    std::deque<u32>                             m_freelist;
+    int                                         m_liveCount = 0;
+
+    EntityGid_t     Reserve     ();
+    void            ReserveBatch(int count, EntityGid_t* dest);
+    void            Release     (EntityGid_t gid);
+    void            Clear       ();
+
+    __ai int        GetLiveCount() const { return m_liveCount; }
+    __ai int        GetSlotCount() const { return (int)m_slots.size(); }
+
+    __ai const EntityPointerContainerItem* TryLookup(EntityGid_t gid) const {
+        auto idx = gid.Index();
+        if (idx >= m_slots.size()) return nullptr;
+        const auto& item = m_slots[idx];
+        if (item.gid != gid || !item.objectptr) return nullptr;
+        return &item;
+    }
+
+    __ai EntityPointerContainerItem* TryLookup(EntityGid_t gid) {
+        return const_cast<EntityPointerContainerItem*>(const_cast<const EntitySlotTable*>(this)->TryLookup(gid));
+    }
+
+    // Linear walk over the slot array, skipping free slots.
+    template< typename T >
+    void ForEachLive(T&& func) const {
+        for (const auto& item : m_slots) {
+            if (item.objectptr) {
+                func(item);
+            }
+        }
+    }
+};
+
+typedef EntitySlotTable                                                                     EntityPointerContainer;
+typedef std::unordered_multimap<StringHashVal, EntityNameIndexItem, FunctHashIdentity>      EntityNameAssociator;
+
 // --------------------------------------------------------------------------------------
 //  TickableEntityContainer
 // --------------------------------------------------------------------------------------
+// Entities are stored in a contiguous array sorted by {order,gid}, for linear prefetch-friendly
+// iteration.  All additions and removals are deferred into an event queue which is batch-merged into
+// the sorted array when iteration begins or when the outermost iterator is released.  This makes it
+// safe for entities to spawn or despawn other entities from within their own tick.
+//
+// A single entity may have multiple logic stages in a list (each must have a unique sort order).
+// Adding an item with a {order,gid} pair that already exists in the list is ignored.
+//
 struct TickableEntityContainer {
 
-    // HashedContainerType
-    //   Resolves entity GID into the full "sorted gid" which is used to create the set.
-    //   A single entity may have multiple draw or logic stages in a list (each must have
-    //   a unique sort order), and so a multiset is used.
+    typedef std::vector<TickableEntityItem>                                                         OrderedContainerType;
 
-    typedef std::unordered_multimap<EntityGid_t, EntityGidOrderPair, FunctHashEntityItem>           HashedContainerType;
-    typedef std::set<TickableEntityItem, CompareTickableEntity_Less>                                OrderedContainerType;
-
-    HashedContainerType         m_hashed;
     OrderedContainerType        m_ordered;          // ordered by priority
     EntityContainerEventQueue   m_evt_queue;
     int                         m_max_container_size;
-    int                         m_iterator_mode;
+    int                         m_iterator_mode     = 0;
+
+    xSpinLock                   m_evt_lock;         // protects m_evt_queue from parallel ticks
+
+    // scratch buffers used by ExecEventQueue, retained to avoid per-frame heap allocations.
+    OrderedContainerType                m_pending_adds;
+    std::vector<EntityGidOrderPair>     m_pending_removes;
 
     void        _Add            (const TickableEntityItem& entityInfo);
     void        Remove          (EntityGid_t entityGid, u32 order = (u32)-1);
     void        Clear           ();
     void        ExecEventQueue  ();
 
+    __ai void Add(EntityGid_t entityGid, u32 order, EntityFn_LogicTick* logic, u32 flags = EntityTick_Default) {
+        bug_on((flags & EntityTick_Parallel) && !logic, "Parallel ticks must have a native tick function.");
+        bug_on((flags & EntityTick_Lod)      && !logic, "LOD ticks must have a native tick function.");
+        _Add( { MakeGidOrder(entityGid, order), logic, {}, flags } );
+    }
 
-    __ai void Add(EntityGid_t entityGid, u32 order, EntityFn_LogicTick* logic) {
-        _Add( { MakeGidOrder(entityGid, order), logic } );
+    template< typename T >
+    __ai void Add(T* entity, int order, u32 flags = EntityTick_Default) {
+        Add(entity->m_gid, order, [](void* entity, int order, float dt) { ((T*)entity)->Tick(order, dt); }, flags );
     }
 
+    // Registers a tick which may run concurrently with other parallel ticks of the same order.
     template< typename T >
-    __ai void Add(T* entity, int order) {
-        Add(entity->m_gid, order, [](void* entity, int order, float dt) { ((T*)entity)->Tick(order, dt); } );
+    __ai void AddParallel(T* entity, int order) {
+        Add(entity, order, EntityTick_Parallel);
     }
 
     auto    ForEachForward      ();
     auto    ForEachReverse      ();
 
     void EnterIteratorMode() {
+        if (!m_iterator_mode) {
+            ExecEventQueue();
+        }
         m_iterator_mode += 1;
     }
 
@@ -244,6 +381,18 @@ struct TickableEntityContainer {
             m_entityList->EnterIteratorMode();
         }
 
+        ForeachIfcForward(ForeachIfcForward&& rvalue)
+        {
+            m_entityList        = rvalue.m_entityList;
+            rvalue.m_entityList = nullptr;
+        }
+
+        ForeachIfcForward& operator=(ForeachIfcForward&& rvalue)
+        {
+            std::swap(m_entityList, rvalue.m_entityList);
+            return *this;
+        }
+
         ~ForeachIfcForward() throw()
         {
             if (m_entityList) {
@@ -306,6 +455,16 @@ struct TickableEntityContainer {
 // removal is extremely slow.  Use drawing masking variables embedded into specific item data if
 // you encounter situations where it's useful to remove objects in a draw list.
 //
+// Storage is a linear per-frame arena: Add() appends, and Sort() orders the whole list once per
+// frame using an LSD radix sort on the z-order (made sortable by bit-flipping the float).  The sort
+// is stable, so items sharing a z-order keep insertion order in ForEachOpaque() and the reverse
+// of it in ForEachAlpha().  The arena retains its capacity across Clear().
+//
+// Culling: items may be added with a bounding box in tile coords (min.xy, max.xy packed into a
+// float4).  Once SetVisibleArea() has been called for the frame, bounded items which don't overlap
+// the visible area are rejected by Add() and never reach the arena.  Items added without bounds
+// are never culled.
+//
 struct OrderedDrawList {
     struct DrawListItem
     {
@@ -313,7 +472,20 @@ struct OrderedDrawList {
         EntityFn_Draw*      DrawFunc;
     };
 
-    typedef std::multimap<float, DrawListItem>  OrderedContainerType;
+    struct DrawListEntry
+    {
+        float               zorder;
+        DrawListItem        item;
+        float4              bounds;             // tile coords: xy = min, zw = max
+    };
+
+    struct DrawListStats
+    {
+        int                 submitted;
+        int                 culled;
+    };
+
+    typedef std::vector<DrawListEntry>  OrderedContainerType;
 
     // Intentionally lacks a hashed container.  Element removal is extremely slow for this reason.
     // If logic demands that an item in the draw list be removed after it has been added for some
@@ -321,21 +493,45 @@ struct OrderedDrawList {
     // it to skip drawing -- and then modify that.
 
     OrderedContainerType            m_ordered;
+    OrderedContainerType            m_sort_scratch;         // radix sort ping-pong buffer
+    bool                            m_sorted    = true;
+    bool                            m_cull      = false;    // set by SetVisibleArea(), cleared by Clear()
     float4                          m_visibleArea;          // visible area/frustrum - in tile coords - for culling
+    volatile s32                    m_numCulled = 0;
+    xSpinLock                       m_add_lock;             // allows Add() from parallel entity ticks
 
     void        _Add            (const DrawListItem& entity, float zorder);
+    void        _Add            (const DrawListItem& entity, float zorder, const float4& bounds);
     void        Add             (EntityGid_t entityGid, float zorder, EntityFn_Draw* draw);
     void        Remove          (EntityGid_t entityGid, float order);
     void        Remove          (EntityGid_t entityGid);
     void        Remove          (void* objectData, float order);
     void        Remove          (void* objectData);
     void        Clear           ();
+    void        Sort            ();
+    void        SetVisibleArea  (const float4& area);
+
+    __ai DrawListStats GetStats() const {
+        return { (int)m_ordered.size(), m_numCulled };
+    }
+
+    __ai bool IsVisible(const float4& bounds) const {
+        return !m_cull || (
+            bounds.z >= m_visibleArea.x && bounds.x <= m_visibleArea.z &&
+            bounds.w >= m_visibleArea.y && bounds.y <= m_visibleArea.w
+        );
+    }
 
     template< typename T >
     __ai void Add(const T* anyobj, float zorder, EntityFn_Draw* draw) {
         _Add( { anyobj, draw }, zorder );
     }
 
+    template< typename T >
+    __ai void Add(const T* anyobj, float zorder, EntityFn_Draw* draw, const float4& bounds) {
+        _Add( { anyobj, draw }, zorder, bounds );
+    }
+
     // Use to bind any object, either managed by entity system or static/dynamic object managed by C++
     // (ideally use only for entities or static items, to avoid accidental delete-before-frameout problem)
     template< typename T >
@@ -343,6 +539,11 @@ struct OrderedDrawList {
         Add( anyobj, zorder, [](const void* anyobj, float zorder) { ((T*)anyobj)->Draw(zorder); } );
     }
 
+    template< typename T >
+    __ai void Add(const T* anyobj, float zorder, const float4& bounds) {
+        Add( anyobj, zorder, [](const void* anyobj, float zorder) { ((T*)anyobj)->Draw(zorder); }, bounds );
+    }
+
     auto ForEachOpaque  () const;
     auto ForEachAlpha   () const;
 
@@ -351,6 +552,7 @@ struct OrderedDrawList {
         const OrderedDrawList*  m_drawList;
 
         ForeachIfcOpaque(const OrderedDrawList& src) {
+            bug_on(!src.m_sorted, "Draw list must be sorted before traversal.");
             m_drawList = &src;
         }
 
@@ -366,6 +568,7 @@ struct OrderedDrawList {
         const OrderedDrawList*  m_drawList;
 
         ForeachIfcAlpha(const OrderedDrawList& src) {
+            bug_on(!src.m_sorted, "Draw list must be sorted before traversal.");
             m_drawList = &src;
         }
 
@@ -402,12 +605,22 @@ inline EntityGidOrderPair MakeGidOrder(const EntityGid_t gid, u32 order)
     return EntityGidOrderPair().SetOrder(order).SetGid(gid);
 }
 
+extern TickableEntityContainer  g_tickable_entities;
+
 // --------------------------------------------------------
 // Internal-ish APIs for use by templates...
-extern const EntityPointerContainerItem*    _impl_entity_TryLookup  (const char* name, int length);
-extern const EntityPointerContainerItem&    _impl_entity_Lookup     (const char* name, int length);
+extern const EntityPointerContainerItem*    _impl_entity_TryLookup  (const EntityNameKey& key);
+extern const EntityPointerContainerItem&    _impl_entity_Lookup     (const EntityNameKey& key);
 // --------------------------------------------------------
 
+struct EntityGcStats
+{
+    int         queueDepth;             // removed entities still awaiting reclamation
+    int         freedLastFrame;
+    double      lastFrameUs;            // time spent in the most recent collection pass
+    s64         totalFreed;
+};
+
 // --------------------------------------------------------
 // Public APIs!
 
@@ -415,26 +628,46 @@ extern const EntityPointerContainerItem*    Entity_TryLookup            (EntityG
 extern const EntityPointerContainerItem*    Entity_TryLookup            (const xString& name);
 extern const EntityPointerContainerItem&    Entity_Lookup               (EntityGid_t gid);
 extern const EntityPointerContainerItem&    Entity_Lookup               (const xString& name);
+extern StringHashVal                        Entity_GetNameHash          (const char* name, int length);
 extern const char*                          Entity_LookupName           (EntityGid_t gid);
 extern void                                 Entity_Remove               (EntityGid_t gid);
 extern EntityGid_t                          Entity_AddManaged           (void* entity, const char* classname=nullptr);
 extern void                                 Entity_AddUnmanaged         (EntityGid_t& gid, void* entity, const char* classname);
+extern void                                 Entity_AddManagedBatch      (void* const* entities, int count, const char* classname, s32 prefab, EntityGid_t* destGids);
 extern void*                                Entity_Malloc               (int size);
 extern void                                 EntityManager_Reset         ();
 extern void                                 EntityManager_CollectGarbage();
+extern void                                 EntityManager_CollectGarbage(int completedFrame, int budgetUs);
+extern int                                  EntityManager_GetDeferredQueueDepth();
+extern const EntityGcStats&                 EntityManager_GetGcStats    ();
+extern const EntityPointerContainer&        EntityManager_GetEntities   ();
 
 // --------------------------------------------------------
 
-template< int _len >
-const EntityPointerContainerItem& Entity_Lookup(const char* (&name)[_len])
+template< typename T >
+void EntityManager_ForEachLive(T&& func)
+{
+    EntityManager_GetEntities().ForEachLive(func);
+}
+
+// Literal-name lookups: the name is hashed at compile time.
+#define Entity_LookupLiteral(literal)       Entity_Lookup   (EntityNameLiteral(literal))
+#define Entity_TryLookupLiteral(literal)    Entity_TryLookup(EntityNameLiteral(literal))
+
+// A parameter can't be forced into a constant expression, so an array overload could only hash at
+// runtime -- and would silently do so for every literal.  Literals are rejected here instead: use
+// the *Literal() macros above, or pass an xString for names built at runtime.
+template< int _len > const EntityPointerContainerItem&  Entity_Lookup   (const char (&name)[_len]) = delete;
+template< int _len > const EntityPointerContainerItem*  Entity_TryLookup(const char (&name)[_len]) = delete;
+
+inline const EntityPointerContainerItem& Entity_Lookup(const EntityNameKey& key)
 {
-    return _impl_entity_Lookup(name, _len);
+    return _impl_entity_Lookup(key);
 }
 
-template< int _len >
-const EntityPointerContainerItem* Entity_TryLookup(const char* (&name)[_len])
+inline const EntityPointerContainerItem* Entity_TryLookup(const EntityNameKey& key)
 {
-    return _impl_entity_TryLookup(name, _len);
+    return _impl_entity_TryLookup(key);
 }
 
 template< typename T >
@@ -455,11 +688,14 @@ T* Entity_LookupAs(const xString& name) {
     return (T*)Entity_Lookup(name).objectptr;
 }
 
-template<typename T, int _len>
-T* Entity_LookupAs(const char* (&name)[_len]) {
-    return (T*)Entity_Lookup(name).objectptr;
+template<typename T>
+T* Entity_LookupAs(const EntityNameKey& key) {
+    return (T*)Entity_Lookup(key).objectptr;
 }
 
+template<typename T, int _len>
+T* Entity_LookupAs(const char (&name)[_len]) = delete;
+
 
 #define NewStaticEntity(instance, ...)  Entity_AddUnmanaged(instance.m_gid, &instance, #instance __VA_ARGS__)
 #define NewEntity(type, ...)            NewEntityT<type>( #type ## __VA_ARGS__)
@@ -0,0 +1,384 @@
+#include "PCH-rpgcraft.h"
+
+#include "x-types.h"
+#include "x-stl.h"
+#include "x-assertion.h"
+#include "x-workers.h"
+
+#include "EntityComponents.h"
+#include "EntitySpatialHash.h"
+
+// Rows per worker chunk for bulk integration.  Must be a multiple of 4 so that only the final
+// chunk has a scalar tail.
+static const int        IntegrationGrainSize = 4096;
+
+EntityComponentStore    g_EntityComponents;
+static EntityTickLodStats   s_lod_stats;
+
+int EntityComponentStore::FindRow(EntityGid_t gid) const
+{
+    auto idx = gid.Index();
+    if (idx >= m_sparse.size()) return -1;
+    int row = m_sparse[idx] - 1;
+    if (row < 0 || m_gid[row] != gid) return -1;
+    return row;
+}
+
+int EntityComponentStore::Attach(EntityGid_t gid, u32 mask)
+{
+    if (mask & EntComp_Motion) {
+        mask |= EntComp_Position;
+    }
+
+    int row = FindRow(gid);
+    if (row >= 0) {
+        m_mask[row] |= mask;
+        return row;
+    }
+
+    auto idx = gid.Index();
+    if (idx >= m_sparse.size()) {
+        m_sparse.resize(idx + 1, 0);
+    }
+
+    // Rows lacking a component are initialized such that the bulk integration passes are no-ops
+    // for them (zero velocity, zero animation rate), which allows those loops to be branchless.
+    row = GetCount();
+    m_gid           .push_back(gid);
+    m_mask          .push_back(mask);
+    m_pos_x         .push_back(0);
+    m_pos_y         .push_back(0);
+    m_vel_x         .push_back(0);
+    m_vel_y         .push_back(0);
+    m_anim_timer    .push_back(0);
+    m_anim_period   .push_back(0);
+    m_anim_rate     .push_back(0);
+    m_anim_frame    .push_back(0);
+    m_anim_numFrames.push_back(1);
+    m_lod_tier      .push_back(0);
+    m_lod_due       .push_back(1);
+    m_lod_accum     .push_back(0);
+
+    m_sparse[idx] = row + 1;
+    return row;
+}
+
+template< typename T >
+static __ai void swapRemove(std::vector<T>& vec, int row)
+{
+    vec[row] = vec.back();
+    vec.pop_back();
+}
+
+void EntityComponentStore::Detach(EntityGid_t gid)
+{
+    int row = FindRow(gid);
+    if (row < 0) return;
+
+    int last = GetCount() - 1;
+    if (row != last) {
+        m_sparse[m_gid[last].Index()] = row + 1;
+    }
+    m_sparse[gid.Index()] = 0;
+
+    swapRemove(m_gid,           row);
+    swapRemove(m_mask,          row);
+    swapRemove(m_pos_x,         row);
+    swapRemove(m_pos_y,         row);
+    swapRemove(m_vel_x,         row);
+    swapRemove(m_vel_y,         row);
+    swapRemove(m_anim_timer,    row);
+    swapRemove(m_anim_period,   row);
+    swapRemove(m_anim_rate,     row);
+    swapRemove(m_anim_frame,    row);
+    swapRemove(m_anim_numFrames,row);
+    swapRemove(m_lod_tier,      row);
+    swapRemove(m_lod_due,       row);
+    swapRemove(m_lod_accum,     row);
+}
+
+void EntityComponentStore::Clear()
+{
+    m_sparse        .clear();
+    m_gid           .clear();
+    m_mask          .clear();
+    m_pos_x         .clear();
+    m_pos_y         .clear();
+    m_vel_x         .clear();
+    m_vel_y         .clear();
+    m_anim_timer    .clear();
+    m_anim_period   .clear();
+    m_anim_rate     .clear();
+    m_anim_frame    .clear();
+    m_anim_numFrames.clear();
+    m_lod_tier      .clear();
+    m_lod_due       .clear();
+    m_lod_accum     .clear();
+}
+
+int EntityComponents_Attach(EntityGid_t gid, u32 mask)
+{
+    bug_on(xWorkerPool_InParallelRegion(), "Components cannot be attached from parallel ticks.");
+    return g_EntityComponents.Attach(gid, mask);
+}
+
+void EntityComponents_Detach(EntityGid_t gid)
+{
+    g_EntityComponents.Detach(gid);
+    EntitySpatial_Remove(gid);
+}
+
+void EntityComponents_Reset()
+{
+    g_EntityComponents.Clear();
+    EntitySpatial_Reset();
+}
+
+bool EntityComponents_GetPosition(EntityGid_t gid, float2& dest)
+{
+    auto& store = g_EntityComponents;
+    int row = store.FindRow(gid);
+    if (row < 0) return false;
+    dest = { store.m_pos_x[row], store.m_pos_y[row] };
+    return true;
+}
+
+void EntityComponents_SetPosition(EntityGid_t gid, const float2& pos)
+{
+    auto& store = g_EntityComponents;
+    int row = store.FindRow(gid);
+    bug_on(row < 0, "Entity has no component row, gid=0x%08x", gid.val);
+    store.m_pos_x[row] = pos.x;
+    store.m_pos_y[row] = pos.y;
+}
+
+void EntityComponents_SetVelocity(EntityGid_t gid, const float2& vel)
+{
+    auto& store = g_EntityComponents;
+    int row = store.FindRow(gid);
+    bug_on(row < 0, "Entity has no component row, gid=0x%08x", gid.val);
+    bug_on(!(store.m_mask[row] & EntComp_Motion), "Entity does not have a Motion component, gid=0x%08x", gid.val);
+    store.m_vel_x[row] = vel.x;
+    store.m_vel_y[row] = vel.y;
+}
+
+void EntityComponents_SetAnimation(EntityGid_t gid, int numFrames, float period)
+{
+    auto& store = g_EntityComponents;
+    int row = store.FindRow(gid);
+    bug_on(row < 0, "Entity has no component row, gid=0x%08x", gid.val);
+    bug_on(!(store.m_mask[row] & EntComp_Animation), "Entity does not have an Animation component, gid=0x%08x", gid.val);
+    bug_on(numFrames < 1);
+    store.m_anim_numFrames[row] = numFrames;
+    store.m_anim_period   [row] = period;
+    store.m_anim_timer    [row] = period;
+    store.m_anim_frame    [row] = 0;
+    store.m_anim_rate     [row] = 1.0f;
+}
+
+void EntityComponents_SetAnimationRate(EntityGid_t gid, float rate)
+{
+    auto& store = g_EntityComponents;
+    int row = store.FindRow(gid);
+    bug_on(row < 0, "Entity has no component row, gid=0x%08x", gid.val);
+    bug_on(!(store.m_mask[row] & EntComp_Animation), "Entity does not have an Animation component, gid=0x%08x", gid.val);
+    store.m_anim_rate[row] = rate;
+}
+
+int EntityComponents_GetAnimFrame(EntityGid_t gid)
+{
+    auto& store = g_EntityComponents;
+    int row = store.FindRow(gid);
+    if (row < 0) return 0;
+    return store.m_anim_frame[row];
+}
+
+// --------------------------------------------------------------------------------------
+//  Bulk Integration
+// --------------------------------------------------------------------------------------
+
+static void integrateMotionRange(float dt, int begin, int end)
+{
+    auto& store = g_EntityComponents;
+    float* pos_x = store.m_pos_x.data();
+    float* pos_y = store.m_pos_y.data();
+    const float* vel_x = store.m_vel_x.data();
+    const float* vel_y = store.m_vel_y.data();
+
+    __m128 vdt = _mm_set1_ps(dt);
+
+    int row = begin;
+    for (; row+4 <= end; row += 4) {
+        __m128 px = _mm_loadu_ps(pos_x + row);
+        __m128 py = _mm_loadu_ps(pos_y + row);
+        px = _mm_add_ps(px, _mm_mul_ps(_mm_loadu_ps(vel_x + row), vdt));
+        py = _mm_add_ps(py, _mm_mul_ps(_mm_loadu_ps(vel_y + row), vdt));
+        _mm_storeu_ps(pos_x + row, px);
+        _mm_storeu_ps(pos_y + row, py);
+    }
+
+    for (; row < end; ++row) {
+        pos_x[row] += vel_x[row] * dt;
+        pos_y[row] += vel_y[row] * dt;
+    }
+}
+
+static void advanceAnimationRange(float dt, int begin, int end)
+{
+    auto& store = g_EntityComponents;
+    float*       timer      = store.m_anim_timer.data();
+    const float* period     = store.m_anim_period.data();
+    const float* rate       = store.m_anim_rate.data();
+    s32*         frame      = store.m_anim_frame.data();
+    const s32*   numFrames  = store.m_anim_numFrames.data();
+
+    __m128 vdt  = _mm_set1_ps(dt);
+    __m128 zero = _mm_setzero_ps();
+
+    int row = begin;
+    for (; row+4 <= end; row += 4) {
+        __m128  t       = _mm_loadu_ps(timer + row);
+        t               = _mm_sub_ps(t, _mm_mul_ps(vdt, _mm_loadu_ps(rate + row)));
+        __m128  expired = _mm_cmplt_ps(t, zero);
+        t               = _mm_add_ps(t, _mm_and_ps(expired, _mm_loadu_ps(period + row)));
+
+        // expired lanes are all-ones (-1), so subtracting the mask increments the frame.
+        __m128i f       = _mm_loadu_si128((const __m128i*)(frame + row));
+        f               = _mm_sub_epi32(f, _mm_castps_si128(expired));
+        __m128i inRange = _mm_cmplt_epi32(f, _mm_loadu_si128((const __m128i*)(numFrames + row)));
+        f               = _mm_and_si128(f, inRange);
+
+        _mm_storeu_ps(timer + row, t);
+        _mm_storeu_si128((__m128i*)(frame + row), f);
+    }
+
+    for (; row < end; ++row) {
+        timer[row] -= dt * rate[row];
+        if (timer[row] < 0) {
+            timer[row] += period[row];
+            if (++frame[row] >= numFrames[row]) {
+                frame[row] = 0;
+            }
+        }
+    }
+}
+
+void EntityComponents_IntegrateMotion(float dt)
+{
+    g_WorkerPool.ParallelFor(g_EntityComponents.GetCount(), IntegrationGrainSize, [dt](int begin, int end) {
+        integrateMotionRange(dt, begin, end);
+    });
+}
+
+void EntityComponents_AdvanceAnimation(float dt)
+{
+    g_WorkerPool.ParallelFor(g_EntityComponents.GetCount(), IntegrationGrainSize, [dt](int begin, int end) {
+        advanceAnimationRange(dt, begin, end);
+    });
+}
+
+// --------------------------------------------------------------------------------------
+//  Tick LOD
+// --------------------------------------------------------------------------------------
+
+// Tier is the number of ring boundaries (1x, 2x, 4x the view half-extents) that the row lies beyond,
+// measured as the larger of its per-axis distances from the view center.
+static void computeTickLodTiers(const float2& center, const float2& halfExtent, int begin, int end)
+{
+    auto& store = g_EntityComponents;
+    const float* pos_x  = store.m_pos_x.data();
+    const float* pos_y  = store.m_pos_y.data();
+    s32*         tier   = store.m_lod_tier.data();
+
+    float   inv_x   = 1.0f / std::max(halfExtent.x, 1.0f);
+    float   inv_y   = 1.0f / std::max(halfExtent.y, 1.0f);
+
+    __m128  vcx     = _mm_set1_ps(center.x);
+    __m128  vcy     = _mm_set1_ps(center.y);
+    __m128  vinvx   = _mm_set1_ps(inv_x);
+    __m128  vinvy   = _mm_set1_ps(inv_y);
+    __m128  absmask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128  ring1   = _mm_set1_ps(1.0f);
+    __m128  ring2   = _mm_set1_ps(2.0f);
+    __m128  ring4   = _mm_set1_ps(4.0f);
+
+    int row = begin;
+    for (; row+4 <= end; row += 4) {
+        __m128  dx  = _mm_mul_ps(_mm_and_ps(_mm_sub_ps(_mm_loadu_ps(pos_x + row), vcx), absmask), vinvx);
+        __m128  dy  = _mm_mul_ps(_mm_and_ps(_mm_sub_ps(_mm_loadu_ps(pos_y + row), vcy), absmask), vinvy);
+        __m128  d   = _mm_max_ps(dx, dy);
+
+        // each comparison yields -1 per lane when the ring is exceeded.
+        __m128i t   = _mm_castps_si128(_mm_cmpgt_ps(d, ring1));
+        t           = _mm_add_epi32(t, _mm_castps_si128(_mm_cmpgt_ps(d, ring2)));
+        t           = _mm_add_epi32(t, _mm_castps_si128(_mm_cmpgt_ps(d, ring4)));
+        _mm_storeu_si128((__m128i*)(tier + row), _mm_sub_epi32(_mm_setzero_si128(), t));
+    }
+
+    for (; row < end; ++row) {
+        float d   = std::max(fabsf(pos_x[row] - center.x) * inv_x, fabsf(pos_y[row] - center.y) * inv_y);
+        tier[row] = (d > 1.0f) + (d > 2.0f) + (d > 4.0f);
+    }
+}
+
+// Should be called once per frame prior to running entity ticks.  When disabled, every row is
+// placed in tier zero and ticks at full rate.
+void EntityComponents_UpdateTickLod(const float2& viewCenter, const float2& viewHalfExtent, int frame, float dt, bool enabled)
+{
+    auto& store = g_EntityComponents;
+    int   count = store.GetCount();
+
+    if (enabled) {
+        g_WorkerPool.ParallelFor(count, IntegrationGrainSize, [&](int begin, int end) {
+            computeTickLodTiers(viewCenter, viewHalfExtent, begin, end);
+        });
+    }
+    else {
+        std::fill(store.m_lod_tier.begin(), store.m_lod_tier.end(), 0);
+    }
+
+    s_lod_stats = {};
+    for (int row=0; row<count; ++row) {
+        int  tier   = store.m_lod_tier[row];
+        u32  period = 1u << tier;
+        bool hasPos = (store.m_mask[row] & EntComp_Position) != 0;
+
+        store.m_lod_accum[row] += dt;
+        store.m_lod_due  [row]  = !hasPos || ((u32(frame) + store.m_gid[row].Index()) & (period-1)) == 0;
+        s_lod_stats.tierCount[hasPos ? tier : 0] += 1;
+    }
+}
+
+// Returns true if the entity's LOD ticks should run this frame, and replaces dt with the delta time
+// accumulated since they last ran.  Entities without a component row always tick, with dt unmodified.
+bool EntityComponents_ResolveTickLod(EntityGid_t gid, float& dt)
+{
+    auto& store = g_EntityComponents;
+    int row = store.FindRow(gid);
+    if (row < 0) return true;
+
+    if (!store.m_lod_due[row]) {
+        s_lod_stats.ticksSkipped += 1;
+        return false;
+    }
+    dt = store.m_lod_accum[row];
+    return true;
+}
+
+// Should be called once per frame after all entity ticks have run.  Rows which ticked this frame
+// start accumulating from zero again.
+void EntityComponents_FinishTickLod()
+{
+    auto& store = g_EntityComponents;
+    int   count = store.GetCount();
+    for (int row=0; row<count; ++row) {
+        if (store.m_lod_due[row]) {
+            store.m_lod_accum[row] = 0;
+        }
+    }
+}
+
+const EntityTickLodStats& EntityComponents_GetTickLodStats()
+{
+    return s_lod_stats;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "x-types.h"
+#include "Entity.h"
+
+#include <vector>
+
+// --------------------------------------------------------------------------------------
+//  EntityComponentStore
+// --------------------------------------------------------------------------------------
+// Opt-in structure-of-arrays storage for hot per-entity state (position, velocity, animation
+// timers).  Each attached entity owns one row in a set of dense parallel arrays; a sparse table
+// indexed by EntityGid_t::Index() maps entities to rows.  Detaching swaps the last row into the
+// vacated one, so the arrays never have holes and bulk loops need no skip logic.
+//
+// Row indices are not stable across Detach() and must not be held across frames -- use the GID.
+//
+// Bulk integration (IntegrateMotion/AdvanceAnimation) operates four rows at a time using SSE,
+// and is split across the worker pool when the row count is large.  The passes are branchless and
+// visit every row: rows lacking a component are initialized so that its pass is a no-op for them
+// (zero velocity, zero animation rate).  The per-row component mask is only consulted by ForEach()
+// and by the per-entity accessors.
+//
+// Tick LOD state is also kept per row: UpdateTickLod() assigns every positioned row a tier from its
+// distance to the view, decides whether the row is due to tick this frame, and accumulates delta
+// time for rows which aren't.  Tiers are rings measured in multiples of the view's half-extents,
+// and a row in tier N ticks every 2^N frames, staggered by gid so that a ring's ticks are spread
+// evenly across frames.
+//
+
+enum EntityComponentFlags : u32
+{
+    EntComp_Position        = (1<<0),
+    EntComp_Motion          = (1<<1),       // velocity integrated into position each frame (implies Position)
+    EntComp_Animation       = (1<<2),       // frame timer advanced each frame
+};
+
+struct EntityComponentStore
+{
+    // sparse: gid index -> dense row+1 (zero means no row)
+    std::vector<s32>            m_sparse;
+
+    // dense rows
+    std::vector<EntityGid_t>    m_gid;
+    std::vector<u32>            m_mask;
+    std::vector<float>          m_pos_x;
+    std::vector<float>          m_pos_y;
+    std::vector<float>          m_vel_x;
+    std::vector<float>          m_vel_y;
+    std::vector<float>          m_anim_timer;       // seconds until next frame
+    std::vector<float>          m_anim_period;      // seconds per frame
+    std::vector<float>          m_anim_rate;        // timer multiplier, 0 pauses animation
+    std::vector<s32>            m_anim_frame;
+    std::vector<s32>            m_anim_numFrames;
+    std::vector<s32>            m_lod_tier;
+    std::vector<u8>             m_lod_due;          // nonzero if the row's LOD ticks run this frame
+    std::vector<float>          m_lod_accum;        // delta time accumulated since the row's LOD ticks last ran
+
+    __ai int    GetCount    () const { return (int)m_gid.size(); }
+
+    int         Attach      (EntityGid_t gid, u32 mask);
+    void        Detach      (EntityGid_t gid);
+    void        Clear       ();
+    int         FindRow     (EntityGid_t gid) const;
+
+    // Visits every row which has all of the requested components.  func(int row)
+    template< typename T >
+    void ForEach(u32 mask, T&& func) const {
+        int count = GetCount();
+        for (int row=0; row<count; ++row) {
+            if ((m_mask[row] & mask) == mask) {
+                func(row);
+            }
+        }
+    }
+};
+
+static const int NumTickLodTiers = 4;
+
+struct EntityTickLodStats
+{
+    int         tierCount[NumTickLodTiers];     // positioned rows in each tier
+    int         ticksSkipped;                   // LOD ticks deferred this frame
+};
+
+extern EntityComponentStore     g_EntityComponents;
+
+extern int      EntityComponents_Attach             (EntityGid_t gid, u32 mask);
+extern void     EntityComponents_Detach             (EntityGid_t gid);
+extern void     EntityComponents_Reset              ();
+
+extern bool     EntityComponents_GetPosition        (EntityGid_t gid, float2& dest);
+extern void     EntityComponents_SetPosition        (EntityGid_t gid, const float2& pos);
+extern void     EntityComponents_SetVelocity        (EntityGid_t gid, const float2& vel);
+extern void     EntityComponents_SetAnimation       (EntityGid_t gid, int numFrames, float period);
+extern void     EntityComponents_SetAnimationRate   (EntityGid_t gid, float rate);
+extern int      EntityComponents_GetAnimFrame       (EntityGid_t gid);
+
+extern void     EntityComponents_IntegrateMotion    (float dt);
+extern void     EntityComponents_AdvanceAnimation   (float dt);
+
+extern void     EntityComponents_UpdateTickLod      (const float2& viewCenter, const float2& viewHalfExtent, int frame, float dt, bool enabled);
+extern bool     EntityComponents_ResolveTickLod     (EntityGid_t gid, float& dt);
+extern void     EntityComponents_FinishTickLod      ();
+extern const EntityTickLodStats& EntityComponents_GetTickLodStats();
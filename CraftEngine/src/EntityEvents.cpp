@@ -0,0 +1,53 @@
+#include "PCH-rpgcraft.h"
+
+#include "x-types.h"
+#include "x-stl.h"
+#include "x-assertion.h"
+
+#include "EntityEvents.h"
+
+// Channels register themselves on construction, and may be global objects in any translation unit,
+// so the list is a function-local static to sidestep static initialization order.
+static std::vector<EntityEventChannelBase*>& getChannels()
+{
+    static std::vector<EntityEventChannelBase*> s_channels;
+    return s_channels;
+}
+
+static int s_lastDispatchedTotal = 0;
+
+EntityEventChannel<EntityEvent_Damage>      g_evt_damage    ("Damage");
+EntityEventChannel<EntityEvent_Pickup>      g_evt_pickup    ("Pickup");
+EntityEventChannel<EntityEvent_Interact>    g_evt_interact  ("Interact");
+
+EntityEventChannelBase::EntityEventChannelBase(const char* name)
+{
+    m_name = name;
+    getChannels().push_back(this);
+}
+
+// Drains every channel in registration order.  Must be called from the scene thread, outside
+// of any parallel region.
+void EntityEvents_DispatchAll()
+{
+    bug_on(xWorkerPool_InParallelRegion(), "Entity events cannot be dispatched from parallel ticks.");
+
+    s_lastDispatchedTotal = 0;
+    for (auto* channel : getChannels()) {
+        channel->Dispatch();
+        s_lastDispatchedTotal += channel->m_lastDispatched;
+    }
+}
+
+void EntityEvents_Reset()
+{
+    for (auto* channel : getChannels()) {
+        channel->Discard();
+    }
+    s_lastDispatchedTotal = 0;
+}
+
+int EntityEvents_GetDispatchedCount()
+{
+    return s_lastDispatchedTotal;
+}
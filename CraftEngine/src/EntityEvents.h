@@ -0,0 +1,166 @@
+#pragma once
+
+#include "x-types.h"
+#include "x-workers.h"
+#include "Entity.h"
+
+#include <vector>
+#include <algorithm>
+
+// --------------------------------------------------------------------------------------
+//  EntityEventChannel
+// --------------------------------------------------------------------------------------
+// Typed, per-frame message channels between entities.  Rather than reaching into another entity via
+// Entity_LookupAs<T>() mid-tick, producers Post() an event to a channel, and each channel is drained
+// once per frame by EntityEvents_DispatchAll(), which runs after all entity ticks.  Draining sorts
+// a channel's events by target and hands the handler each target's events as one contiguous run.
+//
+// Post() is safe from parallel ticks: a slot in the channel's write buffer is claimed with a single
+// atomic add.  Posts which overrun the buffer fall back onto a spin-locked overflow list, and the
+// buffer is grown at drain time to fit that frame's total, so steady-state posting never locks.
+//
+// Events posted by handlers during dispatch are buffered for the next frame.  Events targeting
+// entities which no longer exist (or have been removed) are discarded without reaching the handler.
+// Events with the same target are delivered in the order they were posted, though posts from
+// concurrent parallel ticks have no defined order relative to each other.
+//
+
+template< typename T >
+struct EntityEventRecord
+{
+    EntityGid_t     target;
+    EntityGid_t     source;
+    T               data;
+};
+
+class EntityEventChannelBase
+{
+    NONCOPYABLE_OBJECT( EntityEventChannelBase );
+
+public:
+    const char*     m_name;
+    int             m_lastDispatched    = 0;    // events delivered by the most recent dispatch
+    int             m_lastOverflowed    = 0;    // events which took the locked overflow path
+
+public:
+    EntityEventChannelBase(const char* name);
+
+    virtual void    Dispatch    () = 0;
+    virtual void    Discard     () = 0;
+};
+
+template< typename T >
+class EntityEventChannel : public EntityEventChannelBase
+{
+public:
+    typedef EntityEventRecord<T>    Record;
+
+    // Receives all events for one target.  target is the entity's slot table record, and events
+    // points to count records in post order.
+    typedef void (HandlerFn)(const EntityPointerContainerItem& target, const Record* events, int count);
+
+protected:
+    static const int        InitialCapacity = 256;
+
+    std::vector<Record>     m_write;
+    std::vector<Record>     m_overflow;
+    std::vector<Record>     m_process;
+    volatile s32            m_count         = 0;
+    xSpinLock               m_overflow_lock;
+    HandlerFn*              m_handler       = nullptr;
+
+public:
+    EntityEventChannel(const char* name) : EntityEventChannelBase(name) {
+        m_write.resize(InitialCapacity);
+    }
+
+    void SetHandler(HandlerFn* handler) {
+        m_handler = handler;
+    }
+
+    void Post(EntityGid_t target, EntityGid_t source, const T& data) {
+        s32 slot = AtomicExchangeAdd(m_count, 1);
+        if (slot < (s32)m_write.size()) {
+            m_write[slot] = { target, source, data };
+            return;
+        }
+
+        xScopedSpinLock lock(m_overflow_lock);
+        m_overflow.push_back({ target, source, data });
+    }
+
+    void Dispatch() override {
+        int numPosted = std::min((int)m_count, (int)m_write.size());
+        m_lastOverflowed = (int)m_overflow.size();
+
+        // Swap the write buffer out before invoking any handlers, so that their posts land in a
+        // fresh buffer for the next frame.
+        std::swap(m_write, m_process);
+        m_process.resize(numPosted);
+        m_process.insert(m_process.end(), m_overflow.begin(), m_overflow.end());
+        m_overflow.clear();
+
+        int total    = (int)m_process.size();
+        int capacity = std::max((int)m_process.capacity(), InitialCapacity);
+        while (capacity < total) capacity *= 2;
+        m_write.resize(capacity);
+        m_count = 0;
+
+        std::stable_sort(m_process.begin(), m_process.end(), [](const Record& lval, const Record& rval) {
+            return lval.target.val < rval.target.val;
+        });
+
+        m_lastDispatched = 0;
+        auto it     = m_process.begin();
+        auto itEnd  = m_process.end();
+        while (it != itEnd) {
+            auto runEnd = it;
+            while (runEnd != itEnd && runEnd->target == it->target) ++runEnd;
+
+            auto* target = Entity_TryLookup(it->target);
+            if (m_handler && target && !target->deleted) {
+                m_handler(*target, &*it, int(runEnd - it));
+                m_lastDispatched += int(runEnd - it);
+            }
+            it = runEnd;
+        }
+        m_process.clear();
+    }
+
+    void Discard() override {
+        m_overflow.clear();
+        m_process.clear();
+        m_count          = 0;
+        m_lastDispatched = 0;
+        m_lastOverflowed = 0;
+    }
+};
+
+// --------------------------------------------------------------------------------------
+//  Standard Channels
+// --------------------------------------------------------------------------------------
+
+struct EntityEvent_Damage
+{
+    float       amount;
+    u32         kind;
+};
+
+struct EntityEvent_Pickup
+{
+    s32         itemId;
+    s32         count;
+};
+
+struct EntityEvent_Interact
+{
+    s32         verb;
+};
+
+extern EntityEventChannel<EntityEvent_Damage>       g_evt_damage;
+extern EntityEventChannel<EntityEvent_Pickup>       g_evt_pickup;
+extern EntityEventChannel<EntityEvent_Interact>     g_evt_interact;
+
+extern void     EntityEvents_DispatchAll        ();
+extern void     EntityEvents_Reset              ();
+extern int      EntityEvents_GetDispatchedCount ();
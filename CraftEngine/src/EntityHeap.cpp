@@ -0,0 +1,229 @@
+#include "PCH-rpgcraft.h"
+
+#include "x-types.h"
+#include "x-stl.h"
+#include "x-assertion.h"
+#include "x-stdlib.h"
+
+#include "EntityHeap.h"
+
+#include <vector>
+#include <unordered_map>
+
+static const int    HeapBlockSize       = _1mb;
+static const int    NumSizeClasses      = 8;        // 16 bytes -> 2kb
+static const int    MinSizeClassShift   = 4;
+static const u32    SizeClassLarge      = 0xff;
+static const u32    AllocHeaderMagic    = 0xe4717a11;
+
+// Header precedes every allocation, and is sized to preserve 16 byte alignment of the payload.
+struct EntityAllocHeader
+{
+    u32     sizeClass;
+    u32     magic;
+    u32     allocSize;              // payload size, including class rounding
+    u32     _reserved;
+};
+
+static_assert(sizeof(EntityAllocHeader) == 16, "EntityAllocHeader must preserve payload alignment.");
+
+struct EntityFreeNode
+{
+    EntityFreeNode*     next;
+};
+
+typedef std::unordered_multimap<u32, const char*>   InternedNameContainer;
+
+static std::vector<u8*>         s_blocks;                   // fixed-size blocks, retained across resets
+static std::vector<u8*>         s_oversize;                 // single-allocation blocks larger than HeapBlockSize
+static int                      s_curBlock      = -1;
+static u8*                      s_bumpPos       = nullptr;
+static u8*                      s_bumpEnd       = nullptr;
+static EntityFreeNode*          s_freelist[NumSizeClasses];
+static std::vector<EntityAllocHeader*>  s_freeLarge;        // freed large allocations, reused best-fit
+static InternedNameContainer    s_internedNames;
+static s64                      s_bytesInUse    = 0;
+static int                      s_numAllocs     = 0;
+
+static __ai size_t alignSize16(size_t size)
+{
+    return (size + 15) & ~size_t(15);
+}
+
+static __ai u32 getSizeClass(size_t size)
+{
+    for (u32 i=0; i<NumSizeClasses; ++i) {
+        if (size <= (size_t(1) << (i + MinSizeClassShift))) {
+            return i;
+        }
+    }
+    return SizeClassLarge;
+}
+
+// Finds the smallest freed large allocation that can hold allocSize, skipping any more than twice
+// the requested size so that a small request doesn't pin a much larger block.
+static EntityAllocHeader* takeFreeLarge(size_t allocSize)
+{
+    int best = -1;
+    for (int i=0; i<(int)s_freeLarge.size(); ++i) {
+        auto capacity = (size_t)s_freeLarge[i]->allocSize;
+        if (capacity < allocSize || capacity > allocSize * 2) continue;
+        if (best < 0 || capacity < s_freeLarge[best]->allocSize) {
+            best = i;
+        }
+    }
+    if (best < 0) return nullptr;
+
+    auto* result = s_freeLarge[best];
+    s_freeLarge[best] = s_freeLarge.back();
+    s_freeLarge.pop_back();
+    return result;
+}
+
+static u8* bumpAlloc(size_t size)
+{
+    size = alignSize16(size);
+
+    if (size > HeapBlockSize) {
+        auto* result = (u8*)xMalloc(size);
+        s_oversize.push_back(result);
+        return result;
+    }
+
+    if (!s_bumpPos || (s_bumpPos + size > s_bumpEnd)) {
+        s_curBlock += 1;
+        if (s_curBlock >= (int)s_blocks.size()) {
+            s_blocks.push_back((u8*)xMalloc(HeapBlockSize));
+        }
+        s_bumpPos = s_blocks[s_curBlock];
+        s_bumpEnd = s_bumpPos + HeapBlockSize;
+    }
+
+    auto* result = s_bumpPos;
+    s_bumpPos   += size;
+    return result;
+}
+
+void* EntityHeap_Alloc(size_t size)
+{
+    auto sizeClass = getSizeClass(size);
+    auto allocSize = (sizeClass == SizeClassLarge) ? alignSize16(size) : (size_t(1) << (sizeClass + MinSizeClassShift));
+
+    EntityAllocHeader* header;
+    if (sizeClass != SizeClassLarge && s_freelist[sizeClass]) {
+        auto* node = s_freelist[sizeClass];
+        s_freelist[sizeClass] = node->next;
+        header = ((EntityAllocHeader*)node) - 1;
+        bug_on(header->magic != AllocHeaderMagic);
+    }
+    elif (sizeClass == SizeClassLarge && (header = takeFreeLarge(allocSize))) {
+        // a recycled block keeps its full capacity, which may exceed this request.
+        allocSize = header->allocSize;
+    }
+    else {
+        header = (EntityAllocHeader*)bumpAlloc(sizeof(EntityAllocHeader) + allocSize);
+    }
+
+    header->sizeClass   = sizeClass;
+    header->magic       = AllocHeaderMagic;
+    header->allocSize   = (u32)allocSize;
+    header->_reserved   = 0;
+
+    s_bytesInUse += allocSize + sizeof(EntityAllocHeader);
+    s_numAllocs  += 1;
+    return header + 1;
+}
+
+void EntityHeap_Free(void* ptr)
+{
+    if (!ptr) return;
+
+    auto* header = ((EntityAllocHeader*)ptr) - 1;
+    bug_on(header->magic != AllocHeaderMagic, "EntityHeap_Free: pointer was not allocated from the entity heap (or was double-freed).");
+
+    s_bytesInUse -= header->allocSize + sizeof(EntityAllocHeader);
+    s_numAllocs  -= 1;
+
+    if (header->sizeClass == SizeClassLarge) {
+        // allocSize is retained as the capacity of the block for reuse.
+        header->magic = 0;
+        s_freeLarge.push_back(header);
+        return;
+    }
+
+    auto* node = (EntityFreeNode*)ptr;
+    node->next = s_freelist[header->sizeClass];
+    s_freelist[header->sizeClass] = node;
+}
+
+static u32 _getNameHash(const char* name, size_t length)
+{
+    // FNV-1a, good enough for a small table of classnames.
+    u32 result = 2166136261u;
+    for (size_t i=0; i<length; ++i) {
+        result = (result ^ (u8)name[i]) * 16777619u;
+    }
+    return result;
+}
+
+const char* EntityHeap_InternName(const char* name)
+{
+    if (!name || !name[0]) return nullptr;
+
+    auto length = strlen(name);
+    auto hash   = _getNameHash(name, length);
+
+    auto range = s_internedNames.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (strcmp(it->second, name) == 0) {
+            return it->second;
+        }
+    }
+
+    auto* result = (char*)bumpAlloc(length + 1);
+    xMemCopy(result, name, (uint)length + 1);
+    s_internedNames.insert({ hash, result });
+    return result;
+}
+
+// Rewinds the heap to empty.  All entity pointers and interned names become invalid.
+void EntityHeap_Reset()
+{
+    for (auto* block : s_oversize) {
+        xFree(block);
+    }
+    s_oversize.clear();
+    s_freeLarge.clear();
+    s_internedNames.clear();
+
+    for (auto& node : s_freelist) {
+        node = nullptr;
+    }
+
+    s_curBlock      = -1;
+    s_bumpPos       = nullptr;
+    s_bumpEnd       = nullptr;
+    s_bytesInUse    = 0;
+    s_numAllocs     = 0;
+}
+
+// Resets the heap and returns all retained blocks to the system heap.
+void EntityHeap_Purge()
+{
+    EntityHeap_Reset();
+    for (auto* block : s_blocks) {
+        xFree(block);
+    }
+    s_blocks.clear();
+}
+
+EntityHeapStats EntityHeap_GetStats()
+{
+    EntityHeapStats result;
+    result.bytesReserved    = s64(s_blocks.size()) * HeapBlockSize;
+    result.bytesInUse       = s_bytesInUse;
+    result.numBlocks        = (int)s_blocks.size();
+    result.numAllocs        = s_numAllocs;
+    result.numInternedNames = (int)s_internedNames.size();
+    return result;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "x-types.h"
+
+// --------------------------------------------------------------------------------------
+//  EntityHeap
+// --------------------------------------------------------------------------------------
+// Arena for managed entity storage.  Memory is carved from large blocks using a bump pointer,
+// and freed allocations are recycled through per-size-class free lists (16 bytes through 2kb).
+// Allocations larger than the biggest size class are bump-allocated and recycled best-fit through
+// a separate free list, accepting blocks up to twice the requested size.  That list is searched
+// linearly -- entities of that size are expected to be rare.
+//
+// Resetting the heap rewinds all blocks and discards all free lists in O(blocks) time, without
+// visiting individual entities.  Blocks are retained across resets so that a scene reload reuses
+// the same memory rather than thrashing the system heap.
+//
+// Classnames are interned into the same arena: each unique name is stored exactly once and the
+// resulting pointer is stable until the next reset.
+//
+// Thread Safety:
+//   Not thread safe.  Entity spawning and garbage collection occur on the scene thread only.
+//
+
+struct EntityHeapStats
+{
+    s64     bytesReserved;          // total size of all blocks owned by the heap
+    s64     bytesInUse;             // bytes handed out and not yet freed (includes headers and class rounding)
+    int     numBlocks;
+    int     numAllocs;              // live allocation count
+    int     numInternedNames;
+};
+
+extern void*            EntityHeap_Alloc            (size_t size);
+extern void             EntityHeap_Free             (void* ptr);
+extern const char*      EntityHeap_InternName       (const char* name);
+extern void             EntityHeap_Reset            ();
+extern void             EntityHeap_Purge            ();
+extern EntityHeapStats  EntityHeap_GetStats         ();
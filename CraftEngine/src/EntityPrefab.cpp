@@ -0,0 +1,157 @@
+#include "PCH-rpgcraft.h"
+
+#include "x-types.h"
+#include "x-stl.h"
+#include "x-assertion.h"
+#include "x-string.h"
+#include "x-workers.h"
+
+#include "EntityPrefab.h"
+#include "EntityHeap.h"
+
+#include <vector>
+
+// Minimum number of instances carved from the entity heap whenever a pool runs dry.  Larger
+// batch spawns carve exactly the shortfall in a single allocation.
+static const int    PoolChunkInstances  = 32;
+
+struct EntityPrefab
+{
+    xString                 classname;
+    void*                   prototype;      // system heap -- survives entity heap resets
+    int                     size;
+    int                     stride;         // instance size rounded up to preserve 16 byte alignment
+    u32                     flags;
+    EntityFn_PrefabClone*   clone;
+    std::vector<void*>      recycled;
+    EntityPrefabStats       stats;
+};
+
+static std::vector<EntityPrefab>    s_prefabs;
+
+// scratch buffers for EntityPrefab_Spawn, retained to avoid per-spawn heap allocations.
+static std::vector<void*>           s_spawn_objects;
+static std::vector<EntityGid_t>     s_spawn_gids;
+
+static EntityPrefab& getPrefab(EntityPrefabId id)
+{
+    bug_on(id <= 0 || id > (int)s_prefabs.size(), "Invalid prefab id = %d", id);
+    return s_prefabs[id-1];
+}
+
+EntityPrefabId EntityPrefab_Register(const char* classname, const void* prototype, int size, EntityFn_PrefabClone* clone, u32 flags)
+{
+    bug_on(!prototype || !clone || size <= 0);
+
+    s_prefabs.emplace_back();
+    auto& prefab = s_prefabs.back();
+
+    prefab.classname    = classname;
+    prefab.size         = size;
+    prefab.stride       = (size + 15) & ~15;
+    prefab.flags        = flags;
+    prefab.clone        = clone;
+    prefab.stats        = {};
+    prefab.prototype    = xMalloc(prefab.stride);
+    clone(prefab.prototype, prototype, { ESGID_Empty });
+
+    return (EntityPrefabId)s_prefabs.size();
+}
+
+static void carvePool(EntityPrefab& prefab, int count)
+{
+    auto* chunk = (u8*)EntityHeap_Alloc(size_t(prefab.stride) * count);
+    prefab.recycled.reserve(prefab.recycled.size() + count);
+
+    // pushed in reverse so that pops hand out ascending addresses.
+    for (int i=count-1; i>=0; --i) {
+        prefab.recycled.push_back(chunk + size_t(prefab.stride) * i);
+    }
+}
+
+// Fills the prefab's recycle list so that the next count spawns allocate nothing.  Useful ahead of
+// projectile- or enemy-heavy encounters.  Has no effect on non-pooled prefabs.
+void EntityPrefab_Prewarm(EntityPrefabId id, int count)
+{
+    auto& prefab = getPrefab(id);
+    if (!(prefab.flags & EntityPrefab_Pooled)) return;
+
+    int shortfall = count - (int)prefab.recycled.size();
+    if (shortfall > 0) {
+        carvePool(prefab, shortfall);
+    }
+}
+
+void EntityPrefab_Spawn(EntityPrefabId id, int count, EntityGid_t* destGids, void** destObjects)
+{
+    bug_on(xWorkerPool_InParallelRegion(), "Entities cannot be spawned from parallel ticks.");
+    if (count <= 0) return;
+
+    auto& prefab = getPrefab(id);
+
+    if (!destObjects) {
+        s_spawn_objects.resize(count);
+        destObjects = s_spawn_objects.data();
+    }
+    if (!destGids) {
+        s_spawn_gids.resize(count);
+        destGids = s_spawn_gids.data();
+    }
+
+    if (prefab.flags & EntityPrefab_Pooled) {
+        int shortfall = count - (int)prefab.recycled.size();
+        if (shortfall > 0) {
+            carvePool(prefab, std::max(shortfall, PoolChunkInstances));
+        }
+        auto first = prefab.recycled.end() - count;
+        std::reverse_copy(first, prefab.recycled.end(), destObjects);
+        prefab.recycled.erase(first, prefab.recycled.end());
+    }
+    else {
+        for (int i=0; i<count; ++i) {
+            destObjects[i] = EntityHeap_Alloc(prefab.size);
+        }
+    }
+
+    Entity_AddManagedBatch(destObjects, count, prefab.classname.c_str(), id, destGids);
+
+    for (int i=0; i<count; ++i) {
+        prefab.clone(destObjects[i], prefab.prototype, destGids[i]);
+    }
+
+    prefab.stats.numLive        += count;
+    prefab.stats.totalSpawned   += count;
+}
+
+// Invoked by the entity manager when an instance spawned from this prefab is collected.
+// Returns false if the prefab isn't pooled, in which case the caller frees the object normally.
+bool EntityPrefab_Recycle(EntityPrefabId id, void* object)
+{
+    auto& prefab = getPrefab(id);
+    prefab.stats.numLive -= 1;
+
+    if (!(prefab.flags & EntityPrefab_Pooled)) return false;
+    prefab.recycled.push_back(object);
+    return true;
+}
+
+// Pool storage lives on the entity heap, so it must be discarded whenever the heap is reset.
+void EntityPrefab_ResetPools()
+{
+    for (auto& prefab : s_prefabs) {
+        prefab.recycled.clear();
+        prefab.stats.numLive = 0;
+    }
+}
+
+int EntityPrefab_GetSize(EntityPrefabId id)
+{
+    return getPrefab(id).size;
+}
+
+const EntityPrefabStats& EntityPrefab_GetStats(EntityPrefabId id)
+{
+    auto& prefab = getPrefab(id);
+    prefab.stats.numRecycled = (int)prefab.recycled.size();
+    return prefab.stats;
+}
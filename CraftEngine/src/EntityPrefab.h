@@ -0,0 +1,71 @@
+#pragma once
+
+#include "x-types.h"
+#include "Entity.h"
+
+#include <new>
+
+// --------------------------------------------------------------------------------------
+//  EntityPrefab
+// --------------------------------------------------------------------------------------
+// A prefab is a registered, pre-initialized prototype instance of a managed entity type.  Spawning
+// from a prefab clones the prototype into N fresh instances in one call: storage for the whole
+// batch is obtained up front, and the entity slot table and name index are each grown at most once
+// (see Entity_AddManagedBatch), rather than paying the full NewEntity() cost per instance.
+//
+// Pooled prefabs keep a recycle list of instance storage.  When a pooled instance is collected
+// after Entity_Remove(), its storage returns to the prefab's recycle list rather than to the
+// entity heap, and new pool storage is carved from the entity heap in chunks.  Pools are emptied
+// by EntityManager_Reset(), along with the rest of the entity heap.  Prefab registrations (and
+// their prototypes) persist across resets.
+//
+// As with NewEntity(), instances are never destructed: recycled storage is overwritten by a fresh
+// copy of the prototype on the next spawn.
+//
+// Thread Safety:
+//   Not thread safe.  Spawning occurs on the scene thread only, and never from parallel ticks.
+//
+
+typedef s32     EntityPrefabId;             // zero is never a valid prefab
+
+enum EntityPrefabFlags : u32
+{
+    EntityPrefab_Default    = 0,
+    EntityPrefab_Pooled     = (1<<0),       // recycle instance storage on despawn
+};
+
+// Copy-constructs the prototype into dest, and assigns the new instance its gid.
+typedef void (EntityFn_PrefabClone) (void* dest, const void* prototype, EntityGid_t gid);
+
+struct EntityPrefabStats
+{
+    int         numLive;                    // instances spawned and not yet collected
+    int         numRecycled;                // instance storage waiting in the recycle list
+    s64         totalSpawned;
+};
+
+extern EntityPrefabId               EntityPrefab_Register       (const char* classname, const void* prototype, int size, EntityFn_PrefabClone* clone, u32 flags);
+extern void                         EntityPrefab_Spawn          (EntityPrefabId id, int count, EntityGid_t* destGids = nullptr, void** destObjects = nullptr);
+extern void                         EntityPrefab_Prewarm        (EntityPrefabId id, int count);
+extern bool                         EntityPrefab_Recycle        (EntityPrefabId id, void* object);
+extern void                         EntityPrefab_ResetPools     ();
+extern int                          EntityPrefab_GetSize        (EntityPrefabId id);
+extern const EntityPrefabStats&     EntityPrefab_GetStats       (EntityPrefabId id);
+
+template< typename T >
+EntityPrefabId EntityPrefab_Register(const char* classname, const T& prototype, u32 flags = EntityPrefab_Pooled)
+{
+    return EntityPrefab_Register(classname, &prototype, sizeof(T), [](void* dest, const void* prototype, EntityGid_t gid) {
+        auto* entity = new (dest) T(*(const T*)prototype);
+        entity->m_gid = gid;
+    }, flags);
+}
+
+// Spawns count instances of the prefab.  destObjects, if provided, receives pointers to the new
+// instances in the same order as their gids.
+template< typename T >
+void EntityPrefab_SpawnAs(EntityPrefabId id, int count, T** destObjects, EntityGid_t* destGids = nullptr)
+{
+    bug_on(EntityPrefab_GetSize(id) != sizeof(T), "Prefab type mismatch.");
+    EntityPrefab_Spawn(id, count, destGids, (void**)destObjects);
+}
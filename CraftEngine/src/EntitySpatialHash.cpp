@@ -0,0 +1,232 @@
+#include "PCH-rpgcraft.h"
+
+#include "x-types.h"
+#include "x-stl.h"
+#include "x-assertion.h"
+
+#include "EntitySpatialHash.h"
+#include "EntityComponents.h"
+
+#include <cmath>
+
+EntitySpatialHash   g_EntitySpatialHash;
+
+static __ai u64 makeCellKey(const int2& coord)
+{
+    return (u64(u32(coord.x)) << 32) | u32(coord.y);
+}
+
+int2 EntitySpatialHash::CellCoord(const float2& pos) const
+{
+    return { int(floorf(pos.x * m_invCellSize)), int(floorf(pos.y * m_invCellSize)) };
+}
+
+s32 EntitySpatialHash::FindCell(const int2& coord) const
+{
+    auto it = m_cellLookup.find(makeCellKey(coord));
+    return (it == m_cellLookup.end()) ? -1 : it->second;
+}
+
+s32 EntitySpatialHash::AcquireCell(const int2& coord)
+{
+    auto key = makeCellKey(coord);
+    auto it  = m_cellLookup.find(key);
+    if (it != m_cellLookup.end()) return it->second;
+
+    s32 cellIdx;
+    if (!m_freeCells.empty()) {
+        cellIdx = m_freeCells.back();
+        m_freeCells.pop_back();
+    }
+    else {
+        cellIdx = (s32)m_cells.size();
+        m_cells.emplace_back();
+    }
+
+    m_cells[cellIdx].coord = coord;
+    m_cellLookup.insert({ key, cellIdx });
+    return cellIdx;
+}
+
+void EntitySpatialHash::Unlink(Entry& entry)
+{
+    auto& cell = m_cells[entry.cell];
+    int   last = (int)cell.gids.size() - 1;
+
+    if (entry.slot != last) {
+        auto moved = cell.gids[last];
+        cell.gids[entry.slot] = moved;
+        cell.pos [entry.slot] = cell.pos[last];
+        m_entries[moved.Index()].slot = entry.slot;
+    }
+    cell.gids.pop_back();
+    cell.pos .pop_back();
+
+    // emptied cells keep their array capacity for reuse, since entities tend to wander back and
+    // forth across the same few boundaries.
+    if (cell.gids.empty()) {
+        m_cellLookup.erase(makeCellKey(cell.coord));
+        m_freeCells.push_back(entry.cell);
+    }
+
+    entry.cell  = -1;
+    entry.slot  = -1;
+    m_count    -= 1;
+}
+
+void EntitySpatialHash::Update(EntityGid_t gid, const float2& pos)
+{
+    auto idx = gid.Index();
+    if (idx >= m_entries.size()) {
+        m_entries.resize(idx + 1, { { ESGID_Empty }, -1, -1 });
+    }
+
+    auto& entry = m_entries[idx];
+    auto  coord = CellCoord(pos);
+
+    if (entry.cell >= 0) {
+        if (entry.gid == gid) {
+            auto& cell = m_cells[entry.cell];
+            if (cell.coord.x == coord.x && cell.coord.y == coord.y) {
+                cell.pos[entry.slot] = pos;
+                return;
+            }
+            m_cellMoves += 1;
+        }
+        // a stale entry occupying the slot index is replaced outright.
+        Unlink(entry);
+    }
+
+    auto  cellIdx = AcquireCell(coord);
+    auto& cell    = m_cells[cellIdx];
+
+    entry.gid   = gid;
+    entry.cell  = cellIdx;
+    entry.slot  = (s32)cell.gids.size();
+    cell.gids.push_back(gid);
+    cell.pos .push_back(pos);
+    m_count    += 1;
+}
+
+void EntitySpatialHash::Remove(EntityGid_t gid)
+{
+    auto idx = gid.Index();
+    if (idx >= m_entries.size()) return;
+
+    auto& entry = m_entries[idx];
+    if (entry.cell < 0 || entry.gid != gid) return;
+    Unlink(entry);
+}
+
+void EntitySpatialHash::Clear()
+{
+    m_cellLookup.clear();
+    m_cells     .clear();
+    m_freeCells .clear();
+    m_entries   .clear();
+    m_results   .clear();
+    m_count     = 0;
+    m_cellMoves = 0;
+}
+
+// Changing the cell size discards the index.  It's repopulated by the next EntitySpatial_Sync().
+void EntitySpatialHash::SetCellSize(float tiles)
+{
+    bug_on(tiles <= 0);
+    Clear();
+    m_cellSize      = tiles;
+    m_invCellSize   = 1.0f / tiles;
+}
+
+int EntitySpatialHash::ConsumeCellMoves()
+{
+    int result  = m_cellMoves;
+    m_cellMoves = 0;
+    return result;
+}
+
+// Visits every indexed entity whose cell overlaps the given range, and appends those accepted by
+// accept(const float2& pos) to the result buffer.  When the range spans more cells than are occupied,
+// the occupied cells are walked directly instead of probing the hash for every coordinate.
+template< typename T >
+void EntitySpatialHash::GatherRange(const float2& min, const float2& max, T&& accept)
+{
+    m_results.clear();
+
+    auto cmin = CellCoord(min);
+    auto cmax = CellCoord(max);
+
+    auto visitCell = [&](const Cell& cell) {
+        int count = (int)cell.gids.size();
+        for (int i=0; i<count; ++i) {
+            if (accept(cell.pos[i])) {
+                m_results.push_back(cell.gids[i]);
+            }
+        }
+    };
+
+    s64 rangeCells = s64(cmax.x - cmin.x + 1) * s64(cmax.y - cmin.y + 1);
+    if (rangeCells > (s64)m_cellLookup.size()) {
+        for (const auto& it : m_cellLookup) {
+            const auto& cell = m_cells[it.second];
+            if (cell.coord.x < cmin.x || cell.coord.x > cmax.x) continue;
+            if (cell.coord.y < cmin.y || cell.coord.y > cmax.y) continue;
+            visitCell(cell);
+        }
+        return;
+    }
+
+    for (int y=cmin.y; y<=cmax.y; ++y) {
+        for (int x=cmin.x; x<=cmax.x; ++x) {
+            auto cellIdx = FindCell({ x, y });
+            if (cellIdx >= 0) {
+                visitCell(m_cells[cellIdx]);
+            }
+        }
+    }
+}
+
+EntityGidSpan EntitySpatialHash::QueryAABB(const float2& min, const float2& max)
+{
+    GatherRange(min, max, [&](const float2& pos) {
+        return pos.x >= min.x && pos.x <= max.x && pos.y >= min.y && pos.y <= max.y;
+    });
+    return { m_results.data(), (int)m_results.size() };
+}
+
+EntityGidSpan EntitySpatialHash::QueryRadius(const float2& center, float radius)
+{
+    float radiusSq = radius * radius;
+    GatherRange(center - radius, center + radius, [&](const float2& pos) {
+        float dx = pos.x - center.x;
+        float dy = pos.y - center.y;
+        return (dx*dx + dy*dy) <= radiusSq;
+    });
+    return { m_results.data(), (int)m_results.size() };
+}
+
+// Entities within tolerance tiles of pos on both axes -- suitable for cursor picking, where
+// pos is the world tile under the mouse.
+EntityGidSpan EntitySpatialHash::QueryPoint(const float2& pos, float tolerance)
+{
+    return QueryAABB(pos - tolerance, pos + tolerance);
+}
+
+// Brings the index up to date with the positions held in the component store.
+void EntitySpatial_Sync()
+{
+    const auto& store = g_EntityComponents;
+    store.ForEach(EntComp_Position, [&](int row) {
+        g_EntitySpatialHash.Update(store.m_gid[row], { store.m_pos_x[row], store.m_pos_y[row] });
+    });
+}
+
+void EntitySpatial_Remove(EntityGid_t gid)
+{
+    g_EntitySpatialHash.Remove(gid);
+}
+
+void EntitySpatial_Reset()
+{
+    g_EntitySpatialHash.Clear();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "x-types.h"
+#include "Entity.h"
+
+#include <vector>
+#include <unordered_map>
+
+// --------------------------------------------------------------------------------------
+//  EntitySpatialHash
+// --------------------------------------------------------------------------------------
+// Uniform grid over world tile coordinates.  Only occupied cells are stored, and they're found
+// through a hash keyed on integer cell coordinates, so the world has no fixed bounds.
+//
+// The index is fed from the EntComp_Position column of the component store by EntitySpatial_Sync(),
+// once per frame after entity ticks and motion integration.  An entity which moves within its cell
+// only has its cached position rewritten.  It's relinked only when it crosses a cell boundary.
+// Entities are dropped from the index when their component row is detached.
+//
+// Queries filter by the cached positions and return an EntityGidSpan backed by a result buffer that
+// is retained by the index.  The span is valid until the next query, and no heap allocation occurs
+// once the buffer has grown to fit the largest result.  Results may include entities that have been
+// removed but not yet collected -- use Entity_TryLookup() where that matters.
+//
+// Thread Safety:
+//   Not thread safe.  Updates and queries occur on the scene thread.  Queries must not be issued
+//   from parallel ticks, since they share the result buffer.
+//
+
+struct EntityGidSpan
+{
+    const EntityGid_t*      m_data;
+    int                     m_count;
+
+    __ai const EntityGid_t* begin   ()          const { return m_data;              }
+    __ai const EntityGid_t* end     ()          const { return m_data + m_count;    }
+    __ai int                size    ()          const { return m_count;             }
+    __ai bool               empty   ()          const { return m_count == 0;        }
+    __ai const EntityGid_t& operator[](int i)   const { return m_data[i];           }
+};
+
+class EntitySpatialHash
+{
+    NONCOPYABLE_OBJECT( EntitySpatialHash );
+
+protected:
+    struct Cell
+    {
+        int2                        coord;
+        std::vector<EntityGid_t>    gids;
+        std::vector<float2>         pos;
+    };
+
+    struct Entry
+    {
+        EntityGid_t     gid;
+        s32             cell;           // -1 if not indexed
+        s32             slot;           // position within the cell's arrays
+    };
+
+    float                           m_cellSize      = 8.0f;
+    float                           m_invCellSize   = 1.0f / 8.0f;
+    std::unordered_map<u64, s32>    m_cellLookup;
+    std::vector<Cell>               m_cells;
+    std::vector<s32>                m_freeCells;    // emptied cells available for reuse
+    std::vector<Entry>              m_entries;      // indexed by EntityGid_t::Index()
+    std::vector<EntityGid_t>        m_results;
+    int                             m_count         = 0;
+    int                             m_cellMoves     = 0;
+
+public:
+    EntitySpatialHash() { }
+
+    void            SetCellSize     (float tiles);
+    void            Update          (EntityGid_t gid, const float2& pos);
+    void            Remove          (EntityGid_t gid);
+    void            Clear           ();
+
+    EntityGidSpan   QueryRadius     (const float2& center, float radius);
+    EntityGidSpan   QueryAABB       (const float2& min, const float2& max);
+    EntityGidSpan   QueryPoint      (const float2& pos, float tolerance = 0.5f);
+
+    __ai int        GetCount        () const { return m_count; }
+    __ai int        GetCellCount    () const { return (int)(m_cells.size() - m_freeCells.size()); }
+    __ai float      GetCellSize     () const { return m_cellSize; }
+
+    // number of entities relinked to a new cell since the last call.
+    int             ConsumeCellMoves();
+
+protected:
+    int2            CellCoord       (const float2& pos) const;
+    s32             FindCell        (const int2& coord) const;
+    s32             AcquireCell     (const int2& coord);
+    void            Unlink          (Entry& entry);
+
+    template< typename T >
+    void            GatherRange     (const float2& min, const float2& max, T&& accept);
+};
+
+extern EntitySpatialHash    g_EntitySpatialHash;
+
+extern void             EntitySpatial_Sync          ();
+extern void             EntitySpatial_Remove        (EntityGid_t gid);
+extern void             EntitySpatial_Reset         ();
@@ -8,13 +8,13 @@
 #include "imgtools.h"
 
 #include "TileMapLayer.h"
+#include "EntityComponents.h"
 #include "Scene.h"
 #include "Mouse.h"
+#include "SpriteBatch.h"
 
-GPU_ConstantBuffer      gpu_constbuf;
 GPU_TextureResource2D   tex_camel[4][3];
 GPU_TextureResource2D   tex_hero [4][3];
-GPU_VertexBuffer        gpu_mesh_box2D;
 
 // Just for annotation purposes.  The player has four directions, which are stored in
 // standard clockwise order:
@@ -57,32 +57,9 @@ void PlayerSprite::LoadStaticAssets()
             dx11_CreateTexture2D(anim[2-i], curtex.buffer.GetPtr(), curtex.size, GPU_ResourceFmt_R8G8B8A8_UNORM);
         }
     }
-
-    // ---------------------------------------------------------------------------------------------
-    TileMapVertex vertices[] =
-    {
-        // UV is in pixels (as it should be).
-        // XY is in tiles .. where Z is expected to be 1.0f
-
-        { vFloat3(   0.0f,  0.0f, 1.0f ), vFloat2( 0.0f,  0.0f) },
-        { vFloat3(   0.0f,  1.0f, 1.0f ), vFloat2( 0.0f, 32.0f) },
-        { vFloat3(  0.75f,  1.0f, 1.0f ), vFloat2(24.0f, 32.0f) },
-        { vFloat3(  0.75f,  0.0f, 1.0f ), vFloat2(24.0f,  0.0f) }
-    };
-
-    dx11_CreateStaticMesh(gpu_mesh_box2D, vertices, sizeof(vertices[0]), bulkof(vertices));
-    // ---------------------------------------------------------------------------------------------
 }
 
 PlayerSprite::PlayerSprite() {
-    gpu_layout_sprite.Reset();
-    gpu_layout_sprite.AddVertexSlot( {
-        { "POSITION", GPU_ResourceFmt_R32G32B32_FLOAT   },
-        { "TEXCOORD", GPU_ResourceFmt_R32G32_FLOAT      }
-    });
-
-    dx11_CreateConstantBuffer(gpu_constbuf, sizeof(float2) + sizeof(int2));
-
     m_position = { 0, 0 };
     m_frame_id = 0;
     m_frame_timeout = 0;
@@ -188,36 +165,28 @@ void PlayerSprite::Tick(u32 order, float dt)
         ImGui::Text("CameraPos = %5.2f %5.2f", g_ViewCamera.m_Eye.x, g_ViewCamera.m_Eye.y);
     }
 
-    g_drawlist_main.Add(this, 1);
+    // publish position to the component store, for use by systems that query entities in bulk.
+    EntityComponents_SetPosition(m_gid, m_position);
+
+    // sprite quads are one tile, centered on the position.
+    g_drawlist_main.Add(this, 1, float4 { m_position.x - 0.5f, m_position.y - 0.5f, m_position.x + 0.5f, m_position.y + 0.5f });
 }
 
 
 void PlayerSprite::Draw(float zorder) const
 {
-    // TODO: most of this is generic for all sprites and should be default for all items
-    // in the sprites render list.  Moreover, the API should be such that any locally-modified GPU
-    // states should be restored after the sprite draw is finished.
+    // Sprites are recorded into the sprite batch and drawn instanced by SpriteBatch_Flush(),
+    // grouped with any other sprites sharing the same texture at this z-order.
 
     const auto tex = m_char_type ? tex_hero : tex_camel;
-    dx11_BindShaderVS       (g_ShaderVS_Spriter);
-    dx11_BindShaderFS       (g_ShaderFS_Spriter);
-    dx11_SetInputLayout     (gpu_layout_sprite);
-    dx11_BindShaderResource (tex[m_anim_dir][m_frame_id], 0);
-    dx11_SetVertexBuffer    (gpu_mesh_box2D, 0, sizeof(TileMapVertex), 0);
-    dx11_SetIndexBuffer     (g_idx_box2D, 16, 0);
-
-    struct {
-        float2  worldpos;
-        int2    ViewMeshSize;
-    } consts;
-
-    consts.worldpos         = m_position;
-    consts.ViewMeshSize     = g_GroundLayerAbove.ViewMeshSize;
 
-    dx11_UpdateConstantBuffer   (gpu_constbuf, &consts);
-    dx11_BindConstantBuffer     (gpu_constbuf, 1);
+    SpriteInstance inst;
+    inst.worldpos   = m_position;
+    inst.size       = { 0.75f, 1.0f };
+    inst.uvRect     = { 0.0f, 0.0f, 24.0f, 32.0f };
+    inst.tint       = { 1.0f, 1.0f, 1.0f, 1.0f };
 
-    dx11_DrawIndexed(6, 0,  0);
+    SpriteBatch_Add(tex[m_anim_dir][m_frame_id], zorder, inst);
 }
 
 void UniformMeshes_InitGlobalResources() {
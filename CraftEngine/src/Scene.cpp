@@ -5,10 +5,12 @@
 #include "x-assertion.h"
 #include "x-string.h"
 #include "x-thread.h"
+#include "x-workers.h"
 #include "x-chrono.h"
 #include "x-pad.h"
 #include "x-host-ifc.h"
 #include "x-gpu-ifc.h"
+#include "x-gpu-cmdlist.h"
 #include "x-ThrowContext.h"
 #include "x-chrono.h"
 
@@ -17,8 +19,14 @@
 
 #include "Scene.h"
 #include "Entity.h"
+#include "EntityComponents.h"
+#include "EntitySpatialHash.h"
+#include "EntityEvents.h"
+#include "SpriteBatch.h"
 #include "DbgTextOverlay.h"
 
+#include "imgui_impl_dx11.h"
+
 #include <queue>
 #include <ctime>
 
@@ -241,6 +249,72 @@ static void* GlobalKeyboardThreadProc(void*)
 
 extern void DevUI_DevControl        ();
 
+void DevUI_Entities()
+{
+    ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowPos( int2 { g_client_size_pix.x - 180, 40 }, ImGuiCond_FirstUseEver);
+
+    Defer(ImGui::End());
+    if (!ImGui::Begin("Entities")) return;
+
+    const auto& entities    = EntityManager_GetEntities();
+    const auto& gc          = EntityManager_GetGcStats();
+    const auto& lod         = EntityComponents_GetTickLodStats();
+    const auto  drawStats   = g_drawlist_main.GetStats();
+
+    ImGui::Value("live       ", entities.GetLiveCount());
+    ImGui::Value("slots      ", entities.GetSlotCount());
+    ImGui::NewLine();
+    ImGui::Value("gc queue   ", gc.queueDepth);
+    ImGui::Value("gc freed   ", gc.freedLastFrame);
+    ImGui::Value("gc time    ", float(gc.lastFrameUs), "%7.1fus");
+    ImGui::InputInt("gc budget (us)", &g_settings_app.entity_gc_budget_us);
+    ImGui::Checkbox("batch lua ticks", &g_settings_app.lua_tick_batching);
+    ImGui::NewLine();
+    ImGui::Value("lod tier 0 ", lod.tierCount[0]);
+    ImGui::Value("lod tier 1 ", lod.tierCount[1]);
+    ImGui::Value("lod tier 2 ", lod.tierCount[2]);
+    ImGui::Value("lod tier 3 ", lod.tierCount[3]);
+    ImGui::Value("lod skipped", lod.ticksSkipped);
+    ImGui::Checkbox("tick lod", &g_settings_app.entity_tick_lod);
+    ImGui::NewLine();
+    ImGui::Value("spatial    ", g_EntitySpatialHash.GetCount());
+    ImGui::Value("cells      ", g_EntitySpatialHash.GetCellCount());
+    ImGui::Value("cell moves ", g_EntitySpatialHash.ConsumeCellMoves());
+    ImGui::NewLine();
+    ImGui::Value("events     ", EntityEvents_GetDispatchedCount());
+    ImGui::NewLine();
+    ImGui::Value("draws      ", drawStats.submitted);
+    ImGui::Value("culled     ", drawStats.culled);
+    ImGui::Checkbox("draw culling", &g_settings_app.draw_culling);
+    ImGui::NewLine();
+    ImGui::Value("sprites    ", SpriteBatch_GetStats().instances);
+    ImGui::Value("sprite dcs ", SpriteBatch_GetStats().draws);
+    ImGui::Value("binds      ", SpriteBatch_GetStats().stateChanges);
+    ImGui::Value("binds saved", SpriteBatch_GetStats().stateChangesSaved);
+}
+
+void DevUI_Pipeline()
+{
+    ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowPos( int2 { g_client_size_pix.x - 180, 70 }, ImGuiCond_FirstUseEver);
+
+    Defer(ImGui::End());
+    if (!ImGui::Begin("Pipeline")) return;
+
+    const auto  stats       = dx11_GetPipelineStats();
+
+    ImGui::Value("draws      ", stats.draws);
+    ImGui::Value("instances  ", stats.instances);
+    ImGui::NewLine();
+    ImGui::Value("binds      ", stats.bindsIssued);
+    ImGui::Value("skipped    ", stats.bindsSkipped);
+    ImGui::NewLine();
+    ImGui::Value("cbuf bytes ", stats.constantBufferBytes);
+    ImGui::Value("dyn bytes  ", stats.dynamicBufferBytes);
+    ImGui::Value("heap bytes ", stats.transientBufferBytes);
+}
+
 void DevUI_Clocks()
 {
     ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
@@ -272,13 +346,204 @@ void DevUI_Clocks()
     );
 }
 
+// --------------------------------------------------------------------------------------
+//  Scene Render Pipeline
+// --------------------------------------------------------------------------------------
+// With render_frame_latency at zero, each frame is recorded and executed in turn on the SceneProducer.
+// Otherwise frames are handed to a dedicated render thread through a ring of up to MaxFrameLatency
+// SceneFrames: the SceneProducer blocks on s_sem_frame_free when the render thread falls that many
+// frames behind, bounding both memory and input latency.
+//
+// Only the render thread may touch the GPU context while the pipeline is running.  Any SceneProducer
+// code which must create or destroy GPU resources (scene init/reload, buffer growth) must first call
+// Scene_WaitRenderIdle() or stop the pipeline.
+//
+
+static const int            MaxFrameLatency = 2;
+
+static SceneFrame           s_frames[MaxFrameLatency];
+static thread_t             s_thr_render;
+static xSemaphore           s_sem_frame_free;
+static xSemaphore           s_sem_frame_ready;
+static int                  s_pipeline_latency      = 0;        // 0 when the render thread is not running
+static int                  s_frame_produce_idx     = 0;
+static int                  s_frame_consume_idx     = 0;
+static bool                 s_frame_recording       = false;    // SceneProducer holds a slot from s_sem_frame_free
+static volatile s32         s_render_exiting        = 0;
+
+SceneFrame::~SceneFrame()
+{
+    for (auto* list : imgui_lists) {
+        delete list;
+    }
+}
+
+void SceneFrame::Reset()
+{
+    for (auto& list : lists) {
+        list.Reset();
+    }
+    clear_color = GPU_Colors::DarkGray;
+    imgui_draw  = nullptr;
+}
+
+template< typename T >
+static void copyImVector(ImVector<T>& dest, const ImVector<T>& src)
+{
+    dest.resize(src.Size);
+    if (src.Size) {
+        xMemCopy(dest.Data, src.Data, src.Size * sizeof(T));
+    }
+}
+
+// Deep-copies ImGui's draw data, which is otherwise only valid until the next ImGui::NewFrame().
+// Only the render-facing buffers of each ImDrawList are copied.
+void SceneFrame::CaptureImGui(const ImDrawData* src)
+{
+    imgui_draw = nullptr;
+    if (!src || !src->Valid) return;
+
+    while ((int)imgui_lists.size() < src->CmdListsCount) {
+        imgui_lists.push_back(new ImDrawList());
+    }
+
+    for (int i=0; i<src->CmdListsCount; ++i) {
+        const auto& from = *src->CmdLists[i];
+        auto&       to   = *imgui_lists[i];
+        copyImVector(to.CmdBuffer, from.CmdBuffer);
+        copyImVector(to.IdxBuffer, from.IdxBuffer);
+        copyImVector(to.VtxBuffer, from.VtxBuffer);
+    }
+
+    imgui_captured.Valid            = true;
+    imgui_captured.CmdLists         = imgui_lists.data();
+    imgui_captured.CmdListsCount    = src->CmdListsCount;
+    imgui_captured.TotalVtxCount    = src->TotalVtxCount;
+    imgui_captured.TotalIdxCount    = src->TotalIdxCount;
+    imgui_draw = &imgui_captured;
+}
+
+static void SceneFrame_Execute(const SceneFrame& frame)
+{
+    dx11_NewFrame();
+    dx11_BeginFrameDrawing();
+
+    // Clear background for diagnostic purposes:
+    // TODO: Replace this with some pattern that clearly invokes "non-gameplay component", like a gray/black checkerboard.
+
+    dx11_SetRasterState(GPU_Fill_Solid, GPU_Cull_None, GPU_Scissor_Disable);
+    dx11_ClearRenderTarget(g_gpu_BackBuffer, frame.clear_color);
+
+    GPU_ExecuteCommandLists(frame.lists, SceneFrameList_Count);
+
+    if (frame.imgui_draw && frame.imgui_draw->CmdListsCount) {
+        ImGui_ImplDX11_RenderDrawLists(frame.imgui_draw);
+    }
+    dx11_SubmitFrameAndSwap();
+}
+
+static void* RenderThreadProc(void*)
+{
+    while(1) {
+        s_sem_frame_ready.Wait();
+        if (s_render_exiting) break;
+
+        SceneFrame_Execute(s_frames[s_frame_consume_idx]);
+        s_frame_consume_idx = (s_frame_consume_idx + 1) % s_pipeline_latency;
+        s_sem_frame_free.Post();
+    }
+    return nullptr;
+}
+
+// Blocks until the render thread has finished with every submitted frame.  May be called while
+// a frame is being recorded, in which case that frame's slot is already held by the caller.
+void Scene_WaitRenderIdle()
+{
+    if (!s_pipeline_latency) return;
+    int inFlight = s_pipeline_latency - (s_frame_recording ? 1 : 0);
+    for (int i=0; i<inFlight; ++i) { s_sem_frame_free.Wait(); }
+    for (int i=0; i<inFlight; ++i) { s_sem_frame_free.Post(); }
+}
+
+static void RenderPipeline_Stop()
+{
+    if (!s_pipeline_latency) return;
+    bug_on(s_frame_recording, "Render pipeline cannot be stopped while recording a frame.");
+
+    Scene_WaitRenderIdle();
+    s_render_exiting = 1;
+    s_sem_frame_ready.Post();
+    thread_join(s_thr_render);
+
+    s_sem_frame_free .Delete();
+    s_sem_frame_ready.Delete();
+    s_pipeline_latency = 0;
+}
+
+static void RenderPipeline_Start(int latency)
+{
+    bug_on(s_pipeline_latency);
+    bug_on(latency < 1 || latency > MaxFrameLatency);
+
+    s_sem_frame_free .Create();
+    s_sem_frame_ready.Create();
+    for (int i=0; i<latency; ++i) {
+        s_sem_frame_free.Post();
+    }
+
+    s_pipeline_latency  = latency;
+    s_frame_produce_idx = 0;
+    s_frame_consume_idx = 0;
+    s_render_exiting    = 0;
+    thread_create(s_thr_render, RenderThreadProc, "SceneRender", _256kb);
+}
+
+// Returns a frame ready for recording.  Also applies changes to render_frame_latency, which is
+// sampled only between frames.
+static SceneFrame& RenderPipeline_BeginFrame()
+{
+    int latency = std::min(std::max(g_settings_app.render_frame_latency, 0), MaxFrameLatency);
+    if (latency != s_pipeline_latency) {
+        RenderPipeline_Stop();
+        if (latency) {
+            RenderPipeline_Start(latency);
+        }
+    }
+
+    if (!s_pipeline_latency) {
+        auto& frame = s_frames[0];
+        frame.Reset();
+        return frame;
+    }
+
+    s_sem_frame_free.Wait();
+    s_frame_recording = true;
+    auto& frame = s_frames[s_frame_produce_idx];
+    frame.Reset();
+    return frame;
+}
+
+// Expects ImGui::Render() to have been called for this frame.
+static void RenderPipeline_SubmitFrame(SceneFrame& frame)
+{
+    if (!s_pipeline_latency) {
+        frame.imgui_draw = ImGui::GetDrawData();
+        SceneFrame_Execute(frame);
+        return;
+    }
+
+    frame.CaptureImGui(ImGui::GetDrawData());
+    s_frame_produce_idx = (s_frame_produce_idx + 1) % s_pipeline_latency;
+    s_frame_recording   = false;
+    s_sem_frame_ready.Post();
+}
+
 static void* SceneProducerThreadProc(void*)
 {
     Host_ImGui_Init();
 
     while(1)
     {
-        dx11_NewFrame();
         Host_ImGui_NewFrame();
         DbgTextOverlay_NewFrame();
 
@@ -295,7 +560,9 @@ static void* SceneProducerThreadProc(void*)
         s_world_qpc_frametick = HostClockTick::Now();
 
         if (!s_scene_stopReason && s_world_localtime_qpc_last_update.asTicks() != 0) {
-            s_world_deltatime  = WorldTick_Now() - s_world_localtime_qpc_last_update;
+            s_world_deltatime  = (g_settings_app.fixed_frame_time_ms > 0)
+                ? HostClockTick::Seconds(g_settings_app.fixed_frame_time_ms / 1000.0)
+                : WorldTick_Now() - s_world_localtime_qpc_last_update;
             s_world_localtime += s_world_deltatime;
         }
         s_world_localtime_qpc_last_update = HostClockTick::Now();
@@ -307,14 +574,19 @@ static void* SceneProducerThreadProc(void*)
 
         DevUI_DevControl();
         DevUI_Clocks();
+        DevUI_Entities();
+        DevUI_Pipeline();
 
         if (Scene_HasStopReason(SceneStopReason_ScriptError)) {
-            dx11_BeginFrameDrawing();
-            dx11_SetRasterState(GPU_Fill_Solid, GPU_Cull_None, GPU_Scissor_Disable);
-            dx11_ClearRenderTarget(g_gpu_BackBuffer, GPU_Colors::MidnightBlue);
-            DbgTextOverlay_SceneRender();
+            // error display is executed immediately, since the scene is about to be reloaded anyway.
+            RenderPipeline_Stop();
+            auto& frame = s_frames[0];
+            frame.Reset();
+            frame.clear_color = GPU_Colors::MidnightBlue;
+            DbgTextOverlay_SceneRender(frame.lists[SceneFrameList_Overlay]);
             ImGui::Render();
-            dx11_SubmitFrameAndSwap();
+            frame.imgui_draw = ImGui::GetDrawData();
+            SceneFrame_Execute(frame);
             xThreadSleep(32);
             s_world_localtime_qpc_last_update = HostClockTick::Now();
             continue;
@@ -327,6 +599,7 @@ static void* SceneProducerThreadProc(void*)
         }
 
         if (!SceneInitialized()) {
+            RenderPipeline_Stop();
             SceneInit();
             s_world_localtime_qpc_last_update = HostClockTick::Now();
         }
@@ -352,27 +625,28 @@ static void* SceneProducerThreadProc(void*)
                 //HudSceneLogic();
             }
 
-            dx11_BeginFrameDrawing();
-
-            // Clear background for diagnostic purposes:
-            // TODO: Replace this with some pattern that clearly invokes "non-gameplay component", like a gray/black checkerboard.
-
-            dx11_SetRasterState(GPU_Fill_Solid, GPU_Cull_None, GPU_Scissor_Disable);
-            dx11_ClearRenderTarget(g_gpu_BackBuffer, GPU_Colors::DarkGray);
+            auto& frame = RenderPipeline_BeginFrame();
 
             if (s_scene_devExecMask & SceneExecMask_GameplayRender) {
-                GameplaySceneRender();
+                GameplaySceneRender(frame);
             }
             if (s_scene_devExecMask & SceneExecMask_HudRender) {
                 //HudSceneRender();
             }
-            DbgTextOverlay_SceneRender();
+            DbgTextOverlay_SceneRender(frame.lists[SceneFrameList_Overlay]);
             ImGui::Render();
-            dx11_SubmitFrameAndSwap();
+            RenderPipeline_SubmitFrame(frame);
 
+            // Recording of the current frame is complete, so anything removed during it (or earlier)
+            // is no longer referenced -- frames handed to the render thread reference only GPU
+            // resources.  While stopped by the developer there's no frame-time pressure, so the
+            // queue is flushed in full.
             if (Scene_HasStopReason(SceneStopReason_Developer)) {
                 EntityManager_CollectGarbage();
             }
+            else {
+                EntityManager_CollectGarbage(s_scene_frame_count, g_settings_app.entity_gc_budget_us);
+            }
         }
 
         // TODO : framerate pacing (vsync disabled)
@@ -381,6 +655,7 @@ static void* SceneProducerThreadProc(void*)
         xThreadSleep(16/2);
     }
 
+    RenderPipeline_Stop();
     s_sem_thread_done.Post();
 
     return nullptr;
@@ -389,6 +664,7 @@ static void* SceneProducerThreadProc(void*)
 void Scene_CreateThreads()
 {
     s_scene_thread_running = true;
+    g_WorkerPool.Init();
     thread_create(s_thr_scene_producer, SceneProducerThreadProc, "SceneProducer", _256kb);
 }
 
@@ -398,6 +674,7 @@ void Scene_ShutdownThreads()
     Scene_PostMessage(SceneMsg_Shutdown, 0);
     s_sem_thread_done.WaitWithTimeout(2000);
     s_scene_thread_running = false;
+    g_WorkerPool.Shutdown();
 }
 
 bool Scene_HasStopReason(u32 stopReason)
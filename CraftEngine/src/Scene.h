@@ -4,11 +4,14 @@
 #include "x-stl.h"
 #include "x-assertion.h"
 #include "x-host-ifc.h"
+#include "x-gpu-cmdlist.h"
 
 #include "ajek-script.h"
 #include "imgui.h"
 #include "Entity.h"
 
+#include <vector>
+
 
 // Scene Messaging Remarks:
 //   Scene Messages are processed at a rate matching the FPS of the title.  This is between 8ms and 48ms.
@@ -76,12 +79,50 @@ struct SceneMessage
     }
 };
 
+// SceneFrame
+//   Everything needed to render one frame, recorded by the SceneProducer after logic has run: GPU command
+//   lists for each part of the scene, and ImGui's draw data.  Frames are either executed immediately on
+//   the SceneProducer, or -- when render_frame_latency is non-zero -- handed to a dedicated render thread
+//   which draws frame N while the SceneProducer runs logic for frame N+1.  A frame must therefore not
+//   reference any state which logic is free to modify: command lists copy their constants and uploads,
+//   and ImGui draw data is copied when the frame is submitted.
+//
+enum SceneFrameListId
+{
+    SceneFrameList_Setup,
+    SceneFrameList_GroundBelow,
+    SceneFrameList_GroundAbove,
+    SceneFrameList_Sprites,
+    SceneFrameList_Overlay,
+    SceneFrameList_Count
+};
+
+struct SceneFrame
+{
+    NONCOPYABLE_OBJECT(SceneFrame);
+
+public:
+    GPU_CommandList             lists[SceneFrameList_Count];
+    float4                      clear_color;
+    ImDrawData*                 imgui_draw      = nullptr;      // live or captured ImGui draw data
+
+    ImDrawData                  imgui_captured;
+    std::vector<ImDrawList*>    imgui_lists;                    // owned, reused across frames
+
+public:
+    SceneFrame() {}
+    ~SceneFrame();
+
+    void    Reset           ();
+    void    CaptureImGui    (const ImDrawData* src);
+};
+
 extern void         Scene_CreateThreads                 ();
 extern void         Scene_ShutdownThreads               ();
 
 extern bool         SceneInitialized                    ();
 extern void         SceneInit                           ();
-extern void         GameplaySceneRender                 ();
+extern void         GameplaySceneRender                 (SceneFrame& frame);
 extern void         GameplaySceneLogic                  (float deltaTime);
 extern int          Scene_GetFrameCount                 ();
 
@@ -94,6 +135,7 @@ extern void         Scene_DrainMsgQueue                 ();
 extern bool         Scene_HasStopReason                 (u32 stopReason = ~0);
 
 extern bool         Scene_IsKeyPressed                  (VirtKey_t vk_code);
+extern void         Scene_WaitRenderIdle                ();
 
 extern OrderedDrawList      g_drawlist_main;
 extern OrderedDrawList      g_drawlist_ui;
@@ -0,0 +1,157 @@
+#include "PCH-rpgcraft.h"
+
+#include "x-types.h"
+#include "x-stl.h"
+#include "x-assertion.h"
+#include "x-gpu-ifc.h"
+#include "x-gpu-cmdlist.h"
+#include "x-gpu-sortkey.h"
+#include "v-float.h"
+
+#include "SpriteBatch.h"
+#include "UniformMeshes.h"
+
+#include <vector>
+
+struct SpriteBatchItem
+{
+    SpriteMaterial      material;       // shaders resolved to the batch defaults at Add()
+    s32                 instance;       // index into s_instances
+};
+
+static GPU_ShaderVS                     s_ShaderVS_SpriteInstanced;
+static GPU_ShaderFS                     s_ShaderFS_SpriteInstanced;
+static GPU_InputDesc                    s_layout_sprite_instanced;
+static GPU_VertexBuffer                 s_mesh_quad;
+
+static std::vector<SpriteBatchItem>     s_items;
+static std::vector<GPU_SortItem>        s_sorted;
+static std::vector<GPU_SortItem>        s_sort_scratch;
+static std::vector<SpriteInstance>      s_instances;
+static std::vector<SpriteInstance>      s_upload;
+static SpriteBatchStats                 s_stats;
+
+static __ai bool operator==(const SpriteMaterial& lval, const SpriteMaterial& rval)
+{
+    return lval.texture == rval.texture && lval.shaderVS == rval.shaderVS && lval.shaderFS == rval.shaderFS;
+}
+
+static __ai bool operator!=(const SpriteMaterial& lval, const SpriteMaterial& rval)
+{
+    return !(lval == rval);
+}
+
+// Number of binds needed to switch from one material to the next.  prev may be null, for the first
+// material of the batch.
+static __ai int countStateChanges(const SpriteMaterial* prev, const SpriteMaterial& next)
+{
+    if (!prev) return 3;
+    return (prev->shaderVS != next.shaderVS) + (prev->shaderFS != next.shaderFS) + (prev->texture != next.texture);
+}
+
+void SpriteBatch_InitGlobalResources()
+{
+    s_layout_sprite_instanced.Reset();
+    s_layout_sprite_instanced.AddVertexSlot( {
+        { "POSITION", GPU_ResourceFmt_R32G32_FLOAT          },
+        { "TEXCOORD", GPU_ResourceFmt_R32G32_FLOAT          }
+    });
+
+    s_layout_sprite_instanced.AddInstanceSlot( {
+        { "WORLDPOS", GPU_ResourceFmt_R32G32_FLOAT          },
+        { "SIZE",     GPU_ResourceFmt_R32G32_FLOAT          },
+        { "UVRECT",   GPU_ResourceFmt_R32G32B32A32_FLOAT    },
+        { "COLOR",    GPU_ResourceFmt_R32G32B32A32_FLOAT    }
+    });
+
+    dx11_CreateStaticMesh(s_mesh_quad, g_mesh_UniformQuad, sizeof(g_mesh_UniformQuad[0]), bulkof(g_mesh_UniformQuad));
+
+    dx11_LoadShaderVS(s_ShaderVS_SpriteInstanced, "SpriteInstanced.fx", "VS");
+    dx11_LoadShaderFS(s_ShaderFS_SpriteInstanced, "SpriteInstanced.fx", "PS");
+}
+
+void SpriteBatch_Add(const SpriteMaterial& material, float zorder, const SpriteInstance& instance, int layer)
+{
+    bug_on_qa(!material.texture);
+
+    SpriteMaterial resolved = material;
+    if (!resolved.shaderVS) resolved.shaderVS = &s_ShaderVS_SpriteInstanced;
+    if (!resolved.shaderFS) resolved.shaderFS = &s_ShaderFS_SpriteInstanced;
+
+    GPU_SortKeyDesc desc;
+    desc.layer          = layer;
+    desc.translucent    = !resolved.opaque;
+    desc.depth          = zorder;
+    desc.shaderVS       = resolved.shaderVS;
+    desc.shaderFS       = resolved.shaderFS;
+    desc.layout         = &s_layout_sprite_instanced;
+    desc.texture        = resolved.texture;
+
+    s_sorted.push_back({ GPU_MakeSortKey(desc), (u32)s_items.size() });
+    s_items.push_back({ resolved, (s32)s_instances.size() });
+    s_instances.push_back(instance);
+}
+
+// Records draws for everything added since the previous flush.  Expects the view constants to
+// already be bound to cb0 (as done by GameplaySceneRender) when the list is executed.
+void SpriteBatch_Flush(GPU_CommandList& cmds)
+{
+    s_stats = {};
+    if (s_items.empty()) return;
+
+    // Adds arrive in ForEachAlpha() order -- highest z-order first -- and translucent keys invert depth,
+    // so their keys arrive ascending and the stable sort only regroups materials within each depth.
+    GPU_SortByKey(s_sorted, s_sort_scratch);
+
+    int count = (int)s_items.size();
+    s_upload.resize(count);
+    for (int i=0; i<count; ++i) {
+        s_upload[i] = s_instances[s_items[s_sorted[i].index].instance];
+    }
+
+    // cost of drawing in submission order, one bind per change of state between consecutive sprites.
+    int unsortedChanges = 0;
+    for (int i=0; i<count; ++i) {
+        unsortedChanges += countStateChanges(i ? &s_items[i-1].material : nullptr, s_items[i].material);
+    }
+
+    // instances only live for the frame, so they go through the transient heap -- there's no instance
+    // buffer to size for the busiest frame, or to grow while frames are in flight.
+    cmds.SetInputLayout     (s_layout_sprite_instanced);
+    cmds.SetVertexBuffer    (s_mesh_quad, 0, sizeof(g_mesh_UniformQuad[0]), 0);
+    cmds.SetTransientVertexBuffer(s_upload.data(), sizeof(SpriteInstance) * count, 1, sizeof(SpriteInstance));
+    cmds.SetIndexBuffer     (g_idx_box2D, 16, 0);
+
+    const SpriteMaterial* bound = nullptr;
+    int runStart = 0;
+    while (runStart < count) {
+        const auto& material = s_items[s_sorted[runStart].index].material;
+
+        // runs break only on material changes -- keys which differ only by depth or layer are still
+        // drawn together since nothing else can be drawn in between.  Sort key ids are hashed, so
+        // runs are formed by comparing the actual material.
+        int runEnd = runStart + 1;
+        while (runEnd < count && s_items[s_sorted[runEnd].index].material == material) ++runEnd;
+
+        if (!bound || bound->shaderVS != material.shaderVS) cmds.BindShaderVS      (*material.shaderVS);
+        if (!bound || bound->shaderFS != material.shaderFS) cmds.BindShaderFS      (*material.shaderFS);
+        if (!bound || bound->texture  != material.texture ) cmds.BindShaderResource(*material.texture, 0);
+        cmds.DrawIndexedInstanced(6, runEnd - runStart, 0, 0, runStart);
+
+        s_stats.draws        += 1;
+        s_stats.stateChanges += countStateChanges(bound, material);
+        bound                 = &material;
+        runStart              = runEnd;
+    }
+
+    s_stats.instances           = count;
+    s_stats.stateChangesSaved   = unsortedChanges - s_stats.stateChanges;
+    s_items    .clear();
+    s_instances.clear();
+    s_sorted   .clear();
+}
+
+const SpriteBatchStats& SpriteBatch_GetStats()
+{
+    return s_stats;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "x-types.h"
+#include "x-gpu-ifc.h"
+#include "x-gpu-cmdlist.h"
+
+// --------------------------------------------------------------------------------------
+//  SpriteBatch
+// --------------------------------------------------------------------------------------
+// Instanced sprite renderer which sits behind the draw list.  Rather than binding state and issuing
+// a draw per sprite, Draw() callbacks invoked by the draw list traversal call SpriteBatch_Add(), which
+// only records an instance.  SpriteBatch_Flush() then records a single transient upload of every
+// instance and one DrawIndexedInstanced per run of sprites sharing a material (texture + shaders)
+// into the given command list.
+//
+// Ordering: every instance carries a packed GPU_SortKey (layer, translucency, depth, shaders,
+// texture, input layout).  Layers are drawn strictly in order.  Translucent sprites -- the default --
+// are drawn back to front, highest z-order first, which is the order ForEachAlpha() adds them in;
+// only instances sharing a z-order are regrouped by material.  Sprites flagged opaque are drawn ahead
+// of the layer's translucent sprites and grouped by material regardless of z-order; there is no depth
+// buffer, so only flag sprites opaque if they never overlap others in the same layer (ground decals,
+// tiles, etc).
+//
+// Draw list callbacks must not issue device calls directly: the batch is flushed into a command list
+// which is executed after the tilemap layers, and anything drawn directly from a callback would end
+// up beneath them.
+//
+// Thread Safety:
+//   SpriteBatch_Add() and SpriteBatch_Flush() run on the thread recording the scene frame (the
+//   SceneProducer, also in pipelined mode) and are not thread-safe.  Flush() only records, and may be
+//   run from a worker so long as no Add() is in progress.  Only execution of the recorded command
+//   list happens on the render thread.
+//
+
+struct SpriteInstance
+{
+    float2      worldpos;           // tile coords, same convention as Sprite.fx
+    float2      size;               // tiles
+    float4      uvRect;             // pixels: xy = top-left, zw = bottom-right
+    float4      tint;               // multiplied against the sampled texel
+};
+
+struct SpriteMaterial
+{
+    const GPU_ShaderResource*   texture;
+    const GPU_ShaderVS*         shaderVS;       // nullptr for the default instanced sprite shaders
+    const GPU_ShaderFS*         shaderFS;
+    bool                        opaque;         // order-independent within its layer, see above
+};
+
+struct SpriteBatchStats
+{
+    int         instances;
+    int         draws;
+    int         stateChanges;           // shader/texture binds issued after sorting
+    int         stateChangesSaved;      // binds avoided relative to drawing in submission order
+};
+
+extern void                     SpriteBatch_InitGlobalResources ();
+extern void                     SpriteBatch_Add                 (const SpriteMaterial& material, float zorder, const SpriteInstance& instance, int layer=0);
+extern void                     SpriteBatch_Flush               (GPU_CommandList& cmds);
+extern const SpriteBatchStats&  SpriteBatch_GetStats            ();
+
+inline void SpriteBatch_Add(const GPU_ShaderResource& texture, float zorder, const SpriteInstance& instance, int layer=0)
+{
+    SpriteBatch_Add({ &texture, nullptr, nullptr, false }, zorder, instance, layer);
+}
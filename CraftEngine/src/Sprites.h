@@ -39,9 +39,6 @@ class PlayerSprite
 private:
     NONCOPYABLE_OBJECT(PlayerSprite);
 
-public:
-    GPU_InputDesc       gpu_layout_sprite;
-
 public:
     EntityGid_t         m_gid;
     float2              m_position;
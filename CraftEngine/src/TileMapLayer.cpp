@@ -13,11 +13,11 @@
 //  - Maybe better handled as a generic "age" engine feature?
 //  - But there could be different types of mosses, or stalagmites, or other environment changes.
 
-u32*                g_ViewTileID    = nullptr;  // temporarily global - will localize later.
-
-GPU_ConstantBuffer      g_cnstbuf_TileMap;
 
 TileMapLayer::TileMapLayer() {
+    ViewTileID              = nullptr;
+    m_tileIDsDirty          = true;
+    m_framesSinceUpload     = 0;
 }
 
 void TileMapLayer::PopulateUVs(const void* terrain_data, int stride_in_words, const int2& viewport_offset)
@@ -27,7 +27,7 @@ void TileMapLayer::PopulateUVs(const void* terrain_data, int stride_in_words, co
 
     const int* tileptr = (int*)terrain_data;
 
-    g_ViewTileID = (u32*)xRealloc(g_ViewTileID, ViewInstanceCount * sizeof(u32));
+    ViewTileID = (u32*)xRealloc(ViewTileID, ViewInstanceCount * sizeof(u32));
 
     // Populate view mesh according to world map information:
 
@@ -41,14 +41,18 @@ void TileMapLayer::PopulateUVs(const void* terrain_data, int stride_in_words, co
             // Fill in area past the end of the map.
             // This could be filled procedurally to allow for some patterned expanse of terrain type...
 
-            if (y<0 || x<0)                     { g_ViewTileID[instanceId] = 1; continue; }
-            if (y>=WorldSizeY || x>=WorldSizeX) { g_ViewTileID[instanceId] = 1; continue; }
+            u32 tileID = 1;
+            if (y>=0 && x>=0 && y<WorldSizeY && x<WorldSizeX) {
+                tileID = tileptr[(((y * WorldSizeX) + x) * stride_in_words) + m_data_offset_uv];
+            }
 
-            g_ViewTileID[instanceId] = tileptr[(((y * WorldSizeX) + x) * stride_in_words) + m_data_offset_uv];
+            m_tileIDsDirty |= (ViewTileID[instanceId] != tileID);
+            ViewTileID[instanceId] = tileID;
         }
     }
 
-    dx11_UploadDynamicBufferData(gpu.mesh_worldViewTileID, g_ViewTileID,  sizeof(g_ViewTileID[0]) * ViewInstanceCount);
+    // Uploaded to the GPU by Draw() -- tile IDs are held per-layer so that the upload can be
+    // recorded into a frame's command lists and replayed on the render thread.
 }
 
 void TileMapLayer::PopulateUVs(const void* terrain_data, int stride_in_words)
@@ -111,11 +115,10 @@ void TileMapLayer::InitScene(const char* script_objname)
         { "COLOR",  GPU_ResourceFmt_R32G32B32A32_FLOAT }
     });
 
-    // TODO: only want to initialize this once for all tilemap instances.
-    dx11_CreateConstantBuffer(g_cnstbuf_TileMap,    sizeof(GPU_TileMapConstants));
-
     dx11_CreateStaticMesh(gpu.mesh_tile, g_mesh_UniformQuad, sizeof(g_mesh_UniformQuad[0]), bulkof(g_mesh_UniformQuad));
-    dx11_CreateDynamicVertexBuffer(gpu.mesh_worldViewTileID, sizeof(g_ViewTileID[0]) * ViewInstanceCount, script_objname);
+    dx11_CreateDynamicVertexBuffer(gpu.mesh_worldViewTileID, sizeof(ViewTileID[0]) * ViewInstanceCount, script_objname, TileIDUpdateInterval);
+    m_tileIDsDirty          = true;
+    m_framesSinceUpload     = 0;
 
     dx11_LoadShaderVS(g_ShaderVS_Tiler, "TileMap.fx", "VS");
     dx11_LoadShaderFS(g_ShaderFS_Tiler, "TileMap.fx", "PS");
@@ -149,24 +152,32 @@ void TileMapLayer::CenterViewOn(const float2& dest)
 void TileMapLayer::Tick() {
 }
 
-void TileMapLayer::Draw() const
+void TileMapLayer::Draw(GPU_CommandList& cmds) const
 {
     if (!m_enableDraw) return;
 
-    dx11_BindShaderVS(g_ShaderVS_Tiler);
-    dx11_BindShaderFS(g_ShaderFS_Tiler);
-    dx11_SetInputLayout(gpu.layout_tilemap);
+    cmds.BindShaderVS(g_ShaderVS_Tiler);
+    cmds.BindShaderFS(g_ShaderFS_Tiler);
+    cmds.SetInputLayout(gpu.layout_tilemap);
 
-//  dx11_SetPrimType(GPU_PRIM_TRIANGLELIST);
-    dx11_BindShaderResource(gpu.tex_floor, 0);
+//  cmds.SetPrimType(GPU_PRIM_TRIANGLELIST);
+    cmds.BindShaderResource(gpu.tex_floor, 0);
 
-    dx11_SetVertexBuffer(gpu.mesh_tile,             0, sizeof(g_mesh_UniformQuad[0]), 0);
-    dx11_SetVertexBuffer(gpu.mesh_worldViewTileID,  1, sizeof(g_ViewTileID[0]), 0);
-    //dx11_SetVertexBuffer(g_mesh_worldViewColor, 2, sizeof(g_ViewUV[0]), 0);
+    cmds.SetVertexBuffer(gpu.mesh_tile,             0, sizeof(g_mesh_UniformQuad[0]), 0);
+
+    // Tile IDs only change when the view scrolls onto a new tile or the map itself is modified, so
+    // clean frames skip the upload.  The buffer still has to be refreshed once per update interval,
+    // since the GPU instance it was last written to is recycled after that.
+    if (m_tileIDsDirty || (++m_framesSinceUpload >= TileIDUpdateInterval)) {
+        cmds.UploadDynamicBufferData(gpu.mesh_worldViewTileID, ViewTileID, sizeof(ViewTileID[0]) * ViewInstanceCount);
+        m_tileIDsDirty      = false;
+        m_framesSinceUpload = 0;
+    }
+    cmds.SetVertexBuffer(gpu.mesh_worldViewTileID,  1, sizeof(ViewTileID[0]), 0);
+    //cmds.SetVertexBuffer(g_mesh_worldViewColor, 2, sizeof(g_ViewUV[0]), 0);
 
-    dx11_UpdateConstantBuffer(g_cnstbuf_TileMap, &gpu.consts);
-    dx11_BindConstantBuffer(g_cnstbuf_TileMap, 1);
-    dx11_SetIndexBuffer(g_idx_box2D, 16, 0);
-    dx11_DrawIndexedInstanced(6, ViewInstanceCount, 0, 0, 0);
+    cmds.BindConstants(gpu.consts, 1);
+    cmds.SetIndexBuffer(g_idx_box2D, 16, 0);
+    cmds.DrawIndexedInstanced(6, ViewInstanceCount, 0, 0, 0);
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "x-gpu-ifc.h"
+#include "x-gpu-cmdlist.h"
 #include "x-BitmapData.h"
 
 #include "Entity.h"
@@ -25,6 +26,7 @@ public:
     void            UpdateFrustrum  ();
     void            SetEyeAt        (const float2& xy);
     float4          ClientToWorld   (const int2& clientPosInPix);
+    float4          GetVisibleArea  (float margin = 1.0f) const;
 
     virtual void Tick();
 
@@ -72,6 +74,10 @@ public:
         vInt2   ViewMeshSize;
     };
 
+public:
+    // Frames a clean set of tile IDs may go without being re-uploaded.
+    static const int TileIDUpdateInterval = 4;
+
 public:
     EntityGid_t             m_gid;
 
@@ -94,6 +100,12 @@ public:
     int2    ViewMeshSize;
     int     ViewInstanceCount;
     int     ViewVerticiesCount;
+    u32*    ViewTileID;             // CPU copy of the view's tile IDs, uploaded at Draw()
+
+    // Draw() is const so that layers can be recorded from worker threads, but each layer is only
+    // ever recorded by one list per frame -- the upload bookkeeping is safe to mutate there.
+    mutable bool    m_tileIDsDirty;
+    mutable int     m_framesSinceUpload;
 
     int     m_data_offset_uv;
     int     m_edge_tile;
@@ -114,7 +126,7 @@ public:
     template<typename T> void PopulateUVs (const T* terrain_data);
 
     virtual void Tick();
-    virtual void Draw() const;
+    virtual void Draw(GPU_CommandList& cmds) const;
 };
 
 template<typename T> inline void TileMapLayer::PopulateUVs (const T* terrain_data, const int2& viewport_offset)
@@ -140,7 +152,6 @@ extern TileMapLayer         g_GroundLayerBelow;
 
 extern GPU_ShaderVS         g_ShaderVS_Tiler;
 extern GPU_ShaderFS         g_ShaderFS_Tiler;
-extern GPU_ConstantBuffer   g_cnstbuf_TileMap;
 
 static const int TileSizeX = 8;
 static const int TileSizeY = 8;
@@ -19,6 +19,12 @@ struct HostAppSettings
     bool    has_backbuffer_size     = false;
     bool    windowless_mode         = false;
     int     kill_at_frame_number    = 0;
+    int     entity_gc_budget_us     = 500;      // per-frame time budget for freeing removed entities (0 = unlimited)
+    bool    lua_tick_batching       = false;    // dispatch Lua ticks once per class (reorders them after native ticks in a bucket)
+    bool    entity_tick_lod         = true;     // reduce tick rate of EntityTick_Lod entities far from the view
+    bool    draw_culling            = true;     // reject bounded draw list items outside the view
+    int     render_frame_latency    = 0;        // frames the render thread may trail logic (0 = render on the scene thread, max 2)
+    float   fixed_frame_time_ms     = 0;        // step the world by this much every frame instead of by wall time (0 = off)
 };
 
 struct AudioSettings
@@ -5,20 +5,26 @@
 #include "x-assertion.h"
 #include "x-string.h"
 #include "x-thread.h"
+#include "x-workers.h"
 
 #include "x-host-ifc.h"
 #include "x-gpu-ifc.h"
 #include "x-gpu-colors.h"
+#include "x-gpu-cmdlist.h"
 #include "x-png-decode.h"
 #include "v-float.h"
 
 #include "appConfig.h"
 #include "ajek-script.h"
 #include "Entity.h"
+#include "EntityComponents.h"
+#include "EntitySpatialHash.h"
+#include "EntityEvents.h"
 #include "Sprites.h"
 #include "TileMapLayer.h"
 #include "Scene.h"
 #include "UniformMeshes.h"
+#include "SpriteBatch.h"
 
 #include <DirectXMath.h>
 
@@ -99,9 +105,67 @@ float4 get3dPoint(const int2& viewPos, const int2& viewSize, const XMMATRIX& vie
     return (float4&)result;
 }
 
+struct ParallelTickItem
+{
+    const TickableEntityItem*   entitem;
+    float                       deltaTime;      // differs from the frame's for EntityTick_Lod items
+};
+
+static const int                        ParallelTickGrainSize = 64;
+static std::vector<ParallelTickItem>            s_parallel_ticks;
+static std::vector<const TickableEntityItem*>   s_lua_ticks;
+
+static void TickEntitySerial(const TickableEntityItem& entitem, float deltaTime)
+{
+    // reference into the entity slot table -- only valid until the next entity spawn, which
+    // may grow the table.  All reads below occur prior to invoking the tick.
+    const auto& entity = Entity_Lookup(entitem.orderGidPair.Gid());
+    bug_on (!entity.objectptr);
+
+    if (entitem.Tick) {
+        entitem.Tick(entity.objectptr, entitem.orderGidPair.Order(), deltaTime);
+    }
+    else {
+        // no C++ native tick() binding.  Look up and execute Lua module binding.
+        // (only reached when Lua tick batching is disabled -- see TickLuaEntitiesBatched)
+
+        g_scriptEnv.pushreg(entitem.lua_tick);      // function to call
+        g_scriptEnv.pushreg(entity.lua_object);     // self object (lua table)
+        g_scriptEnv.pushvalue(deltaTime);
+        g_scriptEnv.call(2, 0);
+    }
+}
+
+// Dispatches the Lua ticks collected into s_lua_ticks with one batchcall per distinct tick closure,
+// which is typically one per entity class.  Entities sharing a closure are ticked in gid order.
+static void TickLuaEntitiesBatched(float deltaTime)
+{
+    if (s_lua_ticks.empty()) return;
+
+    std::stable_sort(s_lua_ticks.begin(), s_lua_ticks.end(), [](const TickableEntityItem* lval, const TickableEntityItem* rval) {
+        return lval->lua_tick.m_regkey < rval->lua_tick.m_regkey;
+    });
+
+    auto it     = s_lua_ticks.begin();
+    auto itEnd  = s_lua_ticks.end();
+    while (it != itEnd) {
+        auto regkey = (*it)->lua_tick.m_regkey;
+        g_scriptEnv.batchcall_begin((*it)->lua_tick);
+        for (; it != itEnd && (*it)->lua_tick.m_regkey == regkey; ++it) {
+            const auto& entity = Entity_Lookup((*it)->orderGidPair.Gid());
+            bug_on (!entity.objectptr);
+            g_scriptEnv.batchcall_add(entity.lua_object);
+        }
+        g_scriptEnv.batchcall_end(deltaTime);
+    }
+}
+
 void GameplaySceneLogic(float deltaTime)
 {
     g_drawlist_main.Clear();
+    if (g_settings_app.draw_culling) {
+        g_drawlist_main.SetVisibleArea(g_ViewCamera.GetVisibleArea());
+    }
     g_mouse.update();
 
     {
@@ -113,33 +177,86 @@ void GameplaySceneLogic(float deltaTime)
 
     g_console.DrawFrame();
 
-    for(auto& entitem : g_tickable_entities.ForEachForward())
-    {
-        auto entity = Entity_Lookup(entitem.orderGidPair.Gid());
-        bug_on (!entity.objectptr);
+    // Order buckets are processed in ascending order, and every tick in a bucket completes before the
+    // next bucket begins.  Within a bucket, EntityTick_Parallel items are fanned out across the worker
+    // pool first, followed by the remaining items serially in gid order.  When Lua tick batching is
+    // enabled, Lua-driven items are deferred until after the bucket's native serial ticks and are then
+    // dispatched grouped by class.
+    //
+    // EntityTick_Lod items which aren't due this frame are skipped, and otherwise receive the delta
+    // time accumulated since they last ran.  LOD tiers are taken from the camera position as of the
+    // end of the previous frame.
 
-        if (entitem.Tick) {
-            entitem.Tick(entity.objectptr, entitem.orderGidPair.Order(), deltaTime);
-        }
-        else {
-            // no C++ native tick() binding.  Look up and execute Lua module binding.
-            // [Optimization] Should be able to cache the lua function/table values and avoid looking them up in the registry.
-
-            g_scriptEnv.pushreg(entitem.lua_tick);      // function to call
-            g_scriptEnv.pushreg(entity.lua_object);     // self object (lua table)
-            g_scriptEnv.pushvalue(deltaTime);
-            g_scriptEnv.call(2, 0);
+    EntityComponents_UpdateTickLod(g_ViewCamera.m_Eye.xy, g_ViewCamera.m_frustrum_in_tiles * 0.5f,
+        Scene_GetFrameCount(), deltaTime, g_settings_app.entity_tick_lod
+    );
+
+    {
+        auto entityList = g_tickable_entities.ForEachForward();
+        auto it         = entityList.begin();
+        auto itEnd      = entityList.end();
+
+        while (it != itEnd)
+        {
+            auto order      = it->orderGidPair.Order();
+            auto bucketEnd  = it;
+
+            s_parallel_ticks.clear();
+            for (; bucketEnd != itEnd && bucketEnd->orderGidPair.Order() == order; ++bucketEnd) {
+                if (bucketEnd->flags & EntityTick_Parallel) {
+                    float itemDeltaTime = deltaTime;
+                    if ((bucketEnd->flags & EntityTick_Lod) && !EntityComponents_ResolveTickLod(bucketEnd->orderGidPair.Gid(), itemDeltaTime)) continue;
+                    s_parallel_ticks.push_back({ &*bucketEnd, itemDeltaTime });
+                }
+            }
+
+            if (!s_parallel_ticks.empty()) {
+                g_WorkerPool.ParallelFor((int)s_parallel_ticks.size(), ParallelTickGrainSize, [&](int begin, int end) {
+                    for (int i=begin; i<end; ++i) {
+                        const auto& entitem = *s_parallel_ticks[i].entitem;
+                        const auto& entity  = Entity_Lookup(entitem.orderGidPair.Gid());
+                        bug_on (!entity.objectptr);
+                        entitem.Tick(entity.objectptr, order, s_parallel_ticks[i].deltaTime);
+                    }
+                });
+            }
+
+            bool batchLua = g_settings_app.lua_tick_batching;
+            s_lua_ticks.clear();
+            for (; it != bucketEnd; ++it) {
+                if (it->flags & EntityTick_Parallel) continue;
+                if (batchLua && !it->Tick) {
+                    s_lua_ticks.push_back(&*it);
+                    continue;
+                }
+                float itemDeltaTime = deltaTime;
+                if ((it->flags & EntityTick_Lod) && !EntityComponents_ResolveTickLod(it->orderGidPair.Gid(), itemDeltaTime)) continue;
+                TickEntitySerial(*it, itemDeltaTime);
+            }
+            TickLuaEntitiesBatched(deltaTime);
         }
     }
 
+    EntityComponents_FinishTickLod();
+
+    // Events posted during ticks are delivered in bulk, grouped by target.
+    EntityEvents_DispatchAll();
+
+    // Bulk integration of entities which opted into SoA component storage.
+    EntityComponents_IntegrateMotion   (deltaTime);
+    EntityComponents_AdvanceAnimation  (deltaTime);
+    EntitySpatial_Sync();
+
     // Process messages and modifications which have been submitted to view camera here?
     g_ViewCamera.Tick();
     g_OpenWorld.Tick();
     g_GroundLayerBelow.Tick();
     g_GroundLayerAbove.Tick();
-}
 
-GPU_ConstantBuffer      g_gpu_constbuf;
+    // Draw lists are complete once logic has finished -- order them once here, ahead of render.
+    g_drawlist_main.Sort();
+    g_drawlist_ui.Sort();
+}
 
 void ViewCamera::InitScene()
 {
@@ -197,7 +314,19 @@ void ViewCamera::SetEyeAt(const float2& xy)
     m_At.xy     = xy;
 }
 
-void GameplaySceneRender()
+// Returns the world area in view, in tile coords (xy = min, zw = max), grown by margin tiles on
+// every side.  The margin absorbs objects drawn slightly outside their nominal bounds, and camera
+// movement made by entity ticks after the area was taken.
+float4 ViewCamera::GetVisibleArea(float margin) const
+{
+    float2 halfExtent = (m_frustrum_in_tiles * 0.5f) + margin;
+    return {
+        m_Eye.x - halfExtent.x, m_Eye.y - halfExtent.y,
+        m_Eye.x + halfExtent.x, m_Eye.y + halfExtent.y
+    };
+}
+
+void GameplaySceneRender(SceneFrame& frame)
 {
     if (!s_CanRenderScene) return;
 
@@ -211,29 +340,40 @@ void GameplaySceneRender()
     //g_pImmediateContext->UpdateSubresource(g_pConstantBuffer, 0, nullptr, &cb, 0, 0);
 
     // ------------------------------------------------------------------------------------------
-    // Renders Scene Geometry
+    // Records Scene Geometry
     //
 
-    dx11_SetRasterState(GPU_Fill_Solid, GPU_Cull_None, GPU_Scissor_Disable);
+    auto& setup = frame.lists[SceneFrameList_Setup];
+    setup.SetRasterState(GPU_Fill_Solid, GPU_Cull_None, GPU_Scissor_Disable);
 
     GPU_ViewCameraConsts    m_ViewConsts;
     m_ViewConsts.View       = XMMatrixTranspose(g_ViewCamera.m_Consts.View);
     m_ViewConsts.Projection = XMMatrixTranspose(g_ViewCamera.m_Consts.Projection);
 
-    dx11_UpdateConstantBuffer(g_gpu_constbuf, &m_ViewConsts);
-    dx11_BindConstantBuffer  (g_gpu_constbuf, 0);
-    dx11_SetPrimType(GPU_PRIM_TRIANGLELIST);
-
-    // No Z-depth stencil rejection, so draw layers bottom-up.
+    setup.BindConstants(m_ViewConsts, 0);
+    setup.SetPrimType(GPU_PRIM_TRIANGLELIST);
 
-    g_GroundLayerBelow.Draw();
-    g_GroundLayerAbove.Draw();
+    // Draw list callbacks only feed the sprite batch, so they're run first and serially.  The layers
+    // and the batch are then recorded in parallel, each into its own command list, and replayed in
+    // list order.  No Z-depth stencil rejection, so lists are ordered bottom-up.
 
     for(const auto& entitem : g_drawlist_main.ForEachAlpha())
     {
-        bug_on_qa(!entitem.second.DrawFunc);
-        entitem.second.DrawFunc(entitem.second.ObjectData, entitem.first);
+        bug_on_qa(!entitem.item.DrawFunc);
+        entitem.item.DrawFunc(entitem.item.ObjectData, entitem.zorder);
     }
+
+    g_WorkerPool.ParallelFor(SceneFrameList_Sprites - SceneFrameList_GroundBelow + 1, 1, [&](int begin, int end) {
+        for (int i=begin; i<end; ++i) {
+            int   listId = SceneFrameList_GroundBelow + i;
+            auto& cmds   = frame.lists[listId];
+            switch (listId) {
+                case SceneFrameList_GroundBelow:    g_GroundLayerBelow.Draw(cmds);  break;
+                case SceneFrameList_GroundAbove:    g_GroundLayerAbove.Draw(cmds);  break;
+                case SceneFrameList_Sprites:        SpriteBatch_Flush(cmds);        break;
+            }
+        }
+    });
 }
 
 // Size notes:
@@ -298,8 +438,18 @@ bool Scene_TryLoadInit()
 
     PlayerSprite::LoadStaticAssets();
 
+    // Compile any shaders missing from the shader cache in parallel, ahead of the loads below
+    // (and those in SpriteBatch and TileMapLayer init) which would otherwise compile them one by one.
+    static const GPU_ShaderPrefetch s_sceneShaders[] = {
+        { "Sprite.fx",          "VS", "PS" },
+        { "SpriteInstanced.fx", "VS", "PS" },
+        { "TileMap.fx",         "VS", "PS" },
+    };
+    dx11_PrefetchShaders(s_sceneShaders, bulkof(s_sceneShaders));
+
     dx11_LoadShaderVS(g_ShaderVS_Spriter, "Sprite.fx", "VS");
     dx11_LoadShaderFS(g_ShaderFS_Spriter, "Sprite.fx", "PS");
+    SpriteBatch_InitGlobalResources();
 
     NewStaticEntity(g_ViewCamera);
     NewStaticEntity(g_GroundLayerBelow);
@@ -314,8 +464,7 @@ bool Scene_TryLoadInit()
     auto* player    = NewEntity(PlayerSprite);
 
     g_tickable_entities.Add(player, 10);
-
-    dx11_CreateConstantBuffer(g_gpu_constbuf,       sizeof(GPU_ViewCameraConsts));
+    EntityComponents_Attach(player->m_gid, EntComp_Position);
 
     s_CanRenderScene = 1;
     return true;
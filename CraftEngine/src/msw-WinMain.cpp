@@ -16,6 +16,10 @@
 
 #include "imgui.h"
 
+#if GPU_BACKEND_SOFT
+#   include "x-gpu-soft.h"
+#endif
+
 #include <direct.h>     // for _getcwd()
 
 extern void         LogHostInit();
@@ -661,6 +665,14 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
     Scene_ShutdownThreads();
     dx11_CleanupDevice();
 
+#if GPU_BACKEND_SOFT
+    // non-zero exit code lets automated runs of config-golden-soft.cli.txt fail the build.
+    if (!g_gpu_soft_GoldenImage.IsEmpty() && soft_GetGoldenResult() != SoftGolden_Match) {
+        warn_host("winmain: golden image check did not pass (result=%d)", soft_GetGoldenResult());
+        return 1;
+    }
+#endif
+
     return 0;
 }
 